@@ -252,9 +252,8 @@ void core1_hash_worker()
   // Wait for data from core 0
   core1_hash_data_t *data = (core1_hash_data_t *)multicore_fifo_pop_blocking();
 
-  // Core 1 does hashing and gen_a
+  // Core 1 does gen_a; core0 has already run hash_g on the seed
   const uint8_t *publicseed = data->buf;
-  hash_g(data->buf, data->buf, KYBER_SYMBYTES + 1);
   gen_a(data->a, publicseed);
 
   // Signal completion to core 0
@@ -317,7 +316,11 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
   memcpy(buf, coins, KYBER_SYMBYTES);
   buf[KYBER_SYMBYTES] = KYBER_K;
 
-  // Launch core 1 worker for hashing
+  // core0 samples noise from noiseseed straight away, so hash_g has to be
+  // done before core1 is started; only gen_a runs in parallel
+  hash_g(buf, buf, KYBER_SYMBYTES + 1);
+
+  // Launch core 1 worker for gen_a
   multicore_launch_core1(core1_hash_worker);
 
   // Prepare and send data for core 1
@@ -394,14 +397,14 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
   // Core0 packs secret key in parallel
   pack_sk(sk, &skpv);
 
-  // Securely zeroise 'pkpv' after use
-  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
-  secure_zero(pkpv.vec, sizeof(pkpv.vec));
-
   // Wait for core1
   multicore_fifo_pop_blocking();
   multicore_reset_core1();
 
+  // Securely zeroise 'pkpv' after use
+  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
+  secure_zero(pkpv.vec, sizeof(pkpv.vec));
+
   // Finally, zeroise the secret key
   // memset(skpv.vec, 0, sizeof(skpv.vec));
   secure_zero(skpv.vec, sizeof(skpv.vec));
@@ -1,14 +1,36 @@
 #ifndef API_H
 #define API_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/*
+ * Streaming encapsulation (enc_stream): called with consecutive pieces of
+ * the ciphertext, in order, as each becomes final; the pieces point into
+ * the ct buffer passed to enc_stream.
+ */
+typedef void (*kyber_emit_t)(void *ctx, const uint8_t *bytes, size_t len);
+
+/*
+ * Encapsulation to a public key that arrives in pieces (enc_init,
+ * enc_update, enc_final, or enc_abort to give up) keeps its progress in
+ * a caller-owned state of ENCSTATEBYTES, aligned for uint64_t; kem.h
+ * names its type.
+ *
+ * enc_hpk takes H(pk) (HPKBYTES) from the caller instead of hashing pk;
+ * hash_pk computes it, hpk_seed returns the one keygen kept for a
+ * seed-format key.
+ */
+
 #define pqcrystals_kyber512_SECRETKEYBYTES 1632
 #define pqcrystals_kyber512_PUBLICKEYBYTES 800
 #define pqcrystals_kyber512_CIPHERTEXTBYTES 768
 #define pqcrystals_kyber512_KEYPAIRCOINBYTES 64
 #define pqcrystals_kyber512_ENCCOINBYTES 32
 #define pqcrystals_kyber512_BYTES 32
+#define pqcrystals_kyber512_SEEDSECRETKEYBYTES 64
+#define pqcrystals_kyber512_HPKBYTES 32
+#define pqcrystals_kyber512_ENCSTATEBYTES 1792
 
 #define pqcrystals_kyber512_ref_SECRETKEYBYTES pqcrystals_kyber512_SECRETKEYBYTES
 #define pqcrystals_kyber512_ref_PUBLICKEYBYTES pqcrystals_kyber512_PUBLICKEYBYTES
@@ -16,12 +38,29 @@
 #define pqcrystals_kyber512_ref_KEYPAIRCOINBYTES pqcrystals_kyber512_KEYPAIRCOINBYTES
 #define pqcrystals_kyber512_ref_ENCCOINBYTES pqcrystals_kyber512_ENCCOINBYTES
 #define pqcrystals_kyber512_ref_BYTES pqcrystals_kyber512_BYTES
+#define pqcrystals_kyber512_ref_SEEDSECRETKEYBYTES pqcrystals_kyber512_SEEDSECRETKEYBYTES
+#define pqcrystals_kyber512_ref_HPKBYTES pqcrystals_kyber512_HPKBYTES
+#define pqcrystals_kyber512_ref_ENCSTATEBYTES pqcrystals_kyber512_ENCSTATEBYTES
 
 int pqcrystals_kyber512_ref_keypair_derand(uint8_t *pk, uint8_t *sk, const uint8_t *coins);
 int pqcrystals_kyber512_ref_keypair(uint8_t *pk, uint8_t *sk);
 int pqcrystals_kyber512_ref_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins);
 int pqcrystals_kyber512_ref_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
+int pqcrystals_kyber512_ref_enc_derand_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_enc_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_enc_derand_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_enc_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_hash_pk(uint8_t *hpk, const uint8_t *pk);
+int pqcrystals_kyber512_ref_hpk_seed(uint8_t *hpk, const uint8_t *seedsk);
+int pqcrystals_kyber512_ref_enc_init(void *state);
+int pqcrystals_kyber512_ref_enc_update(void *state, const uint8_t *pk, size_t len);
+int pqcrystals_kyber512_ref_enc_final_derand(uint8_t *ct, uint8_t *ss, void *state, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_enc_final(uint8_t *ct, uint8_t *ss, void *state, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber512_ref_enc_abort(void *state);
 int pqcrystals_kyber512_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+int pqcrystals_kyber512_ref_expand_sk(uint8_t *sk, const uint8_t *seedsk);
+int pqcrystals_kyber512_ref_keypair_seed(uint8_t *pk, uint8_t *seedsk);
+int pqcrystals_kyber512_ref_dec_seed(uint8_t *ss, const uint8_t *ct, const uint8_t *seedsk);
 
 #define pqcrystals_kyber768_SECRETKEYBYTES 2400
 #define pqcrystals_kyber768_PUBLICKEYBYTES 1184
@@ -29,6 +68,9 @@ int pqcrystals_kyber512_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *s
 #define pqcrystals_kyber768_KEYPAIRCOINBYTES 64
 #define pqcrystals_kyber768_ENCCOINBYTES 32
 #define pqcrystals_kyber768_BYTES 32
+#define pqcrystals_kyber768_SEEDSECRETKEYBYTES 64
+#define pqcrystals_kyber768_HPKBYTES 32
+#define pqcrystals_kyber768_ENCSTATEBYTES 2304
 
 #define pqcrystals_kyber768_ref_SECRETKEYBYTES pqcrystals_kyber768_SECRETKEYBYTES
 #define pqcrystals_kyber768_ref_PUBLICKEYBYTES pqcrystals_kyber768_PUBLICKEYBYTES
@@ -36,12 +78,29 @@ int pqcrystals_kyber512_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *s
 #define pqcrystals_kyber768_ref_KEYPAIRCOINBYTES pqcrystals_kyber768_KEYPAIRCOINBYTES
 #define pqcrystals_kyber768_ref_ENCCOINBYTES pqcrystals_kyber768_ENCCOINBYTES
 #define pqcrystals_kyber768_ref_BYTES pqcrystals_kyber768_BYTES
+#define pqcrystals_kyber768_ref_SEEDSECRETKEYBYTES pqcrystals_kyber768_SEEDSECRETKEYBYTES
+#define pqcrystals_kyber768_ref_HPKBYTES pqcrystals_kyber768_HPKBYTES
+#define pqcrystals_kyber768_ref_ENCSTATEBYTES pqcrystals_kyber768_ENCSTATEBYTES
 
 int pqcrystals_kyber768_ref_keypair_derand(uint8_t *pk, uint8_t *sk, const uint8_t *coins);
 int pqcrystals_kyber768_ref_keypair(uint8_t *pk, uint8_t *sk);
 int pqcrystals_kyber768_ref_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins);
 int pqcrystals_kyber768_ref_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
+int pqcrystals_kyber768_ref_enc_derand_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_enc_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_enc_derand_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_enc_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_hash_pk(uint8_t *hpk, const uint8_t *pk);
+int pqcrystals_kyber768_ref_hpk_seed(uint8_t *hpk, const uint8_t *seedsk);
+int pqcrystals_kyber768_ref_enc_init(void *state);
+int pqcrystals_kyber768_ref_enc_update(void *state, const uint8_t *pk, size_t len);
+int pqcrystals_kyber768_ref_enc_final_derand(uint8_t *ct, uint8_t *ss, void *state, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_enc_final(uint8_t *ct, uint8_t *ss, void *state, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber768_ref_enc_abort(void *state);
 int pqcrystals_kyber768_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+int pqcrystals_kyber768_ref_expand_sk(uint8_t *sk, const uint8_t *seedsk);
+int pqcrystals_kyber768_ref_keypair_seed(uint8_t *pk, uint8_t *seedsk);
+int pqcrystals_kyber768_ref_dec_seed(uint8_t *ss, const uint8_t *ct, const uint8_t *seedsk);
 
 #define pqcrystals_kyber1024_SECRETKEYBYTES 3168
 #define pqcrystals_kyber1024_PUBLICKEYBYTES 1568
@@ -49,6 +108,9 @@ int pqcrystals_kyber768_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *s
 #define pqcrystals_kyber1024_KEYPAIRCOINBYTES 64
 #define pqcrystals_kyber1024_ENCCOINBYTES 32
 #define pqcrystals_kyber1024_BYTES 32
+#define pqcrystals_kyber1024_SEEDSECRETKEYBYTES 64
+#define pqcrystals_kyber1024_HPKBYTES 32
+#define pqcrystals_kyber1024_ENCSTATEBYTES 2816
 
 #define pqcrystals_kyber1024_ref_SECRETKEYBYTES pqcrystals_kyber1024_SECRETKEYBYTES
 #define pqcrystals_kyber1024_ref_PUBLICKEYBYTES pqcrystals_kyber1024_PUBLICKEYBYTES
@@ -56,11 +118,28 @@ int pqcrystals_kyber768_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *s
 #define pqcrystals_kyber1024_ref_KEYPAIRCOINBYTES pqcrystals_kyber1024_KEYPAIRCOINBYTES
 #define pqcrystals_kyber1024_ref_ENCCOINBYTES pqcrystals_kyber1024_ENCCOINBYTES
 #define pqcrystals_kyber1024_ref_BYTES pqcrystals_kyber1024_BYTES
+#define pqcrystals_kyber1024_ref_SEEDSECRETKEYBYTES pqcrystals_kyber1024_SEEDSECRETKEYBYTES
+#define pqcrystals_kyber1024_ref_HPKBYTES pqcrystals_kyber1024_HPKBYTES
+#define pqcrystals_kyber1024_ref_ENCSTATEBYTES pqcrystals_kyber1024_ENCSTATEBYTES
 
 int pqcrystals_kyber1024_ref_keypair_derand(uint8_t *pk, uint8_t *sk, const uint8_t *coins);
 int pqcrystals_kyber1024_ref_keypair(uint8_t *pk, uint8_t *sk);
 int pqcrystals_kyber1024_ref_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins);
 int pqcrystals_kyber1024_ref_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
+int pqcrystals_kyber1024_ref_enc_derand_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_enc_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_enc_derand_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_enc_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_hash_pk(uint8_t *hpk, const uint8_t *pk);
+int pqcrystals_kyber1024_ref_hpk_seed(uint8_t *hpk, const uint8_t *seedsk);
+int pqcrystals_kyber1024_ref_enc_init(void *state);
+int pqcrystals_kyber1024_ref_enc_update(void *state, const uint8_t *pk, size_t len);
+int pqcrystals_kyber1024_ref_enc_final_derand(uint8_t *ct, uint8_t *ss, void *state, const uint8_t *coins, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_enc_final(uint8_t *ct, uint8_t *ss, void *state, kyber_emit_t emit, void *ctx);
+int pqcrystals_kyber1024_ref_enc_abort(void *state);
 int pqcrystals_kyber1024_ref_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+int pqcrystals_kyber1024_ref_expand_sk(uint8_t *sk, const uint8_t *seedsk);
+int pqcrystals_kyber1024_ref_keypair_seed(uint8_t *pk, uint8_t *seedsk);
+int pqcrystals_kyber1024_ref_dec_seed(uint8_t *ss, const uint8_t *ct, const uint8_t *seedsk);
 
 #endif
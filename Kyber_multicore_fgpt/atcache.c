@@ -0,0 +1,81 @@
+#include "atcache.h"
+#include <stddef.h>
+#include <string.h>
+#include "indcpa.h"
+#include "profile.h"
+
+#if ATC_ENTRIES > 0
+typedef struct {
+    polyvec at[KYBER_K];
+    uint8_t seed[KYBER_SYMBYTES];
+    uint32_t last_use; /* 0 = empty */
+} atc_entry_t;
+
+_Static_assert(sizeof(atc_entry_t) <= ATC_ENTRY_BYTES, "ATC_ENTRY_BYTES too small");
+
+static atc_entry_t atc[ATC_ENTRIES];
+static uint32_t atc_clock;
+
+const polyvec *atc_reserve(const uint8_t seed[KYBER_SYMBYTES], polyvec **fill)
+{
+    atc_entry_t *e = NULL;
+    atc_entry_t *victim = &atc[0];
+    unsigned int i;
+
+    for (i = 0; i < ATC_ENTRIES; i++)
+    {
+        if (atc[i].last_use && !memcmp(atc[i].seed, seed, KYBER_SYMBYTES))
+        {
+            e = &atc[i];
+            break;
+        }
+        if (atc[i].last_use < victim->last_use)
+            victim = &atc[i];
+    }
+
+    if (e)
+    {
+        enc_prof.at_hits++;
+        e->last_use = ++atc_clock;
+        *fill = NULL;
+    }
+    else
+    {
+        /* Empty until atc_publish(): the matrix is not there yet */
+        e = victim;
+        enc_prof.at_misses++;
+        e->last_use = 0;
+        *fill = e->at;
+    }
+    return e->at;
+}
+
+void atc_publish(const polyvec *at, const uint8_t seed[KYBER_SYMBYTES])
+{
+    atc_entry_t *e = (atc_entry_t *)((const uint8_t *)at - offsetof(atc_entry_t, at));
+
+    memcpy(e->seed, seed, KYBER_SYMBYTES);
+    e->last_use = ++atc_clock;
+}
+
+const polyvec *atc_get(const uint8_t seed[KYBER_SYMBYTES])
+{
+    polyvec *fill;
+    const polyvec *at = atc_reserve(seed, &fill);
+
+    if (fill)
+    {
+        gen_matrix(fill, seed, 1);
+        atc_publish(at, seed);
+    }
+    return at;
+}
+#endif
+
+void atc_clear(void)
+{
+#if ATC_ENTRIES > 0
+    memset(atc, 0, sizeof(atc));
+    atc_clock = 0;
+#endif
+}
@@ -0,0 +1,72 @@
+#ifndef ATCACHE_H
+#define ATCACHE_H
+
+#include <stdint.h>
+#include "params.h"
+#include "polyvec.h"
+
+/*
+ * Cache of expanded public matrices A^T, keyed by the 32-byte public seed.
+ *
+ * gen_at is the largest single step of indcpa_enc, and it is repeated
+ * unchanged whenever the same public key is used again: every
+ * decapsulation re-encrypts under the key's own pk, and encapsulating to
+ * a known peer reuses the peer's pk. indcpa_enc takes the matrix from
+ * atc_get(), so callers get the cache without changing anything. A hit
+ * skips the expansion (enc_prof.gen_at only sees the lookup). A miss
+ * expands into the least recently used entry.
+ *
+ * The capacity is a byte budget, ATC_BYTES, and holds as many whole
+ * entries as fit for the build's KYBER_K (16 KiB: 7 entries at K=2, 3 at
+ * K=3, 1 at K=4). ATC_BYTES=0 disables the cache; indcpa_enc then expands
+ * into its workspace as before. Hits and misses are counted in enc_prof.
+ *
+ * With KYBER_ALL_K the cache is compiled once per K, and the three share
+ * the one budget: each holds as many entries as fit once for every K
+ * (16 KiB: 1 entry each, 14956 bytes in all), instead of each taking
+ * ATC_BYTES for itself.
+ *
+ * Everything cached is public, so seeds are compared with memcmp and the
+ * entries are not zeroised. Core0 only; an entry handed out is not
+ * evicted before the next atc_get(), atc_reserve() or atc_clear().
+ *
+ * An entry claimed on a miss stays empty (never a hit) until
+ * atc_publish() records its seed once the matrix is complete, so an
+ * expansion that is abandoned part-way leaves nothing behind.
+ */
+
+#ifndef ATC_BYTES
+#define ATC_BYTES (16 * 1024)
+#endif
+
+/* Bytes per entry: the matrix, the seed and the LRU stamp */
+#define ATC_ENTRY_BYTES_K(k) ((k) * (k) * KYBER_N * 2 + KYBER_SYMBYTES + 4)
+#define ATC_ENTRY_BYTES ATC_ENTRY_BYTES_K(KYBER_K)
+#ifdef KYBER_ALL_K
+#define ATC_ENTRIES (ATC_BYTES / (ATC_ENTRY_BYTES_K(2) + ATC_ENTRY_BYTES_K(3) + ATC_ENTRY_BYTES_K(4)))
+#else
+#define ATC_ENTRIES (ATC_BYTES / ATC_ENTRY_BYTES)
+#endif
+
+#if ATC_ENTRIES > 0
+/* A^T for seed, expanded on a miss */
+#define atc_get KYBER_NAMESPACE(atc_get)
+const polyvec *atc_get(const uint8_t seed[KYBER_SYMBYTES]);
+
+/* atc_get without the expansion: on a miss the least recently used entry
+   is emptied and *fill set to it, to be expanded (gen_at) and then
+   published; NULL on a hit. Lets the expansion run on core1
+   (indcpa_pk_absorb). */
+#define atc_reserve KYBER_NAMESPACE(atc_reserve)
+const polyvec *atc_reserve(const uint8_t seed[KYBER_SYMBYTES], polyvec **fill);
+
+/* Makes the entry at, now holding the expansion of seed, a hit */
+#define atc_publish KYBER_NAMESPACE(atc_publish)
+void atc_publish(const polyvec *at, const uint8_t seed[KYBER_SYMBYTES]);
+#endif
+
+/* Drops every entry */
+#define atc_clear KYBER_NAMESPACE(atc_clear)
+void atc_clear(void);
+
+#endif
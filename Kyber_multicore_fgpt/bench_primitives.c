@@ -0,0 +1,488 @@
+/*
+ * Per-primitive microbenchmarks.
+ *
+ * Each kernel is run in isolation on fixed pseudo-random inputs: first
+ * BENCH_WARMUP untimed calls (fills the XIP cache and branch predictors),
+ * then BENCH_SAMPLES timed samples of BENCH_BATCH back-to-back calls each.
+ * A batch is needed because time_us_64() only has microsecond resolution
+ * and the smaller kernels take well under that. Results are reported per
+ * call, in nanoseconds and in clk_sys cycles.
+ *
+ * Every kernel is timed twice: with core1 idle, and with core1 looping
+ * over gen_matrix and the NTT on its own buffers. The second pass is where
+ * XIP placement hurts, since the two cores then fetch different code
+ * through the shared cache. bench_primitives runs the kernels from flash,
+ * and bench_primitives_ram is the same program built with
+ * KYBER_RAM_KERNELS (see ramfunc.h); tools/kernel_placement.py compares
+ * the two logs kernel by kernel.
+ *
+ * The whole table is repeated for every kernel backend (kernels.h) this
+ * CPU supports and that passes the self-test, in the "backend" column;
+ * the board has only ref. The backend is switched between passes, with
+ * the core1 load stopped.
+ *
+ * The compression kernels are checked bit for bit against the reference
+ * formulas over all of [0, q) before anything is timed, and the
+ * reference's 64-bit polyvec_compress is timed next to the 32-bit one
+ * ("polyvec_compress_ref64") for comparison.
+ *
+ * The CSV block uses the same marker lines and metadata prefix as
+ * test_kyber_separate_deviations.c, so the same tooling can collect it.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "pico/stdio_usb.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "pico/multicore.h"
+#include "hardware/clocks.h"
+#include "params.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "ntt.h"
+#include "cbd.h"
+#include "indcpa.h"
+#include "fips202.h"
+#include "verify.h"
+#include "compress.h"
+#include "kernels.h"
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 64
+#endif
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 201
+#endif
+#ifndef BENCH_BATCH
+#define BENCH_BATCH 32
+#endif
+
+/* gen_matrix is three orders of magnitude slower than the rest */
+#define BENCH_BATCH_SLOW 1
+
+#ifndef KYBER_VARIANT
+#define KYBER_VARIANT "unknown"
+#endif
+#ifndef KYBER_CFLAGS
+#define KYBER_CFLAGS ""
+#endif
+
+#ifdef KYBER_RAM_KERNELS
+#define BENCH_PLACEMENT "ram"
+#else
+#define BENCH_PLACEMENT "xip"
+#endif
+
+/* ================= INPUTS ================= */
+
+static poly pa, pb, pr;
+static polyvec va, vb;
+static polyvec mat[KYBER_K];
+static uint8_t seed[KYBER_SYMBYTES];
+static uint8_t noise_buf[3 * KYBER_N / 4];
+static uint8_t rej_buf[504]; /* 3 SHAKE128 blocks, as the first gen_matrix call */
+static uint8_t msg[KYBER_INDCPA_MSGBYTES];
+static uint8_t polycomp[KYBER_POLYCOMPRESSEDBYTES];
+static uint8_t vecomp[KYBER_POLYVECCOMPRESSEDBYTES];
+static uint8_t ct_a[KYBER_INDCPA_BYTES];
+static uint8_t ct_b[KYBER_INDCPA_BYTES];
+static uint64_t keccak[25];
+
+static volatile unsigned int sink;
+
+/* xorshift32; fixed seed so every build sees the same inputs */
+static uint32_t bench_rng = 0x2545f491u;
+
+static uint32_t bench_rand(void)
+{
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng;
+}
+
+static void fill_bytes(uint8_t *p, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        p[i] = (uint8_t)bench_rand();
+}
+
+static void fill_poly(poly *p)
+{
+    unsigned int i;
+    for (i = 0; i < KYBER_N; i++)
+        p->coeffs[i] = (int16_t)(bench_rand() % KYBER_Q);
+}
+
+static void bench_inputs_init(void)
+{
+    unsigned int i;
+
+    fill_poly(&pa);
+    fill_poly(&pb);
+    for (i = 0; i < KYBER_K; i++)
+    {
+        fill_poly(&va.vec[i]);
+        fill_poly(&vb.vec[i]);
+    }
+    fill_bytes(seed, sizeof(seed));
+    fill_bytes(noise_buf, sizeof(noise_buf));
+    fill_bytes(rej_buf, sizeof(rej_buf));
+    fill_bytes(msg, sizeof(msg));
+    fill_bytes(ct_a, sizeof(ct_a));
+    memcpy(ct_b, ct_a, sizeof(ct_b));
+    memset(keccak, 0, sizeof(keccak));
+}
+
+/* ================= KERNELS ================= */
+
+/*
+ * ntt/invntt run in place; the input is restored from pa before each call
+ * so coefficients stay in range however many iterations run. The copy is
+ * timed as well and is reported separately as "copy_poly" for subtraction.
+ */
+static void b_copy_poly(void)
+{
+    pr = pa;
+}
+
+static void b_ntt(void)
+{
+    pr = pa;
+    kyber_kernels.ntt_forward(pr.coeffs);
+}
+
+static void b_invntt(void)
+{
+    pr = pa;
+    kyber_kernels.ntt_inverse(pr.coeffs);
+}
+
+static void b_poly_basemul(void)
+{
+    poly_basemul_montgomery(&pr, &pa, &pb);
+}
+
+static void b_polyvec_basemul_acc(void)
+{
+    polyvec_basemul_acc_montgomery(&pr, &va, &vb);
+}
+
+static void b_cbd2(void)
+{
+    kyber_kernels.sample_cbd2(&pr, noise_buf);
+}
+
+static void b_cbd3(void)
+{
+    kyber_kernels.sample_cbd3(&pr, noise_buf);
+}
+
+static void b_rej_uniform(void)
+{
+    sink = rej_uniform(pr.coeffs, KYBER_N, rej_buf, sizeof(rej_buf));
+}
+
+static void b_gen_matrix(void)
+{
+    gen_matrix(mat, seed, 0);
+}
+
+static void b_keccakf1600(void)
+{
+    kyber_kernels.keccakf1600(keccak);
+}
+
+static void b_poly_compress(void)
+{
+    poly_compress(polycomp, &pa);
+}
+
+static void b_polyvec_compress(void)
+{
+    polyvec_compress(vecomp, &va);
+}
+
+static void b_poly_decompress(void)
+{
+    poly_decompress(&pr, polycomp);
+}
+
+static void b_polyvec_decompress(void)
+{
+    polyvec_decompress(&va, vecomp);
+}
+
+/* polyvec_compress as in the reference, with 64-bit products */
+static void polyvec_compress_ref64(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+{
+    unsigned int i, j, k;
+    uint64_t d0;
+    uint16_t t[8];
+
+    for (i = 0; i < KYBER_K; i++)
+    {
+        for (j = 0; j < KYBER_N / 8; j++)
+        {
+            for (k = 0; k < 8; k++)
+            {
+                t[k] = (uint16_t)compress_csubq(a->vec[i].coeffs[8 * j + k]);
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+                d0 = ((uint64_t)t[k] << 11) + 1664;
+                d0 = (d0 * 645084) >> 31;
+                t[k] = d0 & 0x7ff;
+#else
+                d0 = ((uint64_t)t[k] << 10) + 1665;
+                d0 = (d0 * 1290167) >> 32;
+                t[k] = d0 & 0x3ff;
+#endif
+            }
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+            r[0] = (t[0] >> 0);
+            r[1] = (t[0] >> 8) | (t[1] << 3);
+            r[2] = (t[1] >> 5) | (t[2] << 6);
+            r[3] = (t[2] >> 2);
+            r[4] = (t[2] >> 10) | (t[3] << 1);
+            r[5] = (t[3] >> 7) | (t[4] << 4);
+            r[6] = (t[4] >> 4) | (t[5] << 7);
+            r[7] = (t[5] >> 1);
+            r[8] = (t[5] >> 9) | (t[6] << 2);
+            r[9] = (t[6] >> 6) | (t[7] << 5);
+            r[10] = (t[7] >> 3);
+            r += 11;
+#else
+            for (k = 0; k < 8; k += 4)
+            {
+                r[0] = (t[k] >> 0);
+                r[1] = (t[k] >> 8) | (t[k + 1] << 2);
+                r[2] = (t[k + 1] >> 6) | (t[k + 2] << 4);
+                r[3] = (t[k + 2] >> 4) | (t[k + 3] << 6);
+                r[4] = (t[k + 3] >> 2);
+                r += 5;
+            }
+#endif
+        }
+    }
+}
+
+static void b_polyvec_compress_ref64(void)
+{
+    polyvec_compress_ref64(vecomp, &va);
+}
+
+/*
+ * Bit-exactness of the 32-bit compression: every scalar kernel against the
+ * division it replaces over all of [0, q), and the packed polyvec output
+ * against the 64-bit reference on the benchmark inputs. Returns the number
+ * of mismatches.
+ */
+static unsigned int compress_selfcheck(void)
+{
+    static uint8_t ref[KYBER_POLYVECCOMPRESSEDBYTES];
+    unsigned int bad = 0;
+    uint32_t x;
+
+    for (x = 0; x < KYBER_Q; x++)
+    {
+        bad += compress_d4(x) != ((((x << 4) + KYBER_Q / 2) / KYBER_Q) & 0xf);
+        bad += compress_d5(x) != ((((x << 5) + KYBER_Q / 2) / KYBER_Q) & 0x1f);
+        bad += compress_d10(x) != ((((x << 10) + KYBER_Q / 2) / KYBER_Q) & 0x3ff);
+        bad += compress_d11(x) != ((((x << 11) + KYBER_Q / 2) / KYBER_Q) & 0x7ff);
+    }
+
+    polyvec_compress(vecomp, &va);
+    polyvec_compress_ref64(ref, &va);
+    bad += memcmp(vecomp, ref, sizeof(ref)) != 0;
+    return bad;
+}
+
+static void b_poly_tomsg(void)
+{
+    poly_tomsg(msg, &pa);
+}
+
+static void b_poly_frommsg(void)
+{
+    poly_frommsg(&pr, msg);
+}
+
+/* verify/cmov over a full ciphertext, as in crypto_kem_dec */
+static void b_verify(void)
+{
+    sink = (unsigned int)verify(ct_a, ct_b, sizeof(ct_a));
+}
+
+static void b_cmov(void)
+{
+    cmov(ct_a, ct_b, sizeof(ct_a), 1);
+}
+
+typedef struct
+{
+    const char *name;
+    void (*fn)(void);
+    unsigned int batch;
+} bench_t;
+
+static const bench_t benches[] = {
+    {"copy_poly", b_copy_poly, BENCH_BATCH},
+    {"ntt", b_ntt, BENCH_BATCH},
+    {"invntt", b_invntt, BENCH_BATCH},
+    {"poly_basemul_montgomery", b_poly_basemul, BENCH_BATCH},
+    {"polyvec_basemul_acc_montgomery", b_polyvec_basemul_acc, BENCH_BATCH},
+    {"cbd2", b_cbd2, BENCH_BATCH},
+    {"cbd3", b_cbd3, BENCH_BATCH},
+    {"rej_uniform", b_rej_uniform, BENCH_BATCH},
+    {"gen_matrix", b_gen_matrix, BENCH_BATCH_SLOW},
+    {"KeccakF1600_StatePermute", b_keccakf1600, BENCH_BATCH},
+    {"poly_compress", b_poly_compress, BENCH_BATCH},
+    {"polyvec_compress", b_polyvec_compress, BENCH_BATCH},
+    {"polyvec_compress_ref64", b_polyvec_compress_ref64, BENCH_BATCH},
+    {"poly_decompress", b_poly_decompress, BENCH_BATCH},
+    {"polyvec_decompress", b_polyvec_decompress, BENCH_BATCH},
+    {"poly_tomsg", b_poly_tomsg, BENCH_BATCH},
+    {"poly_frommsg", b_poly_frommsg, BENCH_BATCH},
+    {"verify", b_verify, BENCH_BATCH},
+    {"cmov", b_cmov, BENCH_BATCH},
+};
+
+/* ================= CORE1 LOAD ================= */
+
+static polyvec bg_mat[KYBER_K];
+static volatile int bg_stop;
+
+static void core1_load(void)
+{
+    while (!bg_stop)
+    {
+        gen_matrix(bg_mat, seed, 1);
+        polyvec_ntt(&bg_mat[0]);
+    }
+    multicore_fifo_push_blocking(0);
+}
+
+static void core1_load_start(void)
+{
+    bg_stop = 0;
+    multicore_launch_core1(core1_load);
+}
+
+static void core1_load_stop(void)
+{
+    bg_stop = 1;
+    multicore_fifo_pop_blocking();
+    multicore_reset_core1();
+}
+
+/* ================= DRIVER ================= */
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct
+{
+    uint64_t min_ns;
+    uint64_t p50_ns;
+    uint64_t max_ns;
+    double mean_ns;
+} bench_result_t;
+
+static void run_bench(const bench_t *b, bench_result_t *res)
+{
+    static uint64_t samples[BENCH_SAMPLES];
+    uint64_t t0, t1;
+    double sum = 0.0;
+    unsigned int i, j;
+
+    for (i = 0; i < BENCH_WARMUP; i++)
+        b->fn();
+
+    for (i = 0; i < BENCH_SAMPLES; i++)
+    {
+        t0 = time_us_64();
+        for (j = 0; j < b->batch; j++)
+            b->fn();
+        t1 = time_us_64();
+        samples[i] = (t1 - t0) * 1000u / b->batch;
+        sum += (double)samples[i];
+    }
+
+    qsort(samples, BENCH_SAMPLES, sizeof(samples[0]), cmp_u64);
+    res->min_ns = samples[0];
+    res->p50_ns = samples[BENCH_SAMPLES / 2];
+    res->max_ns = samples[BENCH_SAMPLES - 1];
+    res->mean_ns = sum / BENCH_SAMPLES;
+}
+
+int main(void)
+{
+    const size_t nbench = sizeof(benches) / sizeof(benches[0]);
+    bench_result_t res;
+    uint32_t clock_khz;
+    size_t i;
+    unsigned int backend;
+    int busy;
+
+    stdio_init_all();
+    stdio_usb_init();
+    while (!stdio_usb_connected())
+        sleep_ms(100);
+    sleep_ms(5000);
+
+    clock_khz = clock_get_hz(clk_sys) / 1000;
+    bench_inputs_init();
+
+    printf("Kyber primitive benchmarks (KYBER_K=%d, clk_sys %" PRIu32 " kHz, kernels in %s)\n",
+           KYBER_K, clock_khz, BENCH_PLACEMENT);
+    printf("warm-up %d, %d samples of %d calls (gen_matrix: %d)\n",
+           BENCH_WARMUP, BENCH_SAMPLES, BENCH_BATCH, BENCH_BATCH_SLOW);
+    printf("compress self-check: %u mismatches\n", compress_selfcheck());
+    printf("kernel backends on %s:", kernels_cpu());
+    for (backend = 0; backend < kernels_backend_count; backend++)
+        printf(" %s (%s)", kernels_backends[backend]->name,
+               !kernels_supported(kernels_backends[backend]) ? "unsupported"
+               : kernels_selftest(kernels_backends[backend]) ? "self-test FAIL" : "ok");
+    printf("\n\n");
+
+    printf("=== BENCH PRIMITIVES BEGIN ===\n");
+    printf("variant,kyber_k,clock_khz,compiler,cflags,placement,backend,core1,primitive,samples,"
+           "batch,min_ns,p50_ns,mean_ns,max_ns,p50_cycles\n");
+    for (backend = 0; backend < kernels_backend_count; backend++)
+    {
+        if (kernels_use(kernels_backends[backend]->name))
+            continue;
+
+        for (busy = 0; busy <= 1; busy++)
+        {
+            if (busy)
+                core1_load_start();
+
+            for (i = 0; i < nbench; i++)
+            {
+                run_bench(&benches[i], &res);
+                printf("%s,%d,%" PRIu32 ",\"%s\",\"%s\",%s,%s,%s,%s,%d,%u,%" PRIu64 ",%" PRIu64
+                       ",%.1f,%" PRIu64 ",%" PRIu64 "\n",
+                       KYBER_VARIANT, KYBER_K, clock_khz, __VERSION__, KYBER_CFLAGS,
+                       BENCH_PLACEMENT, kyber_kernels.name, busy ? "busy" : "idle",
+                       benches[i].name, BENCH_SAMPLES, benches[i].batch,
+                       res.min_ns, res.p50_ns, res.mean_ns, res.max_ns,
+                       res.p50_ns * clock_khz / 1000000u);
+            }
+
+            if (busy)
+                core1_load_stop();
+        }
+    }
+    kernels_init();
+    printf("=== BENCH PRIMITIVES END ===\n");
+
+    return 0;
+}
@@ -4,11 +4,33 @@
 #include <stdint.h>
 #include "params.h"
 #include "poly.h"
+#include "kernels.h"
 
-#define poly_cbd_eta1 KYBER_NAMESPACE(poly_cbd_eta1)
-void poly_cbd_eta1(poly *r, const uint8_t buf[KYBER_ETA1*KYBER_N/4]);
+/* cbd2 and cbd3 do not depend on KYBER_K; the eta wrappers pick the active backend's one for it */
+#define cbd2 KYBER_COMMON_NAMESPACE(cbd2)
+void cbd2(poly *r, const uint8_t buf[2*KYBER_N/4]);
 
-#define poly_cbd_eta2 KYBER_NAMESPACE(poly_cbd_eta2)
-void poly_cbd_eta2(poly *r, const uint8_t buf[KYBER_ETA2*KYBER_N/4]);
+#define cbd3 KYBER_COMMON_NAMESPACE(cbd3)
+void cbd3(poly *r, const uint8_t buf[3*KYBER_N/4]);
+
+static inline void poly_cbd_eta1(poly *r, const uint8_t buf[KYBER_ETA1*KYBER_N/4])
+{
+#if KYBER_ETA1 == 2
+  kyber_kernels.sample_cbd2(r, buf);
+#elif KYBER_ETA1 == 3
+  kyber_kernels.sample_cbd3(r, buf);
+#else
+#error "This implementation requires eta1 in {2,3}"
+#endif
+}
+
+static inline void poly_cbd_eta2(poly *r, const uint8_t buf[KYBER_ETA2*KYBER_N/4])
+{
+#if KYBER_ETA2 == 2
+  kyber_kernels.sample_cbd2(r, buf);
+#else
+#error "This implementation requires eta2 = 2"
+#endif
+}
 
 #endif
@@ -0,0 +1,70 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+#include <string.h>
+#include "params.h"
+
+/*
+ * Scalar compression Compress_q(x, d) = round(x * 2^d / q) mod 2^d for
+ * x in [0, q), with 32-bit arithmetic only.
+ *
+ * The reference computes d = 10 and d = 11 with 64-bit products. The
+ * Cortex-M0+ in the RP2040 has no long multiply, so each of those
+ * coefficients costs an __aeabi_lmul call. Here every d uses one 32x32->32
+ * multiply and a shift. For d = 4 and d = 5 the reference constants are
+ * kept; the product wraps, but only into bits the mask drops. For d = 10
+ * and d = 11, x * 645084 stays below 2^31 and the rounding offset was
+ * chosen so the result is bit-exact with the reference for every
+ * x in [0, q) (bench_primitives re-checks this at start-up).
+ */
+
+/* Maps a coefficient in (-q, q) to its standard representative in [0, q) */
+static inline uint32_t compress_csubq(int16_t a)
+{
+  a += (a >> 15) & KYBER_Q;
+  return (uint16_t)a;
+}
+
+static inline uint32_t compress_d4(uint32_t x)
+{
+  return (((x << 4) + 1665) * 80635 >> 28) & 0xf;
+}
+
+static inline uint32_t compress_d5(uint32_t x)
+{
+  return (((x << 5) + 1664) * 40318 >> 27) & 0x1f;
+}
+
+static inline uint32_t compress_d10(uint32_t x)
+{
+  return ((x * 645084 + 1048080) >> 21) & 0x3ff;
+}
+
+static inline uint32_t compress_d11(uint32_t x)
+{
+  return ((x * 645084 + 523792) >> 20) & 0x7ff;
+}
+
+/*
+ * The packers build each group of 8 coefficients in 32-bit words and store
+ * them whole. Both targets and the host are little-endian, so a word store
+ * gives the byte order of the specification. The output is not word
+ * aligned in general; memcpy lets the compiler use a plain str on the
+ * Cortex-M33 and fall back to byte stores where unaligned access faults.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "compress.h word stores assume a little-endian target"
+#endif
+
+static inline void store32_le(uint8_t *r, uint32_t w)
+{
+  memcpy(r, &w, sizeof(w));
+}
+
+static inline void store16_le(uint8_t *r, uint16_t w)
+{
+  memcpy(r, &w, sizeof(w));
+}
+
+#endif
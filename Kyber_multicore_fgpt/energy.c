@@ -0,0 +1,139 @@
+#include "energy.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/time.h"
+#include "hardware/clocks.h"
+
+static uint64_t win_start;
+static uint64_t win_core0_blocked;
+static uint64_t win_core1_active;
+
+void energy_coeffs(energy_coeffs_t *c)
+{
+    double scale;
+
+    c->clock_khz = clock_get_hz(clk_sys) / 1000;
+    scale = c->clock_khz / (double)ENERGY_FIT_CLOCK_KHZ;
+
+    c->base_mw = ENERGY_BASE_MW;
+    c->core_mw[0] = ENERGY_CORE0_MW * scale;
+    c->core_mw[1] = ENERGY_CORE1_MW * scale;
+}
+
+void energy_apply(const energy_coeffs_t *c, energy_part_t *p)
+{
+    p->uj = (c->base_mw * p->wall_us +
+             c->core_mw[0] * p->active_us[0] +
+             c->core_mw[1] * p->active_us[1]) / 1000.0;
+}
+
+void energy_estimate(const energy_coeffs_t *c, prof_op_t op, double op_us, int runs,
+                     energy_part_t parts[ENERGY_PARTS])
+{
+    energy_part_t *serial = &parts[ENERGY_PART_SERIAL];
+    energy_part_t *total = &parts[ENERGY_PART_TOTAL];
+    int ph;
+
+    memset(parts, 0, ENERGY_PARTS * sizeof(parts[0]));
+    serial->wall_us = op_us;
+
+    for (ph = 0; ph < PROF_PHASE_COUNT; ph++) {
+        const sched_profile_t *s = &sched_prof[op][ph];
+        energy_part_t *p = &parts[ph];
+
+        p->wall_us = s->wall / (double)runs;
+        p->active_us[0] = p->wall_us - s->core0_blocked / (double)runs;
+        p->active_us[1] = s->core1_active / (double)runs;
+        serial->wall_us -= p->wall_us;
+    }
+
+    /* between phases core1 is held in reset and core0 does the work */
+    if (serial->wall_us < 0)
+        serial->wall_us = 0;
+    serial->active_us[0] = serial->wall_us;
+
+    for (ph = 0; ph <= ENERGY_PART_SERIAL; ph++) {
+        energy_apply(c, &parts[ph]);
+        total->wall_us += parts[ph].wall_us;
+        total->active_us[0] += parts[ph].active_us[0];
+        total->active_us[1] += parts[ph].active_us[1];
+        total->uj += parts[ph].uj;
+    }
+}
+
+static void sched_totals(uint64_t *core0_blocked, uint64_t *core1_active)
+{
+    int op, ph;
+
+    *core0_blocked = *core1_active = 0;
+    for (op = 0; op < PROF_OP_COUNT; op++) {
+        for (ph = 0; ph < PROF_PHASE_COUNT; ph++) {
+            *core0_blocked += sched_prof[op][ph].core0_blocked;
+            *core1_active += sched_prof[op][ph].core1_active;
+        }
+    }
+}
+
+void energy_window_begin(void)
+{
+    sched_totals(&win_core0_blocked, &win_core1_active);
+    win_start = time_us_64();
+}
+
+void energy_window_end(energy_part_t *w)
+{
+    uint64_t end = time_us_64();
+    uint64_t core0_blocked, core1_active;
+
+    sched_totals(&core0_blocked, &core1_active);
+    w->wall_us = (double)(end - win_start);
+    w->active_us[0] = w->wall_us - (double)(core0_blocked - win_core0_blocked);
+    w->active_us[1] = (double)(core1_active - win_core1_active);
+    w->uj = 0;
+}
+
+static void print_part(const char *op, const char *part, const energy_part_t *p, double total_uj)
+{
+    printf("%s,%s,%.2f,%.2f,%.2f,%.2f,%.2f\n", op, part,
+           p->wall_us, p->active_us[0], p->active_us[1], p->uj,
+           total_uj > 0 ? 100.0 * p->uj / total_uj : 0.0);
+}
+
+void energy_print(int runs, const double op_us[PROF_OP_COUNT], const energy_part_t *w)
+{
+    energy_coeffs_t c;
+    energy_part_t parts[ENERGY_PARTS];
+    int op, ph;
+
+    energy_coeffs(&c);
+
+    printf("\n# ENERGY\n");
+    printf("base_mw,core0_mw,core1_mw,fit_clock_khz,clock_khz,calibrated\n");
+    printf("%.3f,%.3f,%.3f,%d,%" PRIu32 ",%d\n", c.base_mw, c.core_mw[0], c.core_mw[1],
+           (int)ENERGY_FIT_CLOCK_KHZ, c.clock_khz, (int)ENERGY_CALIBRATED);
+
+    printf("op,part,wall_us,core0_active_us,core1_active_us,est_uj,percent\n");
+    for (op = 0; op < PROF_OP_COUNT; op++) {
+        double total_uj;
+
+        energy_estimate(&c, (prof_op_t)op, op_us[op], runs, parts);
+        total_uj = parts[ENERGY_PART_TOTAL].uj;
+
+        for (ph = 0; ph < PROF_PHASE_COUNT; ph++) {
+            if (sched_prof[op][ph].jobs == 0)
+                continue;
+            print_part(prof_op_names[op], prof_phase_names[ph], &parts[ph], total_uj);
+        }
+        print_part(prof_op_names[op], "serial", &parts[ENERGY_PART_SERIAL], total_uj);
+        print_part(prof_op_names[op], "total", &parts[ENERGY_PART_TOTAL], total_uj);
+    }
+
+    /* whole GPIO window, the row tools/energy_model.py pairs with the rig */
+    if (w) {
+        energy_part_t win = *w;
+
+        energy_apply(&c, &win);
+        print_part("window", "total", &win, win.uj);
+    }
+}
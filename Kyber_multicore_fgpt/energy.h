@@ -0,0 +1,96 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+#include "profile.h"
+
+/*
+ * Energy estimate from the scheduler profile, without the INA219 rig.
+ *
+ * Board power is modelled as a constant part plus one increment per core
+ * while that core computes:
+ *
+ *     P = base + core0 * [core0 active] + core1 * [core1 active]
+ *
+ * base covers the board, the regulator and the RP2350 with both cores
+ * clocked but idle, so the per-core idle power is folded into it. Core0
+ * counts as active except while it is blocked on core1's result; core1
+ * counts as active from taking a job to finishing it, and is idle (held in
+ * reset or waiting for a descriptor) the rest of the time. Both come from
+ * sched_prof, so every harness run reports energy alongside time.
+ *
+ * The coefficients are fitted once against the INA219 rig with
+ * tools/energy_model.py calibrate and passed in as -D flags (the
+ * KYBER_ENERGY_COEFFS CMake option). Dynamic power scales with the clock,
+ * so the core increments are rescaled from ENERGY_FIT_CLOCK_KHZ to the
+ * current clk_sys; base is not. The defaults below are round placeholders
+ * for a Pico 2 W at 150 MHz, not measurements: the report prints
+ * calibrated=0 until real coefficients are supplied.
+ */
+
+#ifndef ENERGY_BASE_MW
+#define ENERGY_BASE_MW 95.0
+#endif
+
+#ifndef ENERGY_CORE0_MW
+#define ENERGY_CORE0_MW 12.0
+#endif
+
+#ifndef ENERGY_CORE1_MW
+#define ENERGY_CORE1_MW 12.0
+#endif
+
+#ifndef ENERGY_FIT_CLOCK_KHZ
+#define ENERGY_FIT_CLOCK_KHZ 150000
+#endif
+
+/* Core voltage during calibration; powerpolicy.c scales the increments by V^2 */
+#ifndef ENERGY_FIT_MV
+#define ENERGY_FIT_MV 1100
+#endif
+
+#ifndef ENERGY_CALIBRATED
+#define ENERGY_CALIBRATED 0
+#endif
+
+typedef struct {
+    double base_mw;
+    double core_mw[2];    /* active increments at clock_khz */
+    uint32_t clock_khz;
+} energy_coeffs_t;
+
+typedef struct {
+    double wall_us;
+    double active_us[2];  /* per core */
+    double uj;
+} energy_part_t;
+
+/* One part per parallel phase, then the serial remainder, then the total */
+#define ENERGY_PART_SERIAL PROF_PHASE_COUNT
+#define ENERGY_PART_TOTAL  (PROF_PHASE_COUNT + 1)
+#define ENERGY_PARTS       (PROF_PHASE_COUNT + 2)
+
+/* Compiled-in coefficients rescaled to the current system clock */
+void energy_coeffs(energy_coeffs_t *c);
+
+/* Fills p->uj from its activity; 1 mW for 1 us is 1 nJ */
+void energy_apply(const energy_coeffs_t *c, energy_part_t *p);
+
+/*
+ * Splits the average op_us of one KEM operation over its parallel phases
+ * and the serial code between them, from runs calls' worth of sched_prof
+ */
+void energy_estimate(const energy_coeffs_t *c, prof_op_t op, double op_us, int runs,
+                     energy_part_t parts[ENERGY_PARTS]);
+
+/*
+ * Measurement window matching the GPIO pulse the INA219 rig integrates
+ * over: begin snapshots sched_prof, end fills w with the totals since
+ */
+void energy_window_begin(void);
+void energy_window_end(energy_part_t *w);
+
+/* "# ENERGY" CSV block: per op and phase, then the window if w is set */
+void energy_print(int runs, const double op_us[PROF_OP_COUNT], const energy_part_t *w);
+
+#endif
@@ -15,15 +15,11 @@
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "profile.h"
-
-
-// Volatile pointer zeroisation
-void secure_zero(void *v, size_t n)
-{
-  volatile uint8_t *p = (volatile uint8_t *)v;
-  while (n--)
-    *p++ = 0;
-}
+#include "trace.h"
+#include "workspace.h"
+#include "ramfunc.h"
+#include "verify.h"
+#include "atcache.h"
 
 typedef struct
 {
@@ -43,17 +39,21 @@ typedef struct
 typedef struct
 {
   uint8_t *pk;
+  uint8_t *hpk;
   polyvec *pkpv;
   const uint8_t *publicseed;
 } core1_pack_data_t;
 
 typedef struct
 {
-  polyvec *at; // input array
-  polyvec *b;  // output array
-  polyvec *sp; // secret vector
+  const polyvec *at;  // transposed matrix
+  const polyvec *sp;  // secret vector
+  const polyvec *ep;  // error vector
+  uint8_t *c;         // output ciphertext, NULL when comparing
+  const uint8_t *ref; // ciphertext to compare against
   unsigned int start;
   unsigned int end;
+  uint8_t fail;
 } core1_mul_data_enc_t;
 
 typedef struct
@@ -62,23 +62,61 @@ typedef struct
   const uint8_t *m;
 } core1_frommsg_data_t;
 
+typedef struct
+{
+  polyvec *sp;
+  polyvec *ep;
+  poly *epp;
+  const uint8_t *coins;
+  unsigned int start;
+  unsigned int end;
+} core1_noise_data_t;
+
+// Job descriptors are allocated from core0's workspace in fixed-size slots
+_Static_assert(sizeof(core1_hash_data_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+_Static_assert(sizeof(core1_mul_data_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+_Static_assert(sizeof(core1_pack_data_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+_Static_assert(sizeof(core1_mul_data_enc_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+_Static_assert(sizeof(core1_frommsg_data_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+_Static_assert(sizeof(core1_noise_data_t) <= KYBER_WS_JOB_BYTES, "job slot too small");
+
 /*************************************************
  * Name:        pack_pk
  *
  * Description: Serialize the public key as concatenation of the
  *              serialized vector of polynomials pk
  *              and the public seed used to generate the matrix A.
+ *              Each polynomial is absorbed into H(pk) right after it is
+ *              written, while its bytes are still in cache, so the hash
+ *              needs no second pass over pk.
  *
  * Arguments:   uint8_t *r: pointer to the output serialized public key
+ *              uint8_t *hpk: pointer to output H(pk) (KYBER_SYMBYTES bytes), or NULL
  *              polyvec *pk: pointer to the input public-key polyvec
  *              const uint8_t *seed: pointer to the input public seed
  **************************************************/
 static void pack_pk(uint8_t r[KYBER_INDCPA_PUBLICKEYBYTES],
+                    uint8_t *hpk,
                     polyvec *pk,
                     const uint8_t seed[KYBER_SYMBYTES])
 {
-  polyvec_tobytes(r, pk);
+  unsigned int i;
+  hash_state h;
+
+  if (!hpk) {
+    polyvec_tobytes(r, pk);
+    memcpy(r + KYBER_POLYVECBYTES, seed, KYBER_SYMBYTES);
+    return;
+  }
+
+  hash_h_init(&h);
+  for (i = 0; i < KYBER_K; i++) {
+    poly_tobytes(r + i * KYBER_POLYBYTES, &pk->vec[i]);
+    hash_h_absorb(&h, r + i * KYBER_POLYBYTES, KYBER_POLYBYTES);
+  }
   memcpy(r + KYBER_POLYVECBYTES, seed, KYBER_SYMBYTES);
+  hash_h_absorb(&h, r + KYBER_POLYVECBYTES, KYBER_SYMBYTES);
+  hash_h_finalize(hpk, &h);
 }
 
 /*************************************************
@@ -126,27 +164,78 @@ static void unpack_sk(polyvec *sk, const uint8_t packedsk[KYBER_INDCPA_SECRETKEY
 }
 
 /*************************************************
- * Name:        pack_ciphertext
+ * Name:        emit_u
  *
- * Description: Serialize the ciphertext as concatenation of the
- *              compressed and serialized vector of polynomials b
- *              and the compressed and serialized polynomial v
+ * Description: Compress one polynomial of the u-part of a ciphertext
+ *              (the serialized b) and either write it to c or compare it
+ *              against ref. Comparing needs one compressed polynomial of
+ *              scratch instead of a whole ciphertext buffer.
  *
- * Arguments:   uint8_t *r: pointer to the output serialized ciphertext
- *              poly *pk: pointer to the input vector of polynomials b
- *              poly *v: pointer to the input polynomial v
+ * Arguments:   - uint8_t *c: pointer to the output bytes, or NULL to compare
+ *              - const uint8_t *ref: pointer to the bytes to compare against
+ *              - const poly *b: pointer to the input polynomial
+ *
+ * Returns 0 if c was written or every byte matched, 1 otherwise
  **************************************************/
-static void pack_ciphertext(uint8_t r[KYBER_INDCPA_BYTES], polyvec *b, poly *v)
+static uint8_t emit_u(uint8_t *c, const uint8_t *ref, const poly *b)
 {
-  polyvec_compress(r, b);
-  poly_compress(r + KYBER_POLYVECCOMPRESSEDBYTES, v);
+  uint8_t fail;
+  ws_arena_t *ws;
+  size_t mark;
+  uint8_t *chunk;
+
+  if (c) {
+    poly_compress_du(c, b);
+    return 0;
+  }
+
+  ws = ws_local();
+  mark = ws_mark(ws);
+  chunk = ws_alloc(ws, KYBER_POLYCOMPRESSEDBYTES_DU);
+  poly_compress_du(chunk, b);
+  fail = verify(ref, chunk, KYBER_POLYCOMPRESSEDBYTES_DU);
+  ws_release(ws, mark);
+  return fail;
+}
+
+/*************************************************
+ * Name:        emit_v
+ *
+ * Description: Compress the v-part of a ciphertext and either write it
+ *              to c or compare it against ref; counterpart of emit_u
+ *
+ * Arguments:   - uint8_t *c: pointer to the output v-part, or NULL to compare
+ *              - const uint8_t *ref: pointer to the v-part to compare against
+ *              - const poly *v: pointer to the input polynomial
+ *
+ * Returns 0 if c was written or every byte matched, 1 otherwise
+ **************************************************/
+static uint8_t emit_v(uint8_t *c, const uint8_t *ref, const poly *v)
+{
+  uint8_t fail;
+  ws_arena_t *ws;
+  size_t mark;
+  uint8_t *chunk;
+
+  if (c) {
+    poly_compress(c, v);
+    return 0;
+  }
+
+  ws = ws_local();
+  mark = ws_mark(ws);
+  chunk = ws_alloc(ws, KYBER_POLYCOMPRESSEDBYTES);
+  poly_compress(chunk, v);
+  fail = verify(ref, chunk, KYBER_POLYCOMPRESSEDBYTES);
+  ws_release(ws, mark);
+  return fail;
 }
 
 /*************************************************
  * Name:        unpack_ciphertext
  *
  * Description: De-serialize and decompress ciphertext from a byte array;
- *              approximate inverse of pack_ciphertext
+ *              approximate inverse of emit_u and emit_v
  *
  * Arguments:   - polyvec *b: pointer to the output vector of polynomials b
  *              - poly *v: pointer to the output polynomial v
@@ -171,10 +260,11 @@ static void unpack_ciphertext(polyvec *b, poly *v, const uint8_t c[KYBER_INDCPA_
  *
  * Returns number of sampled 16-bit integers (at most len)
  **************************************************/
-static unsigned int rej_uniform(int16_t *r,
-                                unsigned int len,
-                                const uint8_t *buf,
-                                unsigned int buflen)
+// Not static for benchmarking
+unsigned int KYBER_HOT(rej_uniform)(int16_t *r,
+                                    unsigned int len,
+                                    const uint8_t *buf,
+                                    unsigned int buflen)
 {
   unsigned int ctr, pos;
   uint16_t val0, val1;
@@ -214,95 +304,225 @@ static unsigned int rej_uniform(int16_t *r,
 #error "Implementation of gen_matrix assumes that XOF_BLOCKBYTES is a multiple of 3"
 #endif
 
-#define GEN_MATRIX_NBLOCKS ((12 * KYBER_N / 8 * (1 << 12) / KYBER_Q + XOF_BLOCKBYTES) / XOF_BLOCKBYTES)
 // Not static for benchmarking
 void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed)
 {
   unsigned int ctr, i, j;
   unsigned int buflen;
-  uint8_t buf[GEN_MATRIX_NBLOCKS * XOF_BLOCKBYTES];
-  xof_state state;
+  // Scratch from the arena of whichever core is generating
+  ws_arena_t *ws = ws_local();
+  size_t mark = ws_mark(ws);
+  uint8_t *buf = ws_alloc(ws, GEN_MATRIX_NBLOCKS * XOF_BLOCKBYTES);
+  xof_state *state = ws_alloc(ws, sizeof(xof_state));
 
   for (i = 0; i < KYBER_K; i++)
   {
     for (j = 0; j < KYBER_K; j++)
     {
       if (transposed)
-        xof_absorb(&state, seed, i, j);
+        xof_absorb(state, seed, i, j);
       else
-        xof_absorb(&state, seed, j, i);
+        xof_absorb(state, seed, j, i);
 
-      xof_squeezeblocks(buf, GEN_MATRIX_NBLOCKS, &state);
+      xof_squeezeblocks(buf, GEN_MATRIX_NBLOCKS, state);
       buflen = GEN_MATRIX_NBLOCKS * XOF_BLOCKBYTES;
       ctr = rej_uniform(a[i].vec[j].coeffs, KYBER_N, buf, buflen);
 
       while (ctr < KYBER_N)
       {
-        xof_squeezeblocks(buf, 1, &state);
+        xof_squeezeblocks(buf, 1, state);
         buflen = XOF_BLOCKBYTES;
         ctr += rej_uniform(a[i].vec[j].coeffs + ctr, KYBER_N - ctr, buf, buflen);
       }
     }
   }
+
+  ws_release(ws, mark);
+}
+
+/*************************************************
+ * Name:        matmul_rows
+ *
+ * Description: Computes rows [start, end) of the keygen matrix-vector
+ *              product r = a*s, in the NTT domain and converted to
+ *              Montgomery form, used by both cores for their lanes.
+ *              Each row is accumulated in the calling core's local
+ *              scratch and written to r once, so with KYBER_WS_BANKED the
+ *              repeated accumulation stays in the core's own bank.
+ *
+ * Arguments:   - polyvec *r: pointer to output vector (rows start..end-1 written)
+ *              - const polyvec *a: pointer to input matrix rows
+ *              - const polyvec *s: pointer to input vector
+ *              - unsigned int start, end: row range
+ **************************************************/
+static void matmul_rows(polyvec *r,
+                        const polyvec *a,
+                        const polyvec *s,
+                        unsigned int start,
+                        unsigned int end)
+{
+  unsigned int i;
+  ws_arena_t *ws = ws_local();
+  size_t mark = ws_mark(ws);
+  poly *acc = ws_alloc(ws, sizeof(poly));
+
+  for (i = start; i < end; i++)
+  {
+    polyvec_basemul_acc_montgomery(acc, &a[i], s);
+    poly_tomont(acc);
+    r->vec[i] = *acc;
+  }
+
+  ws_release(ws, mark);
+}
+
+/*************************************************
+ * Name:        enc_rows
+ *
+ * Description: Rows [start, end) of the u-part of a ciphertext. Each row
+ *              goes through the whole pipeline in core-local scratch:
+ *              row i of A^T s', inverse NTT, + ep[i], reduce, compress.
+ *              The vector b is never stored; the bytes are written to c
+ *              or compared against ref (see emit_u), and with emit set
+ *              each row is handed on as soon as it is in c.
+ *
+ * Arguments:   - uint8_t *c: pointer to output ciphertext, or NULL
+ *              - const uint8_t *ref: ciphertext to compare against when c == NULL
+ *              - const polyvec *at: pointer to the transposed matrix
+ *              - const polyvec *sp: pointer to the secret vector (NTT domain)
+ *              - const polyvec *ep: pointer to the error vector
+ *              - unsigned int start, end: rows to process
+ *              - kyber_emit_t emit: called with each row of c, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 if c was written or every row matched, 1 otherwise
+ **************************************************/
+static uint8_t enc_rows(uint8_t *c,
+                        const uint8_t *ref,
+                        const polyvec *at,
+                        const polyvec *sp,
+                        const polyvec *ep,
+                        unsigned int start,
+                        unsigned int end,
+                        kyber_emit_t emit,
+                        void *ctx)
+{
+  unsigned int i;
+  uint8_t fail = 0;
+  size_t off;
+  ws_arena_t *ws = ws_local();
+  size_t mark = ws_mark(ws);
+  poly *acc = ws_alloc(ws, sizeof(poly));
+
+  for (i = start; i < end; i++)
+  {
+    off = i * KYBER_POLYCOMPRESSEDBYTES_DU;
+    polyvec_basemul_acc_montgomery(acc, &at[i], sp);
+    poly_invntt_tomont(acc);
+    poly_add(acc, acc, &ep->vec[i]);
+    poly_reduce(acc);
+    fail |= emit_u(c ? c + off : NULL, ref ? ref + off : NULL, acc);
+    if (emit)
+      emit(ctx, c + off, KYBER_POLYCOMPRESSEDBYTES_DU);
+  }
+
+  secure_zero(acc, sizeof(poly));
+  ws_release(ws, mark);
+  return fail;
+}
+
+/*************************************************
+ * Name:        enc_v
+ *
+ * Description: The v-part of a ciphertext through the same pipeline as
+ *              enc_rows: t^T s', inverse NTT, + epp + k, reduce, compress
+ *
+ * Arguments:   - uint8_t *c: pointer to the output v-part, or NULL
+ *              - const uint8_t *ref: v-part to compare against when c == NULL
+ *              - const polyvec *pkpv: pointer to the public vector t
+ *              - const polyvec *sp: pointer to the secret vector (NTT domain)
+ *              - const poly *epp: pointer to the error polynomial
+ *              - const poly *k: pointer to the encoded message
+ *
+ * Returns 0 if c was written or the v-part matched, 1 otherwise
+ **************************************************/
+static uint8_t enc_v(uint8_t *c,
+                     const uint8_t *ref,
+                     const polyvec *pkpv,
+                     const polyvec *sp,
+                     const poly *epp,
+                     const poly *k)
+{
+  uint8_t fail;
+  ws_arena_t *ws = ws_local();
+  size_t mark = ws_mark(ws);
+  poly *acc = ws_alloc(ws, sizeof(poly));
+
+  polyvec_basemul_acc_montgomery(acc, pkpv, sp);
+  poly_invntt_tomont(acc);
+  poly_add(acc, acc, epp);
+  poly_add(acc, acc, k);
+  poly_reduce(acc);
+  fail = emit_v(c, ref, acc);
+
+  secure_zero(acc, sizeof(poly));
+  ws_release(ws, mark);
+  return fail;
 }
 
 /*
   - Below are the functions which are to be sent to core1 for the keypair derand function
 */
 
-void core1_hash_worker()
+static void core1_hash_worker(void)
 {
   core1_hash_data_t *data =
-      (core1_hash_data_t *)multicore_fifo_pop_blocking();
+      (core1_hash_data_t *)sched_core1_get_job();
 
   uint64_t t0 = time_us_64();
 
   const uint8_t *publicseed = data->buf;
-  hash_g(data->buf, data->buf, KYBER_SYMBYTES + 1);
   gen_a(data->a, publicseed);
 
   uint64_t t1 = time_us_64();
   kg_prof.core1_hash_gena += (t1 - t0);
+  TRACE_JOB("keygen.hash_genA", t0, t1);
 
-  multicore_fifo_push_blocking(1);
+  sched_core1_job_done();
 }
 
 
-void core1_mul_worker()
+static void core1_mul_worker(void)
 {
   core1_mul_data_t *data =
-      (core1_mul_data_t *)multicore_fifo_pop_blocking();
+      (core1_mul_data_t *)sched_core1_get_job();
 
   uint64_t t0 = time_us_64();
 
-  for (unsigned int i = data->start; i < data->end; i++)
-  {
-    polyvec_basemul_acc_montgomery(&data->pkpv->vec[i],
-                                   &data->a[i],
-                                   data->skpv);
-    poly_tomont(&data->pkpv->vec[i]);
-  }
+  matmul_rows(data->pkpv, data->a, data->skpv, data->start, data->end);
 
   uint64_t t1 = time_us_64();
   kg_prof.core1_matmul += (t1 - t0);
+  TRACE_JOB("keygen.matmul", t0, t1);
 
-  multicore_fifo_push_blocking(1);
+  sched_core1_job_done();
 }
 
 
-void core1_pack_worker()
+static void core1_pack_worker(void)
 {
   core1_pack_data_t *data =
-      (core1_pack_data_t *)multicore_fifo_pop_blocking();
+      (core1_pack_data_t *)sched_core1_get_job();
 
   uint64_t t0 = time_us_64();
 
-  pack_pk(data->pk, data->pkpv, data->publicseed);
+  pack_pk(data->pk, data->hpk, data->pkpv, data->publicseed);
 
   uint64_t t1 = time_us_64();
   kg_prof.core1_pack += (t1 - t0);
+  TRACE_JOB("keygen.pack_pk", t0, t1);
 
-  multicore_fifo_push_blocking(1);
+  sched_core1_job_done();
 }
 
 
@@ -316,68 +536,80 @@ void core1_pack_worker()
  *                             (of length KYBER_INDCPA_PUBLICKEYBYTES bytes)
  *              - uint8_t *sk: pointer to output private key
  *                             (of length KYBER_INDCPA_SECRETKEYBYTES bytes)
+ *              - uint8_t *hpk: pointer to output H(pk), hashed by the core
+ *                             that packs pk (KYBER_SYMBYTES bytes), or NULL
  *              - const uint8_t *coins: pointer to input randomness
  *                             (of length KYBER_SYMBYTES bytes)
  **************************************************/
 
 void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
                            uint8_t sk[KYBER_INDCPA_SECRETKEYBYTES],
+                           uint8_t *hpk,
                            const uint8_t coins[KYBER_SYMBYTES])
 {
   unsigned int i;
-  uint8_t buf[2 * KYBER_SYMBYTES];
+  ws_arena_t *ws = ws_arena();
+  size_t mark = ws_mark(ws);
+  uint8_t *buf = ws_alloc(ws, 2 * KYBER_SYMBYTES);
   const uint8_t *publicseed = buf;
   const uint8_t *noiseseed = buf + KYBER_SYMBYTES;
-  static polyvec a[KYBER_K];
-  static polyvec e, pkpv, skpv;
+  polyvec *a = ws_alloc(ws, KYBER_K * sizeof(polyvec));
+  polyvec *e = ws_alloc(ws, sizeof(polyvec));
+  polyvec *pkpv = ws_alloc(ws, sizeof(polyvec));
+  polyvec *skpv = ws_alloc(ws, sizeof(polyvec));
+  volatile core1_hash_data_t *core1_data = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+  volatile core1_mul_data_t *mul_data = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+  volatile core1_pack_data_t *pack_data = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+
+  // A transfer left expanding A^T on core1 is abandoned
+  sched_settle_core1();
 
   memcpy(buf, coins, KYBER_SYMBYTES);
   buf[KYBER_SYMBYTES] = KYBER_K;
 
   uint64_t t0, t1;
+  uint64_t tn0, tn1;
 
   t0 = time_us_64();
 
-  // Launch core 1 worker for hashing
-  multicore_launch_core1(core1_hash_worker);
-
-  // Prepare and send data for core 1
-  static volatile core1_hash_data_t core1_data;
-  core1_data.buf = buf;
-  core1_data.a = a;
-  multicore_fifo_push_blocking((uintptr_t)&core1_data);
+  // core0 samples noise from noiseseed straight away, so hash_g has to be
+  // done before core1 is started; only gen_a runs in parallel
+  tn0 = time_us_64();
+  hash_g(buf, buf, KYBER_SYMBYTES + 1);
+  tn1 = time_us_64();
+  TRACE_JOB("keygen.hash_g", tn0, tn1);
 
-  // Meanwhile, core 0 can generate noise in parallel
+  // Launch core 1 worker for gen_a
+  sched_launch_core1(PROF_PHASE_HASH_GENA, core1_hash_worker);
 
-  uint64_t tn0, tn1;
+  // Prepare and send data for core 1
+  core1_data->buf = buf;
+  core1_data->a = a;
+  sched_push_job((uintptr_t)core1_data);
 
+  // Meanwhile, core 0 samples the noise and transforms each polynomial as
+  // it is sampled. It stays on core0: gen_a on core1 is the longer job.
   tn0 = time_us_64();
   uint8_t nonce = 0;
   for (i = 0; i < KYBER_K; i++)
-    poly_getnoise_eta1(&skpv.vec[i], noiseseed, nonce++);
+    poly_getnoise_eta1_ntt(&skpv->vec[i], noiseseed, nonce++);
 
   for (i = 0; i < KYBER_K; i++)
-    poly_getnoise_eta1(&e.vec[i], noiseseed, nonce++);
-  
-  tn1 = time_us_64();
-  kg_prof.noise += (tn1 - tn0);
-
-  tn0 = time_us_64();
-
-  polyvec_ntt(&skpv);
-  polyvec_ntt(&e);
+    poly_getnoise_eta1_ntt(&e->vec[i], noiseseed, nonce++);
 
   tn1 = time_us_64();
-  kg_prof.ntt += (tn1 - tn0);
+  kg_prof.noise += (tn1 - tn0);
+  TRACE_JOB("keygen.noise", tn0, tn1);
 
   // Wait for core 1 to finish hash & gen_a
-  multicore_fifo_pop_blocking();
+  sched_wait_core1();
 
   t1 = time_us_64();
   kg_prof.phase_hash_gena += (t1 - t0);
+  TRACE_PHASE("keygen.phase_hash_genA", t0, t1);
 
 
-  multicore_reset_core1();
+  sched_reset_core1();
 
   // Parallelisation across k vector lanes
   unsigned int half = KYBER_K / 2; // floor division
@@ -387,179 +619,448 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
   unsigned int core0_end = half;
 
   // Prepare work packet for core1
-  static volatile core1_mul_data_t mul_data;
-  mul_data.a = a;
-  mul_data.pkpv = &pkpv;
-  mul_data.skpv = &skpv;
-  mul_data.start = core1_start;
-  mul_data.end = core1_end;
+  mul_data->a = a;
+  mul_data->pkpv = pkpv;
+  mul_data->skpv = skpv;
+  mul_data->start = core1_start;
+  mul_data->end = core1_end;
 
   t0 = time_us_64();
   // Launch worker on core1 for multiplication
-  multicore_launch_core1(core1_mul_worker);
-  multicore_fifo_push_blocking((uintptr_t)&mul_data);
+  sched_launch_core1(PROF_PHASE_MATMUL, core1_mul_worker);
+  sched_push_job((uintptr_t)mul_data);
 
   // Core 0 processes the first half
-  for (i = core0_start; i < core0_end; i++)
-  {
-    polyvec_basemul_acc_montgomery(&pkpv.vec[i], &a[i], &skpv);
-    poly_tomont(&pkpv.vec[i]);
-  }
+  tn0 = time_us_64();
+  matmul_rows(pkpv, a, skpv, core0_start, core0_end);
+  tn1 = time_us_64();
+  TRACE_JOB("keygen.matmul", tn0, tn1);
 
   // Wait for core1 to finish before proceeding
-  multicore_fifo_pop_blocking();
+  sched_wait_core1();
   t1 = time_us_64();
   kg_prof.phase_matmul += (t1 - t0);
-  multicore_reset_core1();
+  TRACE_PHASE("keygen.phase_matmul", t0, t1);
+  sched_reset_core1();
 
   // Securely zeroise 'a' after use
   // memset(a, 0, sizeof(a));
-  secure_zero(a, sizeof(a));
+  secure_zero(a, KYBER_K * sizeof(polyvec));
 
   t0 = time_us_64();
-  polyvec_add(&pkpv, &pkpv, &e);
-  polyvec_reduce(&pkpv);
+  polyvec_add(pkpv, pkpv, e);
+  polyvec_reduce(pkpv);
   t1 = time_us_64();
   kg_prof.add_reduce += (t1 - t0);
+  TRACE_JOB("keygen.add_reduce", t0, t1);
   // Securely zeroise 'e' after use
   // memset(e.vec, 0, sizeof(e.vec));
-  secure_zero(e.vec, sizeof(e.vec));
+  secure_zero(e, sizeof(polyvec));
 
-  // Launch core1 worker for packing
-  static volatile core1_pack_data_t pack_data;
-  pack_data.pk = pk;
-  pack_data.pkpv = &pkpv;
-  pack_data.publicseed = publicseed;
+  // Launch core1 worker for packing pk, hashed into H(pk) as it is packed
+  pack_data->pk = pk;
+  pack_data->hpk = hpk;
+  pack_data->pkpv = pkpv;
+  pack_data->publicseed = publicseed;
 
   t0 = time_us_64();
-  multicore_launch_core1(core1_pack_worker);
-  multicore_fifo_push_blocking((uintptr_t)&pack_data);
+  sched_launch_core1(PROF_PHASE_PACK, core1_pack_worker);
+  sched_push_job((uintptr_t)pack_data);
 
   // Core0 packs secret key in parallel
-  pack_sk(sk, &skpv);
-
-  // Securely zeroise 'pkpv' after use
-  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
-  secure_zero(pkpv.vec, sizeof(pkpv.vec));
+  tn0 = time_us_64();
+  pack_sk(sk, skpv);
+  tn1 = time_us_64();
+  TRACE_JOB("keygen.pack_sk", tn0, tn1);
 
   // Wait for core1
-  multicore_fifo_pop_blocking();
+  sched_wait_core1();
   t1 = time_us_64();
   kg_prof.phase_pack += (t1 - t0);
+  TRACE_PHASE("keygen.phase_pack", t0, t1);
 
-  multicore_reset_core1();
+  sched_reset_core1();
+
+  // Securely zeroise 'pkpv' after use
+  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
+  secure_zero(pkpv, sizeof(polyvec));
 
   // Finally, zeroise the secret key
   // memset(skpv.vec, 0, sizeof(skpv.vec));
-  secure_zero(skpv.vec, sizeof(skpv.vec));
+  secure_zero(skpv, sizeof(polyvec));
+  secure_zero(buf, 2 * KYBER_SYMBYTES);
+
+  ws_release(ws, mark);
 }
 
 /*
   - Below are the functions which are to be sent to core1 for the enc function
 */
 
-void core1_mul_worker_enc()
+/*************************************************
+ * Name:        noise_lanes
+ *
+ * Description: Sample lanes [start, end) of the encryption noise: sp in
+ *              the NTT domain, ep in normal domain. The nonces are fixed
+ *              per lane, so the split between the cores does not change
+ *              the result.
+ *
+ * Arguments:   - polyvec *sp: pointer to output secret vector
+ *              - polyvec *ep: pointer to output error vector
+ *              - const uint8_t *coins: pointer to input random coins
+ *              - unsigned int start, end: lanes to sample
+ **************************************************/
+static void noise_lanes(polyvec *sp,
+                        polyvec *ep,
+                        const uint8_t coins[KYBER_SYMBYTES],
+                        unsigned int start,
+                        unsigned int end)
+{
+  unsigned int i;
+
+  for (i = start; i < end; i++)
+    poly_getnoise_eta1_ntt(&sp->vec[i], coins, i);
+  for (i = start; i < end; i++)
+    poly_getnoise_eta2(&ep->vec[i], coins, KYBER_K + i);
+}
+
+static void core1_noise_worker_enc(void)
+{
+  core1_noise_data_t *data =
+      (core1_noise_data_t *)sched_core1_get_job();
+
+  uint64_t t0 = time_us_64();
+  noise_lanes(data->sp, data->ep, data->coins, data->start, data->end);
+  poly_getnoise_eta2(data->epp, data->coins, 2 * KYBER_K);
+  uint64_t t1 = time_us_64();
+
+  enc_prof.core1_noise += (t1 - t0);
+  TRACE_JOB("enc.noise", t0, t1);
+
+  sched_core1_job_done();
+}
+
+static void core1_mul_worker_enc(void)
 {
   core1_mul_data_enc_t *data =
-      (core1_mul_data_enc_t *)multicore_fifo_pop_blocking();
+      (core1_mul_data_enc_t *)sched_core1_get_job();
 
   uint64_t t0 = time_us_64();
 
-  for (unsigned int i = data->start; i < data->end; i++)
-    polyvec_basemul_acc_montgomery(&data->b->vec[i],
-                                   &data->at[i],
-                                   data->sp);
+  data->fail = enc_rows(data->c, data->ref, data->at, data->sp, data->ep,
+                        data->start, data->end, NULL, NULL);
 
   uint64_t t1 = time_us_64();
   enc_prof.core1_matmul += (t1 - t0);
+  TRACE_JOB("enc.matmul", t0, t1);
 
-  multicore_fifo_push_blocking(1);
+  sched_core1_job_done();
 }
 
 
-void core1_frommsg_worker()
+static void core1_frommsg_worker(void)
 {
   core1_frommsg_data_t *data =
-      (core1_frommsg_data_t *)multicore_fifo_pop_blocking();
+      (core1_frommsg_data_t *)sched_core1_get_job();
 
   uint64_t t0 = time_us_64();
   poly_frommsg(data->k, data->m);
   uint64_t t1 = time_us_64();
 
   enc_prof.core1_frommsg += (t1 - t0);
+  TRACE_JOB("enc.frommsg", t0, t1);
+
+  sched_core1_job_done();
+}
 
-  multicore_fifo_push_blocking(1);
+static void core1_gen_at_worker(void)
+{
+  indcpa_pk_t *p = (indcpa_pk_t *)sched_core1_get_job();
+
+  uint64_t t0 = time_us_64();
+  gen_at(p->at_fill, p->seed);
+  uint64_t t1 = time_us_64();
+
+  enc_prof.gen_at += (t1 - t0);
+  TRACE_JOB("enc.gen_at", t0, t1);
+
+  sched_core1_job_done();
 }
 
+/* The state holding A^T, in an atcache entry or being expanded into one
+   on core1, until its indcpa_enc_pk; any other call abandons it */
+static indcpa_pk_t *pk_pending;
+
+static void pk_settle(void);
+
+static void pk_hold(indcpa_pk_t *p)
+{
+  pk_pending = p;
+  sched_hold_core1(pk_settle);
+}
+
+static void pk_release(indcpa_pk_t *p)
+{
+  if (pk_pending == p)
+  {
+    pk_pending = NULL;
+    sched_hold_core1(NULL);
+  }
+}
+
+static void pk_wait_gen_at(indcpa_pk_t *p)
+{
+  sched_wait_core1();
+  sched_reset_core1();
+  p->at_pending = 0;
+  pk_pending = NULL;
+}
+
+/* Abandons the pending transfer when another call needs core1 or atcache (sched_hold_core1) */
+static void pk_settle(void)
+{
+  if (pk_pending)
+    indcpa_pk_abort(pk_pending);
+}
+
+/* Hands the expansion of A^T into p->at_fill to core1 */
+static void pk_launch_gen_at(indcpa_pk_t *p)
+{
+  sched_launch_core1(PROF_PHASE_HASH_GENA, core1_gen_at_worker);
+  sched_push_job((uintptr_t)p);
+  p->at_pending = 1;
+  pk_hold(p);
+}
 
 /*************************************************
- * Name:        indcpa_enc
+ * Name:        indcpa_pk_init
  *
- * Description: Encryption function of the CPA-secure
- *              public-key encryption scheme underlying Kyber.
+ * Description: Prepares p to take a public key through indcpa_pk_absorb;
+ *              a transfer still expanding A^T on core1, in this state or
+ *              another one, is abandoned first (indcpa_pk_abort)
  *
- * Arguments:   - uint8_t *c: pointer to output ciphertext
- *                            (of length KYBER_INDCPA_BYTES bytes)
- *              - const uint8_t *m: pointer to input message
- *                                  (of length KYBER_INDCPA_MSGBYTES bytes)
- *              - const uint8_t *pk: pointer to input public key
- *                                   (of length KYBER_INDCPA_PUBLICKEYBYTES)
- *              - const uint8_t *coins: pointer to input random coins used as seed
- *                                      (of length KYBER_SYMBYTES) to deterministically
- *                                      generate all randomness
+ * Arguments:   - indcpa_pk_t *p: pointer to the state
  **************************************************/
+void indcpa_pk_init(indcpa_pk_t *p)
+{
+  sched_settle_core1();
+  p->fill = 0;
+  p->at = NULL;
+  p->at_fill = NULL;
+  p->at_pending = 0;
+}
 
-void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
-                const uint8_t m[KYBER_INDCPA_MSGBYTES],
-                const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
-                const uint8_t coins[KYBER_SYMBYTES])
+/*************************************************
+ * Name:        indcpa_pk_abort
+ *
+ * Description: Abandons a public key being taken in: waits for core1 if
+ *              it is still expanding A^T, leaves the atcache entry it was
+ *              expanding into empty, lets go of an entry it hit, and
+ *              resets p, so that indcpa_enc_pk cannot be given it
+ *              without a new key
+ *
+ * Arguments:   - indcpa_pk_t *p: pointer to the state
+ **************************************************/
+void indcpa_pk_abort(indcpa_pk_t *p)
 {
-  unsigned int i;
-  uint8_t seed[KYBER_SYMBYTES];
-  uint8_t nonce = 0;
-  static polyvec sp, pkpv, ep, at[KYBER_K], b;
-  static poly v, k, epp;
+  if (p->at_pending)
+    pk_wait_gen_at(p);
+  pk_release(p);
+  p->fill = 0;
+  p->at = NULL;
+  p->at_fill = NULL;
+}
 
-  // Launch core1 for poly_frommsg
-  static volatile core1_frommsg_data_t frommsg_data;
-  frommsg_data.k = &k;
-  frommsg_data.m = m;
-  uint64_t t0, t1;
-  t0 = time_us_64();
-  multicore_launch_core1(core1_frommsg_worker);
-  multicore_fifo_push_blocking((uintptr_t)&frommsg_data);
-  
-  uint64_t tu0, tu1;
-  tu0 = time_us_64();
-  // Meanwhile, Core0 does unpack_pk
-  unpack_pk(&pkpv, seed, pk);
-  tu1 = time_us_64();
-  enc_prof.unpack += (tu1 - tu0);
-  // Wait for core1
-  multicore_fifo_pop_blocking();
-  t1 = time_us_64();
-  enc_prof.phase_frommsg += (t1 - t0);
+/*************************************************
+ * Name:        indcpa_pk_absorb
+ *
+ * Description: Takes the next len bytes of a public key. Every polynomial
+ *              of t is unpacked as soon as it is complete; when the seed
+ *              is, A^T comes from atcache or core1 starts expanding it
+ *              into the entry claimed for the seed (see indcpa_pk_t).
+ *
+ * Arguments:   - indcpa_pk_t *p: pointer to the state
+ *              - const uint8_t *in: pointer to the next bytes of pk
+ *              - size_t len: their number; at most what is left of pk
+ **************************************************/
+void indcpa_pk_absorb(indcpa_pk_t *p, const uint8_t *in, size_t len)
+{
+  unsigned int i, off, n;
+
+  while (len)
+  {
+    if (p->fill < KYBER_POLYVECBYTES)
+    {
+      i = p->fill / KYBER_POLYBYTES;
+      off = p->fill % KYBER_POLYBYTES;
+      n = len < KYBER_POLYBYTES - off ? (unsigned int)len : KYBER_POLYBYTES - off;
+      if (n == KYBER_POLYBYTES)
+      {
+        poly_frombytes(&p->pkpv.vec[i], in);
+      }
+      else
+      {
+        memcpy(p->part + off, in, n);
+        if (off + n == KYBER_POLYBYTES)
+          poly_frombytes(&p->pkpv.vec[i], p->part);
+      }
+    }
+    else
+    {
+      off = p->fill - KYBER_POLYVECBYTES;
+      n = len < KYBER_SYMBYTES - off ? (unsigned int)len : KYBER_SYMBYTES - off;
+      memcpy(p->seed + off, in, n);
+#if ATC_ENTRIES > 0
+      if (off + n == KYBER_SYMBYTES)
+      {
+        // Another transfer holding an entry is abandoned before the lookup;
+        // this one then holds its entry, hit or being filled, until the end
+        sched_settle_core1();
+        p->at = atc_reserve(p->seed, &p->at_fill);
+        if (p->at_fill)
+          pk_launch_gen_at(p);
+        else
+          pk_hold(p);
+      }
+#endif
+    }
+    p->fill += n;
+    in += n;
+    len -= n;
+  }
+}
 
-  multicore_reset_core1();
 
-  t0 = time_us_64();
-  gen_at(at, seed);
-  t1 = time_us_64();
-  enc_prof.gen_at += (t1 - t0);
+/*************************************************
+ * Name:        indcpa_enc_internal
+ *
+ * Description: Encryption shared by indcpa_enc and indcpa_enc_cmp. The
+ *              ciphertext is either written to c or, with c == NULL,
+ *              compared against ref as it is compressed; no ciphertext
+ *              buffer exists in that case. Each core takes its rows of the
+ *              u-part from the matmul to the compressed bytes (enc_rows),
+ *              and core0 does v as well.
+ *
+ *              With emit set (c != NULL), the ciphertext goes to emit in
+ *              order while it is computed: core0's rows, which lead, as
+ *              each is done; core1's rows once core1 is; then v, which
+ *              core0 computes only after handing over core1's rows so
+ *              that those are not held back behind it. With core1's
+ *              phases inline, core0 takes all rows and emits each in turn.
+ *
+ *              With pin instead of pk, t is already unpacked and A^T is
+ *              cached or being expanded on core1 (indcpa_pk_absorb);
+ *              core0 encodes the message meanwhile. Without atcache the
+ *              expansion only starts here, on core1 next to the encoding.
+ *
+ * Arguments:   - uint8_t *c: pointer to output ciphertext, or NULL
+ *              - const uint8_t *ref: ciphertext to compare against when c == NULL
+ *              - const uint8_t *m: pointer to input message
+ *              - const uint8_t *pk: pointer to input public key, or NULL
+ *              - indcpa_pk_t *pin: public key taken in when pk == NULL
+ *              - const uint8_t *coins: pointer to input random coins
+ *              - kyber_emit_t emit: called with the ciphertext in pieces, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 if c was written or the re-encryption equals ref, 1 otherwise
+ **************************************************/
+static int indcpa_enc_internal(uint8_t *c,
+                               const uint8_t *ref,
+                               const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                               const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                               indcpa_pk_t *pin,
+                               const uint8_t coins[KYBER_SYMBYTES],
+                               kyber_emit_t emit,
+                               void *ctx)
+{
+  uint8_t fail;
+  ws_arena_t *ws = ws_arena();
+  size_t mark = ws_mark(ws);
+  uint8_t *seed;
+#if ATC_ENTRIES > 0
+  const polyvec *at;
+#else
+  polyvec *at = ws_alloc(ws, KYBER_K * sizeof(polyvec));
+#endif
+  polyvec *sp = ws_alloc(ws, sizeof(polyvec));
+  polyvec *pkpv;
+  polyvec *ep = ws_alloc(ws, sizeof(polyvec));
+  poly *k = ws_alloc(ws, sizeof(poly));
+  poly *epp = ws_alloc(ws, sizeof(poly));
+  volatile core1_frommsg_data_t *frommsg_data = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+  volatile core1_mul_data_enc_t *mul_data2 = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+  volatile core1_noise_data_t *noise_data = ws_alloc(ws, KYBER_WS_JOB_BYTES);
+  uint64_t t0, t1;
+  uint64_t tu0, tu1;
 
-  t0 = time_us_64();
-  for (i = 0; i < KYBER_K; i++)
-    poly_getnoise_eta1(sp.vec + i, coins, nonce++);
-  for (i = 0; i < KYBER_K; i++)
-    poly_getnoise_eta2(ep.vec + i, coins, nonce++);
-  poly_getnoise_eta2(&epp, coins, nonce++);
-  t1 = time_us_64();
-  enc_prof.noise += (t1 - t0);
+  // A transfer holding an atcache entry or core1 is abandoned, unless it is pin's
+  if (!pin || pk_pending != pin)
+    sched_settle_core1();
 
-  t0 = time_us_64();
-  polyvec_ntt(&sp);
-  t1 = time_us_64();
-  enc_prof.ntt += (t1 - t0);
+  if (pin)
+  {
+    pkpv = &pin->pkpv;
+    seed = pin->seed;
+#if ATC_ENTRIES > 0
+    at = pin->at;
+#else
+    pin->at_fill = at;
+    pk_launch_gen_at(pin);
+#endif
+    // Core0 encodes the message while core1 may still expand A^T
+    t0 = time_us_64();
+    poly_frommsg(k, m);
+    tu1 = time_us_64();
+    TRACE_JOB("enc.frommsg", t0, tu1);
+    if (pin->at_pending)
+      pk_wait_gen_at(pin);
+#if ATC_ENTRIES > 0
+    // The entry becomes a hit only now that the matrix is complete
+    if (pin->at_fill)
+      atc_publish(pin->at, pin->seed);
+    pin->at_fill = NULL;
+#endif
+    pk_release(pin);
+    t1 = time_us_64();
+    enc_prof.phase_frommsg += (t1 - t0);
+    TRACE_PHASE("enc.phase_frommsg", t0, t1);
+  }
+  else
+  {
+    seed = ws_alloc(ws, KYBER_SYMBYTES);
+    pkpv = ws_alloc(ws, sizeof(polyvec));
+
+    // Launch core1 for poly_frommsg
+    frommsg_data->k = k;
+    frommsg_data->m = m;
+    t0 = time_us_64();
+    sched_launch_core1(PROF_PHASE_FROMMSG, core1_frommsg_worker);
+    sched_push_job((uintptr_t)frommsg_data);
+
+    tu0 = time_us_64();
+    // Meanwhile, Core0 does unpack_pk
+    unpack_pk(pkpv, seed, pk);
+    tu1 = time_us_64();
+    enc_prof.unpack += (tu1 - tu0);
+    TRACE_JOB("enc.unpack", tu0, tu1);
+    // Wait for core1
+    sched_wait_core1();
+    t1 = time_us_64();
+    enc_prof.phase_frommsg += (t1 - t0);
+    TRACE_PHASE("enc.phase_frommsg", t0, t1);
+
+    sched_reset_core1();
+
+    t0 = time_us_64();
+#if ATC_ENTRIES > 0
+    at = atc_get(seed);
+#else
+    gen_at(at, seed);
+#endif
+    t1 = time_us_64();
+    enc_prof.gen_at += (t1 - t0);
+    TRACE_JOB("enc.gen_at", t0, t1);
+  }
 
   // Compute ranges for splitting
   unsigned int half = KYBER_K / 2;
@@ -568,74 +1069,200 @@ void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
   unsigned int core0_start = 0;
   unsigned int core0_end = half;
 
-  // Setup data packet for core1
-  static volatile core1_mul_data_enc_t mul_data2;
-  mul_data2.at = at;
-  mul_data2.b = &b;
-  mul_data2.sp = &sp;
-  mul_data2.start = core1_start;
-  mul_data2.end = core1_end;
+  // Each core samples its own lanes of sp and ep; core1 also takes epp
+  noise_data->sp = sp;
+  noise_data->ep = ep;
+  noise_data->epp = epp;
+  noise_data->coins = coins;
+  noise_data->start = core1_start;
+  noise_data->end = core1_end;
 
   t0 = time_us_64();
-  // Launch multiplication worker on core1
-  multicore_launch_core1(core1_mul_worker_enc);
-  multicore_fifo_push_blocking((uintptr_t)&mul_data2);
-
-  // Core0 executes its portion
-  for (i = core0_start; i < core0_end; i++)
-  {
-    polyvec_basemul_acc_montgomery(&b.vec[i], &at[i], &sp);
-  }
+  sched_launch_core1(PROF_PHASE_NOISE, core1_noise_worker_enc);
+  sched_push_job((uintptr_t)noise_data);
 
-  polyvec_basemul_acc_montgomery(&v, &pkpv, &sp);
+  tu0 = time_us_64();
+  noise_lanes(sp, ep, coins, core0_start, core0_end);
+  tu1 = time_us_64();
+  enc_prof.noise += (tu1 - tu0);
+  TRACE_JOB("enc.noise", tu0, tu1);
 
-  // Wait for core1 and cleanup
-  multicore_fifo_pop_blocking();
+  sched_wait_core1();
   t1 = time_us_64();
-  enc_prof.phase_matmul += (t1 - t0);
+  enc_prof.phase_noise += (t1 - t0);
+  TRACE_PHASE("enc.phase_noise", t0, t1);
 
+  sched_reset_core1();
 
-  multicore_reset_core1();
+  // Streaming with core1's phases inline: nothing runs in parallel, so
+  // core0 takes every row and each goes out as soon as it is done
+  if (emit && !sched_core1_enabled())
+    core0_end = core1_start = KYBER_K;
 
-  t0 = time_us_64();
-  polyvec_invntt_tomont(&b);
-  poly_invntt_tomont(&v);
-  t1 = time_us_64();
-  enc_prof.invntt += (t1 - t0);
+  // Setup data packet for core1: its rows go from the matmul straight to c
+  mul_data2->at = at;
+  mul_data2->sp = sp;
+  mul_data2->ep = ep;
+  mul_data2->c = c;
+  mul_data2->ref = ref;
+  mul_data2->start = core1_start;
+  mul_data2->end = core1_end;
 
   t0 = time_us_64();
-  polyvec_add(&b, &b, &ep);
-  poly_add(&v, &v, &epp);
-  poly_add(&v, &v, &k);
-  polyvec_reduce(&b);
-  poly_reduce(&v);
+  // Launch multiplication worker on core1
+  sched_launch_core1(PROF_PHASE_MATMUL, core1_mul_worker_enc);
+  sched_push_job((uintptr_t)mul_data2);
+
+  // Core0 executes its rows and v
+  tu0 = time_us_64();
+  fail = enc_rows(c, ref, at, sp, ep, core0_start, core0_end, emit, ctx);
+  if (!emit)
+    fail |= enc_v(c ? c + KYBER_POLYVECCOMPRESSEDBYTES : NULL,
+                  ref ? ref + KYBER_POLYVECCOMPRESSEDBYTES : NULL,
+                  pkpv, sp, epp, k);
+  tu1 = time_us_64();
+  enc_prof.matmul += (tu1 - tu0);
+  TRACE_JOB("enc.matmul", tu0, tu1);
+
+  // Wait for core1 and cleanup
+  sched_wait_core1();
   t1 = time_us_64();
-  enc_prof.add_reduce += (t1 - t0);
+  enc_prof.phase_matmul += (t1 - t0);
+  TRACE_PHASE("enc.phase_matmul", t0, t1);
 
-  // Securely zeroise all used buffers before packing
+  sched_reset_core1();
+  fail |= mul_data2->fail;
+
+  // Streaming: core1's rows are next in c, then v
+  if (emit)
+  {
+    if (core1_end > core1_start)
+      emit(ctx, c + core1_start * KYBER_POLYCOMPRESSEDBYTES_DU,
+           (core1_end - core1_start) * KYBER_POLYCOMPRESSEDBYTES_DU);
+    tu0 = time_us_64();
+    fail |= enc_v(c + KYBER_POLYVECCOMPRESSEDBYTES, NULL, pkpv, sp, epp, k);
+    tu1 = time_us_64();
+    enc_prof.matmul += (tu1 - tu0);
+    TRACE_JOB("enc.matmul", tu0, tu1);
+    emit(ctx, c + KYBER_POLYVECCOMPRESSEDBYTES, KYBER_POLYCOMPRESSEDBYTES);
+  }
+
+  // Securely zeroise all used buffers
   // memset(at, 0, sizeof(at));  // Zeroise gen_at-related buffer
   // memset(&sp, 0, sizeof(sp));  // Zeroise sp
   // memset(&ep, 0, sizeof(ep)); // Zeroise ep
   // memset(&epp, 0, sizeof(epp));
   // memset(&pkpv, 0, sizeof(pkpv));  // Zeroise pkpv
   // memset(&k, 0, sizeof(k));  // Zeroise k
-  secure_zero(at, sizeof(at));
-  secure_zero(&sp, sizeof(sp));
-  secure_zero(&ep, sizeof(ep));
-  secure_zero(&epp, sizeof(epp));
-  secure_zero(&pkpv, sizeof(pkpv));
-  secure_zero(&k, sizeof(k));
+#if ATC_ENTRIES == 0
+  secure_zero(at, KYBER_K * sizeof(polyvec));
+#endif
+  secure_zero(sp, sizeof(polyvec));
+  secure_zero(ep, sizeof(polyvec));
+  secure_zero(epp, sizeof(poly));
+  secure_zero(pkpv, sizeof(polyvec));
+  secure_zero(k, sizeof(poly));
+
+  ws_release(ws, mark);
+  return fail;
+}
 
-  t0 = time_us_64();
-  pack_ciphertext(c, &b, &v);
-  t1= time_us_64();
-  enc_prof.pack += (t1-t0);
+/*************************************************
+ * Name:        indcpa_enc
+ *
+ * Description: Encryption function of the CPA-secure
+ *              public-key encryption scheme underlying Kyber.
+ *
+ * Arguments:   - uint8_t *c: pointer to output ciphertext
+ *                            (of length KYBER_INDCPA_BYTES bytes)
+ *              - const uint8_t *m: pointer to input message
+ *                                  (of length KYBER_INDCPA_MSGBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                                   (of length KYBER_INDCPA_PUBLICKEYBYTES)
+ *              - const uint8_t *coins: pointer to input random coins used as seed
+ *                                      (of length KYBER_SYMBYTES) to deterministically
+ *                                      generate all randomness
+ **************************************************/
 
-  // Finally, zeroise the remaining sensitive data
-  // memset(&b, 0, sizeof(b)); // Zeroise b
-  // memset(&v, 0, sizeof(v)); // Zeroise v
-  secure_zero(&b, sizeof(b));
-  secure_zero(&v, sizeof(v));
+void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
+                const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                const uint8_t coins[KYBER_SYMBYTES])
+{
+  indcpa_enc_internal(c, NULL, m, pk, NULL, coins, NULL, NULL);
+}
+
+/*************************************************
+ * Name:        indcpa_enc_stream
+ *
+ * Description: indcpa_enc that passes the ciphertext to emit in order,
+ *              each piece as soon as it is final: the rows of u, then v
+ *              (see indcpa_enc_internal)
+ *
+ * Arguments:   - uint8_t *c: pointer to output ciphertext
+ *                            (of length KYBER_INDCPA_BYTES bytes)
+ *              - const uint8_t *m: pointer to input message
+ *              - const uint8_t *pk: pointer to input public key
+ *              - const uint8_t *coins: pointer to input random coins
+ *              - kyber_emit_t emit: called with each piece; the bytes are in c
+ *              - void *ctx: passed to emit
+ **************************************************/
+void indcpa_enc_stream(uint8_t c[KYBER_INDCPA_BYTES],
+                       const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                       const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                       const uint8_t coins[KYBER_SYMBYTES],
+                       kyber_emit_t emit,
+                       void *ctx)
+{
+  indcpa_enc_internal(c, NULL, m, pk, NULL, coins, emit, ctx);
+}
+
+/*************************************************
+ * Name:        indcpa_enc_pk
+ *
+ * Description: indcpa_enc_stream to a public key taken in through
+ *              indcpa_pk_absorb; waits for core1 if it is still
+ *              expanding A^T. Zeroises the unpacked key in p.
+ *
+ * Arguments:   - uint8_t *c: pointer to output ciphertext
+ *                            (of length KYBER_INDCPA_BYTES bytes)
+ *              - const uint8_t *m: pointer to input message
+ *              - indcpa_pk_t *p: pointer to the whole public key
+ *              - const uint8_t *coins: pointer to input random coins
+ *              - kyber_emit_t emit: called with each piece of c, or NULL
+ *              - void *ctx: passed to emit
+ **************************************************/
+void indcpa_enc_pk(uint8_t c[KYBER_INDCPA_BYTES],
+                   const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                   indcpa_pk_t *p,
+                   const uint8_t coins[KYBER_SYMBYTES],
+                   kyber_emit_t emit,
+                   void *ctx)
+{
+  indcpa_enc_internal(c, NULL, m, NULL, p, coins, emit, ctx);
+}
+
+/*************************************************
+ * Name:        indcpa_enc_cmp
+ *
+ * Description: Re-encrypt and compare against a received ciphertext in
+ *              constant time, without materialising the re-encryption;
+ *              used by decapsulation
+ *
+ * Arguments:   - const uint8_t *ct: pointer to the ciphertext to compare
+ *                                   against (of length KYBER_INDCPA_BYTES)
+ *              - const uint8_t *m: pointer to input message
+ *              - const uint8_t *pk: pointer to input public key
+ *              - const uint8_t *coins: pointer to input random coins
+ *
+ * Returns 0 if indcpa_enc(m, pk, coins) equals ct, 1 otherwise
+ **************************************************/
+int indcpa_enc_cmp(const uint8_t ct[KYBER_INDCPA_BYTES],
+                   const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                   const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                   const uint8_t coins[KYBER_SYMBYTES])
+{
+  return indcpa_enc_internal(NULL, ct, m, pk, NULL, coins, NULL, NULL);
 }
 
 /*************************************************
@@ -656,49 +1283,61 @@ void indcpa_dec(uint8_t m[KYBER_INDCPA_MSGBYTES],
                 const uint8_t c[KYBER_INDCPA_BYTES],
                 const uint8_t sk[KYBER_INDCPA_SECRETKEYBYTES])
 {
-  static polyvec b, skpv;
-  static poly v, mp;
+  ws_arena_t *ws = ws_arena();
+  size_t mark = ws_mark(ws);
+  polyvec *b = ws_alloc(ws, sizeof(polyvec));
+  polyvec *skpv = ws_alloc(ws, sizeof(polyvec));
+  poly *v = ws_alloc(ws, sizeof(poly));
+  poly *mp = ws_alloc(ws, sizeof(poly));
 
   uint64_t t0, t1;
   t0 = time_us_64();
-  unpack_ciphertext(&b, &v, c);
-  unpack_sk(&skpv, sk);
+  unpack_ciphertext(b, v, c);
+  unpack_sk(skpv, sk);
   t1 = time_us_64();
   dec_prof.unpack += (t1 - t0);
+  TRACE_JOB("dec.unpack", t0, t1);
 
   t0 = time_us_64();
-  polyvec_ntt(&b);
+  polyvec_ntt(b);
   t1 = time_us_64();
   dec_prof.ntt += (t1 - t0);
+  TRACE_JOB("dec.ntt", t0, t1);
 
   t0 = time_us_64();
-  polyvec_basemul_acc_montgomery(&mp, &skpv, &b);
+  polyvec_basemul_acc_montgomery(mp, skpv, b);
   t1 = time_us_64();
   dec_prof.matmul += (t1 - t0);
+  TRACE_JOB("dec.matmul", t0, t1);
 
   t0 = time_us_64();
-  poly_invntt_tomont(&mp);
+  poly_invntt_tomont(mp);
   t1 = time_us_64();
   dec_prof.invntt += (t1 - t0);
+  TRACE_JOB("dec.invntt", t0, t1);
 
   t0 = time_us_64();
-  poly_sub(&mp, &v, &mp);
-  poly_reduce(&mp);
+  poly_sub(mp, v, mp);
+  poly_reduce(mp);
   t1 = time_us_64();
   dec_prof.sub_reduce += (t1 - t0);
+  TRACE_JOB("dec.sub_reduce", t0, t1);
 
   t0 = time_us_64();
-  poly_tomsg(m, &mp);
+  poly_tomsg(m, mp);
   t1 = time_us_64();
   dec_prof.tomsg += (t1-t0);
+  TRACE_JOB("dec.tomsg", t0, t1);
 
   // zeroise sensitive data
   // memset(&skpv, 0, sizeof(skpv));
   // memset(&b, 0, sizeof(b));
   // memset(&v, 0, sizeof(v));
   // memset(&mp, 0, sizeof(mp));
-  secure_zero(&skpv, sizeof(skpv));
-  secure_zero(&b, sizeof(b));
-  secure_zero(&v, sizeof(v));
-  secure_zero(&mp, sizeof(mp));
+  secure_zero(skpv, sizeof(polyvec));
+  secure_zero(b, sizeof(polyvec));
+  secure_zero(v, sizeof(poly));
+  secure_zero(mp, sizeof(poly));
+
+  ws_release(ws, mark);
 }
@@ -1,9 +1,18 @@
 #ifndef INDCPA_H
 #define INDCPA_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "params.h"
+#include "api.h"
 #include "polyvec.h"
+#include "symmetric.h"
+
+#define rej_uniform KYBER_NAMESPACE(rej_uniform)
+unsigned int rej_uniform(int16_t *r, unsigned int len, const uint8_t *buf, unsigned int buflen);
+
+/* SHAKE128 blocks squeezed up front; enough for one polynomial with high probability */
+#define GEN_MATRIX_NBLOCKS ((12 * KYBER_N / 8 * (1 << 12) / KYBER_Q + XOF_BLOCKBYTES) / XOF_BLOCKBYTES)
 
 #define gen_matrix KYBER_NAMESPACE(gen_matrix)
 void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed);
@@ -11,6 +20,7 @@ void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed);
 #define indcpa_keypair_derand KYBER_NAMESPACE(indcpa_keypair_derand)
 void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
                            uint8_t sk[KYBER_INDCPA_SECRETKEYBYTES],
+                           uint8_t *hpk,
                            const uint8_t coins[KYBER_SYMBYTES]);
 
 #define indcpa_enc KYBER_NAMESPACE(indcpa_enc)
@@ -19,6 +29,56 @@ void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
                 const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
                 const uint8_t coins[KYBER_SYMBYTES]);
 
+#define indcpa_enc_stream KYBER_NAMESPACE(indcpa_enc_stream)
+void indcpa_enc_stream(uint8_t c[KYBER_INDCPA_BYTES],
+                       const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                       const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                       const uint8_t coins[KYBER_SYMBYTES],
+                       kyber_emit_t emit,
+                       void *ctx);
+
+/*
+ * A public key taken in as it arrives, for indcpa_enc_pk: each polynomial
+ * of t is unpacked as soon as its bytes are in, and once the seed at the
+ * end of pk is complete, A^T is looked up in atcache and, on a miss,
+ * expanded on core1 while the caller finishes; the entry only becomes a
+ * hit once indcpa_enc_pk() has waited for it. Any other call that needs
+ * core1 or atcache first abandons the transfer (indcpa_pk_abort), so the
+ * state must stay in place until indcpa_enc_pk() or the abort.
+ */
+typedef struct {
+  polyvec pkpv;
+  uint8_t seed[KYBER_SYMBYTES];
+  uint8_t part[KYBER_POLYBYTES];  /* a polynomial split across pieces */
+  unsigned int fill;              /* pk bytes taken so far */
+  const polyvec *at;              /* A^T, once the seed is in (atcache only) */
+  polyvec *at_fill;               /* matrix core1 is expanding into, or NULL */
+  int at_pending;                 /* core1 still owns at_fill */
+} indcpa_pk_t;
+
+#define indcpa_pk_init KYBER_NAMESPACE(indcpa_pk_init)
+void indcpa_pk_init(indcpa_pk_t *p);
+
+#define indcpa_pk_abort KYBER_NAMESPACE(indcpa_pk_abort)
+void indcpa_pk_abort(indcpa_pk_t *p);
+
+#define indcpa_pk_absorb KYBER_NAMESPACE(indcpa_pk_absorb)
+void indcpa_pk_absorb(indcpa_pk_t *p, const uint8_t *in, size_t len);
+
+#define indcpa_enc_pk KYBER_NAMESPACE(indcpa_enc_pk)
+void indcpa_enc_pk(uint8_t c[KYBER_INDCPA_BYTES],
+                   const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                   indcpa_pk_t *p,
+                   const uint8_t coins[KYBER_SYMBYTES],
+                   kyber_emit_t emit,
+                   void *ctx);
+
+#define indcpa_enc_cmp KYBER_NAMESPACE(indcpa_enc_cmp)
+int indcpa_enc_cmp(const uint8_t ct[KYBER_INDCPA_BYTES],
+                   const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                   const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                   const uint8_t coins[KYBER_SYMBYTES]);
+
 #define indcpa_dec KYBER_NAMESPACE(indcpa_dec)
 void indcpa_dec(uint8_t m[KYBER_INDCPA_MSGBYTES],
                 const uint8_t c[KYBER_INDCPA_BYTES],
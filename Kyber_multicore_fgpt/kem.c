@@ -7,6 +7,8 @@
 #include "verify.h"
 #include "symmetric.h"
 #include "randombytes.h"
+#include "profile.h"
+#include "skcache.h"
 #include <stdio.h>
 
 /*************************************************
@@ -28,9 +30,10 @@ int crypto_kem_keypair_derand(uint8_t *pk,
                               uint8_t *sk,
                               const uint8_t *coins)
 {
-  indcpa_keypair_derand(pk, sk, coins);
+  prof_op = PROF_OP_KEYGEN;
+  /* H(pk) is hashed while pk is packed */
+  indcpa_keypair_derand(pk, sk, sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, coins);
   memcpy(sk + KYBER_INDCPA_SECRETKEYBYTES, pk, KYBER_PUBLICKEYBYTES);
-  hash_h(sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
   /* Value z for pseudo-random output on reject */
   memcpy(sk + KYBER_SECRETKEYBYTES - KYBER_SYMBYTES, coins + KYBER_SYMBYTES, KYBER_SYMBYTES);
 
@@ -59,6 +62,59 @@ int crypto_kem_keypair(uint8_t *pk,
   return rc; // ensure crypto_kem_keypair_derand returns 0 on success
 }
 
+/*************************************************
+ * Name:        crypto_kem_expand_sk
+ *
+ * Description: Rebuilds the full secret key (skpv, pk, H(pk), z) from a
+ *              seed-format secret key by re-running the deterministic
+ *              keygen; the result equals the sk crypto_kem_keypair_derand
+ *              produces from the same coins
+ *
+ * Arguments:   - uint8_t *sk: pointer to output secret key
+ *                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+ *              - const uint8_t *seedsk: pointer to input seed-format secret key
+ *                (KYBER_SEEDSECRETKEYBYTES bytes: d followed by z)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_expand_sk(uint8_t *sk,
+                         const uint8_t *seedsk)
+{
+  /* pk is written straight into its slot in sk */
+  uint8_t *pk = sk + KYBER_INDCPA_SECRETKEYBYTES;
+
+  prof_op = PROF_OP_KEYGEN;
+  indcpa_keypair_derand(pk, sk, sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, seedsk);
+  memcpy(sk + KYBER_SECRETKEYBYTES - KYBER_SYMBYTES, seedsk + KYBER_SYMBYTES, KYBER_SYMBYTES);
+
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_keypair_seed
+ *
+ * Description: Generates a public key and a 64-byte seed-format secret
+ *              key. The expansion made to derive pk is kept in skcache,
+ *              so the first decapsulation does not repeat it.
+ *
+ * Arguments:   - uint8_t *pk: pointer to output public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *              - uint8_t *seedsk: pointer to output seed-format secret key
+ *                (an already allocated array of KYBER_SEEDSECRETKEYBYTES bytes)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_keypair_seed(uint8_t *pk,
+                            uint8_t *seedsk)
+{
+  const uint8_t *sk;
+
+  randombytes(seedsk, KYBER_SEEDSECRETKEYBYTES);
+  sk = skc_get(seedsk);
+  memcpy(pk, sk + KYBER_INDCPA_SECRETKEYBYTES, KYBER_PUBLICKEYBYTES);
+  return 0;
+}
+
 /*************************************************
  * Name:        crypto_kem_enc_derand
  *
@@ -80,6 +136,76 @@ int crypto_kem_enc_derand(uint8_t *ct,
                           uint8_t *ss,
                           const uint8_t *pk,
                           const uint8_t *coins)
+{
+  return crypto_kem_enc_derand_stream(ct, ss, pk, coins, NULL, NULL);
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_derand_stream
+ *
+ * Description: crypto_kem_enc_derand that passes the cipher text to emit
+ *              while it is computed: each row of u as it is compressed,
+ *              then v (see indcpa_enc_stream). A transport can start
+ *              sending the first rows before the last ones exist.
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *              - const uint8_t *coins: pointer to input randomness
+ *                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+ *              - kyber_emit_t emit: called with consecutive pieces of ct,
+ *                on the calling core, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_derand_stream(uint8_t *ct,
+                                 uint8_t *ss,
+                                 const uint8_t *pk,
+                                 const uint8_t *coins,
+                                 kyber_emit_t emit,
+                                 void *ctx)
+{
+  uint8_t hpk[KYBER_SYMBYTES];
+
+  hash_h(hpk, pk, KYBER_PUBLICKEYBYTES);
+  return crypto_kem_enc_derand_hpk(ct, ss, pk, hpk, coins, emit, ctx);
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_derand_hpk
+ *
+ * Description: crypto_kem_enc_derand_stream with H(pk) supplied by the
+ *              caller (crypto_kem_hash_pk, crypto_kem_hpk_seed, or the
+ *              H(pk) field of an expanded secret key), so encapsulating
+ *              to the same key again does not hash the whole pk again
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *              - const uint8_t *hpk: pointer to input H(pk)
+ *                (an already allocated array of KYBER_SYMBYTES bytes)
+ *              - const uint8_t *coins: pointer to input randomness
+ *                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+ *              - kyber_emit_t emit: called with consecutive pieces of ct,
+ *                on the calling core, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_derand_hpk(uint8_t *ct,
+                              uint8_t *ss,
+                              const uint8_t *pk,
+                              const uint8_t *hpk,
+                              const uint8_t *coins,
+                              kyber_emit_t emit,
+                              void *ctx)
 {
   uint8_t buf[2 * KYBER_SYMBYTES];
   /* Will contain key, coins */
@@ -88,11 +214,12 @@ int crypto_kem_enc_derand(uint8_t *ct,
   memcpy(buf, coins, KYBER_SYMBYTES);
 
   /* Multitarget countermeasure for coins + contributory KEM */
-  hash_h(buf + KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+  memcpy(buf + KYBER_SYMBYTES, hpk, KYBER_SYMBYTES);
   hash_g(kr, buf, 2 * KYBER_SYMBYTES);
 
   /* coins are in kr+KYBER_SYMBYTES */
-  indcpa_enc(ct, buf, pk, kr + KYBER_SYMBYTES);
+  prof_op = PROF_OP_ENC;
+  indcpa_enc_stream(ct, buf, pk, kr + KYBER_SYMBYTES, emit, ctx);
 
   memcpy(ss, kr, KYBER_SYMBYTES);
   return 0;
@@ -123,6 +250,249 @@ int crypto_kem_enc(uint8_t *ct,
   return 0;
 }
 
+/*************************************************
+ * Name:        crypto_kem_enc_stream
+ *
+ * Description: crypto_kem_enc with the cipher text passed to emit while
+ *              it is computed (see crypto_kem_enc_derand_stream)
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *              - kyber_emit_t emit: called with consecutive pieces of ct
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_stream(uint8_t *ct,
+                          uint8_t *ss,
+                          const uint8_t *pk,
+                          kyber_emit_t emit,
+                          void *ctx)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand_stream(ct, ss, pk, coins, emit, ctx);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_hpk
+ *
+ * Description: crypto_kem_enc_stream with H(pk) supplied by the caller
+ *              (see crypto_kem_enc_derand_hpk)
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *              - const uint8_t *hpk: pointer to input H(pk)
+ *                (an already allocated array of KYBER_SYMBYTES bytes)
+ *              - kyber_emit_t emit: called with consecutive pieces of ct, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_hpk(uint8_t *ct,
+                       uint8_t *ss,
+                       const uint8_t *pk,
+                       const uint8_t *hpk,
+                       kyber_emit_t emit,
+                       void *ctx)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand_hpk(ct, ss, pk, hpk, coins, emit, ctx);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_hash_pk
+ *
+ * Description: Computes H(pk) once, for crypto_kem_enc_hpk to a key that
+ *              is encapsulated to repeatedly
+ *
+ * Arguments:   - uint8_t *hpk: pointer to output H(pk)
+ *                (an already allocated array of KYBER_SYMBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_hash_pk(uint8_t *hpk,
+                       const uint8_t *pk)
+{
+  hash_h(hpk, pk, KYBER_PUBLICKEYBYTES);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_hpk_seed
+ *
+ * Description: H(pk) of a seed-format secret key's public key, taken from
+ *              its skcache entry, where keygen stored it; no hashing on a
+ *              cache hit (a miss expands the key as crypto_kem_dec_seed does)
+ *
+ * Arguments:   - uint8_t *hpk: pointer to output H(pk)
+ *                (an already allocated array of KYBER_SYMBYTES bytes)
+ *              - const uint8_t *seedsk: pointer to input seed-format secret key
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_hpk_seed(uint8_t *hpk,
+                        const uint8_t *seedsk)
+{
+  const uint8_t *sk = skc_get(seedsk);
+
+  memcpy(hpk, sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, KYBER_SYMBYTES);
+  return 0;
+}
+
+_Static_assert(sizeof(crypto_kem_enc_state) <= CRYPTO_ENCSTATEBYTES, "ENCSTATEBYTES too small");
+
+/*************************************************
+ * Name:        crypto_kem_enc_init
+ *
+ * Description: Starts an encapsulation to a public key that is passed
+ *              in pieces to crypto_kem_enc_update; one still expanding
+ *              A^T on core1 is abandoned (crypto_kem_enc_abort)
+ *
+ * Arguments:   - void *state: pointer to a crypto_kem_enc_state
+ *                (or CRYPTO_ENCSTATEBYTES aligned for uint64_t)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_init(void *state)
+{
+  crypto_kem_enc_state *st = state;
+
+  hash_h_init(&st->h);
+  indcpa_pk_init(&st->pk);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_update
+ *
+ * Description: Takes the next bytes of the public key: absorbs them into
+ *              H(pk) and unpacks what is complete of t; once the seed is
+ *              in, core1 may start expanding A^T (see kem.h)
+ *
+ * Arguments:   - void *state: pointer to the state
+ *              - const uint8_t *pk: pointer to the next bytes of pk
+ *              - size_t len: their number
+ *
+ * Returns 0, or -1 if that would run past KYBER_PUBLICKEYBYTES
+ **************************************************/
+int crypto_kem_enc_update(void *state, const uint8_t *pk, size_t len)
+{
+  crypto_kem_enc_state *st = state;
+
+  if (len > KYBER_PUBLICKEYBYTES - st->pk.fill)
+    return -1;
+  hash_h_absorb(&st->h, pk, len);
+  prof_op = PROF_OP_ENC;
+  indcpa_pk_absorb(&st->pk, pk, len);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_final_derand
+ *
+ * Description: crypto_kem_enc_derand_stream to the public key passed to
+ *              crypto_kem_enc_update; the state is used up
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - void *state: pointer to the state, with all of pk in it
+ *              - const uint8_t *coins: pointer to input randomness
+ *                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+ *              - kyber_emit_t emit: called with consecutive pieces of ct, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0, or -1 if pk is not complete
+ **************************************************/
+int crypto_kem_enc_final_derand(uint8_t *ct,
+                                uint8_t *ss,
+                                void *state,
+                                const uint8_t *coins,
+                                kyber_emit_t emit,
+                                void *ctx)
+{
+  crypto_kem_enc_state *st = state;
+  uint8_t buf[2 * KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2 * KYBER_SYMBYTES];
+
+  if (st->pk.fill != KYBER_PUBLICKEYBYTES)
+    return -1;
+
+  memcpy(buf, coins, KYBER_SYMBYTES);
+
+  /* The last block of H(pk); core1 may still be expanding A^T */
+  hash_h_finalize(buf + KYBER_SYMBYTES, &st->h);
+  hash_g(kr, buf, 2 * KYBER_SYMBYTES);
+
+  prof_op = PROF_OP_ENC;
+  indcpa_enc_pk(ct, buf, &st->pk, kr + KYBER_SYMBYTES, emit, ctx);
+
+  memcpy(ss, kr, KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_final
+ *
+ * Description: crypto_kem_enc_final_derand with fresh coins
+ *
+ * Arguments:   - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of KYBER_SSBYTES bytes)
+ *              - void *state: pointer to the state, with all of pk in it
+ *              - kyber_emit_t emit: called with consecutive pieces of ct, or NULL
+ *              - void *ctx: passed to emit
+ *
+ * Returns 0, or -1 if pk is not complete
+ **************************************************/
+int crypto_kem_enc_final(uint8_t *ct,
+                         uint8_t *ss,
+                         void *state,
+                         kyber_emit_t emit,
+                         void *ctx)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  return crypto_kem_enc_final_derand(ct, ss, state, coins, emit, ctx);
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_abort
+ *
+ * Description: Gives up on an encapsulation whose public key will not be
+ *              completed: waits for core1 if it is still expanding A^T
+ *              and leaves the atcache entry it was filling empty. The
+ *              state needs crypto_kem_enc_init before it is used again.
+ *
+ * Arguments:   - void *state: pointer to the state
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_abort(void *state)
+{
+  crypto_kem_enc_state *st = state;
+
+  indcpa_pk_abort(&st->pk);
+  return 0;
+}
+
 /*************************************************
  * Name:        crypto_kem_dec
  *
@@ -149,19 +519,17 @@ int crypto_kem_dec(uint8_t *ss,
   /* Will contain key, coins */
   uint8_t kr[2 * KYBER_SYMBYTES];
   //  uint8_t cmp[KYBER_CIPHERTEXTBYTES+KYBER_SYMBYTES];
-  uint8_t cmp[KYBER_CIPHERTEXTBYTES];
   const uint8_t *pk = sk + KYBER_INDCPA_SECRETKEYBYTES;
 
+  prof_op = PROF_OP_DEC;
   indcpa_dec(buf, ct, sk);
 
   /* Multitarget countermeasure for coins + contributory KEM */
   memcpy(buf + KYBER_SYMBYTES, sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, KYBER_SYMBYTES);
   hash_g(kr, buf, 2 * KYBER_SYMBYTES);
 
-  /* coins are in kr+KYBER_SYMBYTES */
-  indcpa_enc(cmp, buf, pk, kr + KYBER_SYMBYTES);
-
-  fail = verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
+  /* coins are in kr+KYBER_SYMBYTES; re-encrypt and compare without a ciphertext buffer */
+  fail = indcpa_enc_cmp(ct, buf, pk, kr + KYBER_SYMBYTES);
 
   /* Compute rejection key */
   rkprf(ss, sk + KYBER_SECRETKEYBYTES - KYBER_SYMBYTES, ct);
@@ -171,3 +539,22 @@ int crypto_kem_dec(uint8_t *ss,
 
   return 0;
 }
+
+/*************************************************
+ * Name:        crypto_kem_dec_seed
+ *
+ * Description: crypto_kem_dec for a seed-format secret key; the expanded
+ *              key comes from skcache, which expands it on a miss
+ *
+ * Arguments:   - uint8_t *ss: pointer to output shared secret
+ *              - const uint8_t *ct: pointer to input ciphertext
+ *              - const uint8_t *seedsk: pointer to input seed-format secret key
+ *
+ * Returns 0.
+ **************************************************/
+int crypto_kem_dec_seed(uint8_t *ss,
+                        const uint8_t *ct,
+                        const uint8_t *seedsk)
+{
+  return crypto_kem_dec(ss, ct, skc_get(seedsk));
+}
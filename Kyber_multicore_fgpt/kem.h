@@ -3,11 +3,16 @@
 
 #include <stdint.h>
 #include "params.h"
+#include "api.h"
+#include "indcpa.h"
+#include "symmetric.h"
 
 #define CRYPTO_SECRETKEYBYTES  KYBER_SECRETKEYBYTES
 #define CRYPTO_PUBLICKEYBYTES  KYBER_PUBLICKEYBYTES
 #define CRYPTO_CIPHERTEXTBYTES KYBER_CIPHERTEXTBYTES
 #define CRYPTO_BYTES           KYBER_SSBYTES
+#define CRYPTO_SEEDSECRETKEYBYTES KYBER_SEEDSECRETKEYBYTES
+#define CRYPTO_HPKBYTES        KYBER_SYMBYTES
 
 #if   (KYBER_K == 2)
 #define CRYPTO_ALGNAME "Kyber512"
@@ -29,7 +34,82 @@ int crypto_kem_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uin
 #define crypto_kem_enc KYBER_NAMESPACE(enc)
 int crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
 
+/* Encapsulation that hands the ciphertext to emit (api.h) row by row while
+   the rest is computed; ct and ss are complete on return as with crypto_kem_enc */
+#define crypto_kem_enc_derand_stream KYBER_NAMESPACE(enc_derand_stream)
+int crypto_kem_enc_derand_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins,
+                                 kyber_emit_t emit, void *ctx);
+
+#define crypto_kem_enc_stream KYBER_NAMESPACE(enc_stream)
+int crypto_kem_enc_stream(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kyber_emit_t emit, void *ctx);
+
+/*
+ * H(pk) as an input: keygen hashes pk while packing it and keeps H(pk) in
+ * the secret key (and so in skcache for seed-format keys); a sender that
+ * encapsulates to the same key again passes it to crypto_kem_enc_hpk()
+ * instead of hashing the whole pk on every call.
+ */
+#define crypto_kem_enc_derand_hpk KYBER_NAMESPACE(enc_derand_hpk)
+int crypto_kem_enc_derand_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk,
+                              const uint8_t *coins, kyber_emit_t emit, void *ctx);
+
+#define crypto_kem_enc_hpk KYBER_NAMESPACE(enc_hpk)
+int crypto_kem_enc_hpk(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk,
+                       kyber_emit_t emit, void *ctx);
+
+#define crypto_kem_hash_pk KYBER_NAMESPACE(hash_pk)
+int crypto_kem_hash_pk(uint8_t *hpk, const uint8_t *pk);
+
+#define crypto_kem_hpk_seed KYBER_NAMESPACE(hpk_seed)
+int crypto_kem_hpk_seed(uint8_t *hpk, const uint8_t *seedsk);
+
+/*
+ * Encapsulation to a public key that arrives in pieces, e.g. over a slow
+ * link. crypto_kem_enc_update() takes the bytes of pk in order as they
+ * come in: it absorbs them into H(pk) and unpacks each polynomial of t
+ * once it is complete, and when the seed at the end of pk is in, A^T is
+ * taken from atcache or core1 starts expanding it. crypto_kem_enc_final()
+ * then finishes H(pk) and runs the rest of encapsulation, streaming the
+ * ciphertext to emit if it is set (see crypto_kem_enc_stream).
+ * crypto_kem_enc_abort() gives up on a key that will not be completed,
+ * e.g. after the link dropped. Another enc_init or any other KEM call
+ * before enc_final abandons the transfer the same way, and its enc_final
+ * then fails; the state must stay in place until one of these.
+ */
+typedef struct {
+  hash_state h;   /* H(pk) so far */
+  indcpa_pk_t pk;
+} crypto_kem_enc_state;
+
+#define CRYPTO_ENCSTATEBYTES KYBER_NAMESPACE(ENCSTATEBYTES)
+
+#define crypto_kem_enc_init KYBER_NAMESPACE(enc_init)
+int crypto_kem_enc_init(void *state);
+
+#define crypto_kem_enc_update KYBER_NAMESPACE(enc_update)
+int crypto_kem_enc_update(void *state, const uint8_t *pk, size_t len);
+
+#define crypto_kem_enc_final_derand KYBER_NAMESPACE(enc_final_derand)
+int crypto_kem_enc_final_derand(uint8_t *ct, uint8_t *ss, void *state, const uint8_t *coins,
+                                kyber_emit_t emit, void *ctx);
+
+#define crypto_kem_enc_final KYBER_NAMESPACE(enc_final)
+int crypto_kem_enc_final(uint8_t *ct, uint8_t *ss, void *state, kyber_emit_t emit, void *ctx);
+
+#define crypto_kem_enc_abort KYBER_NAMESPACE(enc_abort)
+int crypto_kem_enc_abort(void *state);
+
 #define crypto_kem_dec KYBER_NAMESPACE(dec)
 int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
 
+/* Seed-format secret keys (d, z); decapsulation expands them through skcache */
+#define crypto_kem_expand_sk KYBER_NAMESPACE(expand_sk)
+int crypto_kem_expand_sk(uint8_t *sk, const uint8_t *seedsk);
+
+#define crypto_kem_keypair_seed KYBER_NAMESPACE(keypair_seed)
+int crypto_kem_keypair_seed(uint8_t *pk, uint8_t *seedsk);
+
+#define crypto_kem_dec_seed KYBER_NAMESPACE(dec_seed)
+int crypto_kem_dec_seed(uint8_t *ss, const uint8_t *ct, const uint8_t *seedsk);
+
 #endif
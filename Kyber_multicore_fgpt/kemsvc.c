@@ -0,0 +1,536 @@
+#ifdef KYBER_HOST
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include "kemsvc.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "hardware/clocks.h"
+#include "profile.h"
+#include "workspace.h"
+#include "kernels.h"
+
+#ifndef KYBER_VARIANT
+#define KYBER_VARIANT "unknown"
+#endif
+
+#define SVC_MAX_REQUEST                                                   \
+    (KYBER_ALG_MAX_PUBLICKEYBYTES > KYBER_ALG_MAX_CIPHERTEXTBYTES          \
+         ? KYBER_ALG_MAX_PUBLICKEYBYTES : KYBER_ALG_MAX_CIPHERTEXTBYTES)
+
+/* Job index core0 sends to make core1's loop return */
+#define SVC_JOB_STOP SVC_QUEUE_DEPTH
+
+typedef struct {
+    uint8_t op;
+    uint8_t alg;
+    uint8_t slot;
+    uint8_t status;
+    uint16_t seq;
+    uint16_t out_len;
+    uint16_t out_ready; /* leading bytes of out that are final, while streaming */
+    uint64_t t_ready;   /* request handed to core1 */
+    uint64_t t_start;   /* core1 picked it up */
+    uint64_t t_done;
+    uint8_t in[SVC_MAX_REQUEST];
+    uint8_t out[SVC_MAX_PAYLOAD];
+} svc_job_t;
+
+typedef struct {
+    uint8_t alg;        /* 0 while empty */
+    uint8_t seedsk[pqcrystals_kyber1024_SEEDSECRETKEYBYTES];
+} svc_slot_t;
+
+svc_stats_t svc_stats;
+
+static const svc_link_t *svc_link;
+static int svc_closed;
+static int svc_streaming = 1;
+
+static svc_job_t svc_jobs[SVC_QUEUE_DEPTH];
+static uint8_t svc_job_busy[SVC_QUEUE_DEPTH];
+static unsigned int svc_pending;
+
+/* Jobs in the order core1 runs and finishes them; the oldest is at svc_head */
+static uint8_t svc_order[SVC_QUEUE_DEPTH];
+static unsigned int svc_head;
+
+/* The oldest job's response while it is being sent ahead of completion */
+static struct {
+    int open;           /* header sent; nothing else may go out until the CRC has */
+    uint16_t sent;      /* payload bytes sent */
+    uint16_t crc;       /* running CRC of the frame */
+    uint64_t t_first;
+} svc_stream;
+
+/* Only core1 touches the slots once the service runs */
+static svc_slot_t svc_slots[SVC_SLOTS];
+
+/* core0's buffers */
+static svc_rx_t svc_rx;
+static uint8_t svc_tx[SVC_MAX_FRAME];
+
+static const char *const svc_op_names[SVC_OP_DEC + 1] = {NULL, "info", "keypair", "enc", "dec"};
+
+/* ================= FRAMES ================= */
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t svc_crc16_update(uint16_t crc, const uint8_t *p, size_t n)
+{
+    unsigned int i;
+
+    while (n--) {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (uint16_t)(crc << 1 ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+uint16_t svc_crc16(const uint8_t *p, size_t n)
+{
+    return svc_crc16_update(0xffff, p, n);
+}
+
+static void svc_header(uint8_t *out, uint8_t op, uint8_t alg, uint8_t arg, uint16_t seq, size_t len)
+{
+    out[0] = SVC_MAGIC;
+    out[1] = op;
+    out[2] = alg;
+    out[3] = arg;
+    put16(out + 4, seq);
+    put16(out + 6, (uint16_t)len);
+}
+
+size_t svc_frame_encode(uint8_t *out, uint8_t op, uint8_t alg, uint8_t arg, uint16_t seq,
+                        const uint8_t *payload, size_t len)
+{
+    svc_header(out, op, alg, arg, seq, len);
+    if (len && payload != out + SVC_HEADER_BYTES)
+        memcpy(out + SVC_HEADER_BYTES, payload, len);
+    put16(out + SVC_HEADER_BYTES + len, svc_crc16(out, SVC_HEADER_BYTES + len));
+    return SVC_HEADER_BYTES + len + SVC_CRC_BYTES;
+}
+
+static void svc_rx_drop(svc_rx_t *rx, size_t n)
+{
+    memmove(rx->buf, rx->buf + n, rx->fill - n);
+    rx->fill -= n;
+}
+
+int svc_rx_next(svc_rx_t *rx, svc_frame_t *f)
+{
+    size_t skip, len;
+
+    for (;;) {
+        for (skip = 0; skip < rx->fill && rx->buf[skip] != SVC_MAGIC; skip++)
+            ;
+        svc_rx_drop(rx, skip);
+        if (rx->fill < SVC_HEADER_BYTES)
+            return 0;
+        len = get16(rx->buf + 6);
+        if (len <= SVC_MAX_PAYLOAD)
+            break;
+        svc_rx_drop(rx, 1); /* not a header after all */
+    }
+
+    f->op = rx->buf[1];
+    f->alg = rx->buf[2];
+    f->arg = rx->buf[3];
+    f->seq = get16(rx->buf + 4);
+    f->len = (uint16_t)len;
+    f->payload = rx->buf + SVC_HEADER_BYTES;
+    if (rx->fill < SVC_HEADER_BYTES + len + SVC_CRC_BYTES)
+        return 0;
+    if (svc_crc16(rx->buf, SVC_HEADER_BYTES + len) != get16(rx->buf + SVC_HEADER_BYTES + len))
+        return -1;
+    return 1;
+}
+
+void svc_rx_consume(svc_rx_t *rx, const svc_frame_t *f)
+{
+    svc_rx_drop(rx, SVC_HEADER_BYTES + f->len + SVC_CRC_BYTES);
+}
+
+/* ================= CORE1 ================= */
+
+/* Publishes each piece of a streamed ciphertext to core0, which sends it */
+static void svc_emit(void *ctx, const uint8_t *bytes, size_t len)
+{
+    svc_job_t *j = ctx;
+
+    __atomic_store_n(&j->out_ready, (uint16_t)(bytes + len - j->out), __ATOMIC_RELEASE);
+}
+
+static uint8_t svc_execute(svc_job_t *j)
+{
+    const kyber_alg_t *alg = kyber_alg(j->alg);
+    svc_slot_t *slot = j->op == SVC_OP_ENC ? NULL : &svc_slots[j->slot];
+
+    switch (j->op) {
+    case SVC_OP_KEYPAIR:
+        slot->alg = 0;
+        if (alg->keypair_seed(j->out, slot->seedsk))
+            return SVC_E_KEM;
+        slot->alg = j->alg;
+        j->out_len = (uint16_t)alg->publickeybytes;
+        return SVC_OK;
+    case SVC_OP_ENC:
+        if (svc_streaming ? alg->enc_stream(j->out, j->out + alg->ciphertextbytes, j->in, svc_emit, j)
+                          : alg->enc(j->out, j->out + alg->ciphertextbytes, j->in))
+            return SVC_E_KEM;
+        j->out_len = (uint16_t)(alg->ciphertextbytes + alg->bytes);
+        return SVC_OK;
+    case SVC_OP_DEC:
+        if (slot->alg != j->alg)
+            return SVC_E_SLOT;
+        if (alg->dec_seed(j->out, j->in, slot->seedsk))
+            return SVC_E_KEM;
+        j->out_len = (uint16_t)alg->bytes;
+        return SVC_OK;
+    default:
+        return SVC_E_OP;
+    }
+}
+
+static void svc_core1(void)
+{
+    uintptr_t idx;
+
+    while ((idx = multicore_fifo_pop_blocking()) != SVC_JOB_STOP) {
+        svc_job_t *j = &svc_jobs[idx];
+
+        j->t_start = time_us_64();
+        j->out_len = 0;
+        j->status = svc_execute(j);
+        j->t_done = time_us_64();
+        multicore_fifo_push_blocking(idx);
+    }
+}
+
+/* ================= CORE0 ================= */
+
+static void svc_write(const uint8_t *p, size_t n)
+{
+    if (!svc_closed && svc_link->write(svc_link->ctx, p, n) < 0)
+        svc_closed = 1;
+}
+
+static void svc_send(uint8_t op, uint8_t alg, uint8_t status, uint16_t seq,
+                     const uint8_t *payload, size_t len)
+{
+    svc_write(svc_tx, svc_frame_encode(svc_tx, op | SVC_OP_RESPONSE, alg, status, seq, payload, len));
+}
+
+/*
+ * Sends what core1 has published of the oldest job's ciphertext. The
+ * header goes out with the first piece: an ENC always succeeds and its
+ * length is fixed by the alg. The rest of the frame follows in
+ * svc_complete().
+ */
+static int svc_stream_pump(void)
+{
+    svc_job_t *j;
+    const kyber_alg_t *alg;
+    uint16_t ready;
+
+    if (!svc_streaming || !svc_pending || svc_closed)
+        return 0;
+    j = &svc_jobs[svc_order[svc_head]];
+    if (j->op != SVC_OP_ENC)
+        return 0;
+    ready = __atomic_load_n(&j->out_ready, __ATOMIC_ACQUIRE);
+    if (ready <= svc_stream.sent)
+        return 0;
+
+    if (!svc_stream.open) {
+        alg = kyber_alg(j->alg);
+        svc_header(svc_tx, j->op | SVC_OP_RESPONSE, j->alg, SVC_OK, j->seq,
+                   alg->ciphertextbytes + alg->bytes);
+        svc_stream.open = 1;
+        svc_stream.crc = svc_crc16_update(0xffff, svc_tx, SVC_HEADER_BYTES);
+        svc_stream.t_first = time_us_64();
+        svc_write(svc_tx, SVC_HEADER_BYTES);
+    }
+    svc_stream.crc = svc_crc16_update(svc_stream.crc, j->out + svc_stream.sent, ready - svc_stream.sent);
+    svc_write(j->out + svc_stream.sent, ready - svc_stream.sent);
+    svc_stream.sent = ready;
+    return 1;
+}
+
+static void svc_info(const svc_frame_t *f)
+{
+    char *p = (char *)svc_tx + SVC_HEADER_BYTES, *end = p + SVC_MAX_PAYLOAD;
+    unsigned int i;
+
+    p += snprintf(p, end - p, "variant=%s\nalgs=", KYBER_VARIANT);
+    for (i = 0; i < kyber_alg_count; i++)
+        p += snprintf(p, end - p, "%s%u", i ? "," : "", (unsigned int)kyber_algs[i].id);
+    p += snprintf(p, end - p, "\nkernels=%s\ncpu=%s\nclock_khz=%u\nqueue_depth=%u\nslots=%u\n"
+                  "requests=%u\nrejected=%u\nqueue_full=%u\nstreaming=%d\nstreamed=%u\n"
+                  "stream_lead_us=%llu\n",
+                  kyber_kernels.name, kernels_cpu(), (unsigned int)(clock_get_hz(clk_sys) / 1000),
+                  SVC_QUEUE_DEPTH, SVC_SLOTS, (unsigned int)svc_stats.requests,
+                  (unsigned int)svc_stats.rejected, (unsigned int)svc_stats.queue_full, svc_streaming,
+                  (unsigned int)svc_stats.streamed, (unsigned long long)svc_stats.stream_lead_us);
+    for (i = SVC_OP_KEYPAIR; i <= SVC_OP_DEC; i++)
+        p += snprintf(p, end - p, "%s_jobs=%u\n%s_queue_us=%llu\n%s_run_us=%llu\n",
+                      svc_op_names[i], (unsigned int)svc_stats.jobs[i],
+                      svc_op_names[i], (unsigned long long)svc_stats.queue_us[i],
+                      svc_op_names[i], (unsigned long long)svc_stats.run_us[i]);
+
+    svc_send(f->op, f->alg, SVC_OK, f->seq, svc_tx + SVC_HEADER_BYTES,
+             (size_t)(p - (char *)svc_tx - SVC_HEADER_BYTES));
+}
+
+static uint8_t svc_check(const svc_frame_t *f)
+{
+    const kyber_alg_t *alg;
+
+    if (f->op < SVC_OP_KEYPAIR || f->op > SVC_OP_DEC)
+        return SVC_E_OP;
+    if (!(alg = kyber_alg(f->alg)))
+        return SVC_E_ALG;
+    if (f->len != (f->op == SVC_OP_ENC ? alg->publickeybytes
+                   : f->op == SVC_OP_DEC ? alg->ciphertextbytes : 0))
+        return SVC_E_LEN;
+    if (f->op != SVC_OP_ENC && f->arg >= SVC_SLOTS)
+        return SVC_E_SLOT;
+    return SVC_OK;
+}
+
+/* Returns 0 if f has to wait: it is answered at once, but a response is half sent */
+static int svc_request(const svc_frame_t *f, int crc_ok)
+{
+    svc_job_t *j;
+    unsigned int idx;
+    uint8_t status;
+
+    status = !crc_ok ? SVC_E_CRC : f->op == SVC_OP_INFO ? SVC_OK : svc_check(f);
+    if (svc_stream.open && (status != SVC_OK || f->op == SVC_OP_INFO))
+        return 0;
+
+    svc_stats.requests++;
+    if (status == SVC_OK && f->op == SVC_OP_INFO) {
+        svc_info(f);
+        return 1;
+    }
+    if (status != SVC_OK) {
+        svc_stats.rejected++;
+        svc_send(f->op, f->alg, status, f->seq, NULL, 0);
+        return 1;
+    }
+
+    for (idx = 0; svc_job_busy[idx]; idx++)
+        ;
+    j = &svc_jobs[idx];
+    j->op = f->op;
+    j->alg = f->alg;
+    j->slot = f->arg;
+    j->seq = f->seq;
+    j->out_ready = 0;
+    memcpy(j->in, f->payload, f->len);
+    svc_job_busy[idx] = 1;
+    svc_order[(svc_head + svc_pending) % SVC_QUEUE_DEPTH] = (uint8_t)idx;
+    svc_pending++;
+    j->t_ready = time_us_64();
+    multicore_fifo_push_blocking(idx);
+    return 1;
+}
+
+static void svc_complete(unsigned int idx)
+{
+    svc_job_t *j = &svc_jobs[idx];
+
+    svc_stats.jobs[j->op]++;
+    svc_stats.queue_us[j->op] += j->t_start - j->t_ready;
+    svc_stats.run_us[j->op] += j->t_done - j->t_start;
+    if (svc_stream.open) {
+        svc_stats.streamed++;
+        svc_stats.stream_lead_us += j->t_done - svc_stream.t_first;
+        svc_stream.crc = svc_crc16_update(svc_stream.crc, j->out + svc_stream.sent,
+                                          j->out_len - svc_stream.sent);
+        memcpy(svc_tx, j->out + svc_stream.sent, j->out_len - svc_stream.sent);
+        put16(svc_tx + j->out_len - svc_stream.sent, svc_stream.crc);
+        svc_write(svc_tx, j->out_len - svc_stream.sent + SVC_CRC_BYTES);
+    } else {
+        svc_send(j->op, j->alg, j->status, j->seq, j->out, j->out_len);
+    }
+    svc_stream.open = 0;
+    svc_stream.sent = 0;
+    svc_job_busy[idx] = 0;
+    svc_head = (svc_head + 1) % SVC_QUEUE_DEPTH;
+    svc_pending--;
+}
+
+void svc_start(const svc_link_t *link)
+{
+    svc_link = link;
+    svc_closed = 0;
+    svc_rx.fill = 0;
+    svc_pending = 0;
+    svc_head = 0;
+    memset(&svc_stream, 0, sizeof(svc_stream));
+    memset(svc_job_busy, 0, sizeof(svc_job_busy));
+    memset(&svc_stats, 0, sizeof(svc_stats));
+
+    /* Every KEM phase runs on core1, out of the whole workspace */
+    sched_set_core1(0);
+    ws_use_single_core(1);
+    multicore_launch_core1(svc_core1);
+}
+
+int svc_poll(void)
+{
+    svc_frame_t f;
+    int moved = 0, n, r;
+
+    while (multicore_fifo_rvalid()) {
+        svc_complete((unsigned int)multicore_fifo_pop_blocking());
+        moved = 1;
+    }
+    moved |= svc_stream_pump();
+
+    n = svc_link->read(svc_link->ctx, svc_rx.buf + svc_rx.fill, sizeof(svc_rx.buf) - svc_rx.fill);
+    if (n < 0)
+        svc_closed = 1;
+    else
+        svc_rx.fill += (size_t)n;
+
+    while (!svc_closed && (r = svc_rx_next(&svc_rx, &f)) != 0) {
+        if (r > 0 && f.op != SVC_OP_INFO && svc_pending == SVC_QUEUE_DEPTH) {
+            svc_stats.queue_full++;
+            break;
+        }
+        if (!svc_request(&f, r > 0))
+            break;
+        svc_rx_consume(&svc_rx, &f);
+        moved = 1;
+    }
+
+    if (svc_closed)
+        return -1;
+    return moved || n > 0;
+}
+
+void svc_set_streaming(int enabled)
+{
+    svc_streaming = enabled;
+}
+
+void svc_stop(void)
+{
+    while (svc_pending)
+        svc_complete((unsigned int)multicore_fifo_pop_blocking());
+    multicore_fifo_push_blocking(SVC_JOB_STOP);
+    multicore_reset_core1();
+
+    ws_use(NULL);
+    sched_set_core1(1);
+}
+
+/* ================= PACED LINK ================= */
+
+static int svc_paced_read(void *ctx, uint8_t *buf, size_t len)
+{
+    svc_pace_t *pace = ctx;
+
+    return pace->inner->read(pace->inner->ctx, buf, len);
+}
+
+static int svc_paced_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    svc_pace_t *pace = ctx;
+    uint64_t now, through;
+    size_t done, n;
+
+    for (done = 0; done < len; done += n) {
+        n = len - done < SVC_PACE_CHUNK ? len - done : SVC_PACE_CHUNK;
+        now = time_us_64();
+        through = (pace->wire_free > now ? pace->wire_free : now)
+                  + (uint64_t)n * 1000000u / pace->bytes_per_s;
+        if (through > now)
+            sleep_us(through - now);
+        pace->wire_free = through;
+        if (pace->inner->write(pace->inner->ctx, buf + done, n) < 0)
+            return -1;
+    }
+    return (int)len;
+}
+
+void svc_link_paced(svc_link_t *link, svc_pace_t *pace, const svc_link_t *inner, uint32_t bytes_per_s)
+{
+    pace->inner = inner;
+    pace->bytes_per_s = bytes_per_s;
+    pace->wire_free = 0;
+    link->read = svc_paced_read;
+    link->write = svc_paced_write;
+    link->ctx = pace;
+}
+
+/* ================= HOST LINK ================= */
+
+#ifdef KYBER_HOST
+
+/* How long an idle read waits for data, so core0 does not spin against core1 */
+#define SVC_FD_IDLE_NS 20000
+
+static int svc_fd_read(void *ctx, uint8_t *buf, size_t len)
+{
+    int fd = *(int *)ctx;
+    struct pollfd p = {fd, POLLIN, 0};
+    struct timespec idle = {0, SVC_FD_IDLE_NS};
+    ssize_t n = len ? read(fd, buf, len) : -1;
+
+    if (n > 0)
+        return (int)n;
+    if (len && (n == 0 || (errno != EAGAIN && errno != EINTR)))
+        return -1;
+    ppoll(&p, len ? 1 : 0, &idle, NULL);
+    return 0;
+}
+
+static int svc_fd_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    int fd = *(int *)ctx;
+    struct pollfd p = {fd, POLLOUT, 0};
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < len) {
+        n = write(fd, buf + done, len - done);
+        if (n > 0)
+            done += (size_t)n;
+        else if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            poll(&p, 1, -1);
+        else
+            return -1;
+    }
+    return (int)len;
+}
+
+void svc_link_fd(svc_link_t *link, int *fd)
+{
+    fcntl(*fd, F_SETFL, fcntl(*fd, F_GETFL) | O_NONBLOCK);
+    link->read = svc_fd_read;
+    link->write = svc_fd_write;
+    link->ctx = fd;
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef KEMSVC_H
+#define KEMSVC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "kyber_alg.h"
+
+/*
+ * KEM co-processor service over a byte stream (USB-CDC on the board).
+ *
+ * The host sends request frames and gets one response frame per request,
+ * matched by sequence number; responses to queued jobs come back in the
+ * order the jobs finish, which is request order unless a request was
+ * rejected on arrival. Every frame is
+ *
+ *   0  magic   SVC_MAGIC (never in the board's ASCII log lines, so a
+ *              reader resynchronises by skipping to it)
+ *   1  op      SVC_OP_*, with SVC_OP_RESPONSE set in responses
+ *   2  alg     kyber_alg_id_t (2, 3 or 4)
+ *   3  slot    key slot of the request; SVC_* status in responses
+ *   4  seq     little-endian, echoed in the response
+ *   6  len     little-endian payload length
+ *   8  payload
+ *      crc     CRC-16/CCITT-FALSE of everything before it, little-endian
+ *
+ *   op       request payload      response payload
+ *   INFO     -                    "key=value" lines: build, algorithms,
+ *                                 kernels, queue and job statistics
+ *   KEYPAIR  -                    pk; the secret key stays in the slot
+ *   ENC      pk                   ct || ss
+ *   DEC      ct                   ss, with the key in the slot
+ *
+ * Secret keys are kept in SVC_SLOTS slots in the 64-byte seed format
+ * (kem.h), expanded through skcache on decapsulation; they never leave
+ * the board.
+ *
+ * Core0 runs svc_poll(): it reads and checks frames, answers INFO and
+ * malformed requests itself, and hands the rest to core1 through a queue
+ * of SVC_QUEUE_DEPTH jobs, passing job indices over the inter-core FIFO
+ * (deep enough for the whole queue, so neither side ever blocks on it).
+ * Core1 runs the jobs one at a time with the KEM's own core1 phases
+ * inline (sched_set_core1(0)) and the whole workspace as its arena, so
+ * receiving the next request and sending the last response overlap with
+ * the computation. When every job is taken, core0 stops reading and the
+ * link's flow control holds the host back.
+ *
+ * ENC responses are streamed (svc_set_streaming): core1 encapsulates with
+ * alg->enc_stream and publishes each row of the ciphertext as it is
+ * compressed, and core0 sends the response header and those rows while
+ * core1 computes the rest, so on a slow link the transfer of the first
+ * rows overlaps the computation of the last ones. The bytes on the wire
+ * are the same frame either way; while one is half sent, responses that
+ * core0 would give at once (INFO, rejects) wait for it.
+ *
+ * The link is a pair of non-blocking read/write callbacks: USB stdio on
+ * the board (kemsvc_main.c), a file descriptor on the host, where
+ * kemsvc_main.c serves a pty and test_kemsvc.c a socketpair, so the same
+ * engine runs without the board. tools/kem_loadgen.py drives either.
+ */
+
+#define SVC_MAGIC 0xa5
+
+#define SVC_OP_INFO     0x01
+#define SVC_OP_KEYPAIR  0x02
+#define SVC_OP_ENC      0x03
+#define SVC_OP_DEC      0x04
+#define SVC_OP_RESPONSE 0x80
+
+/* Response status, in the slot byte */
+#define SVC_OK     0
+#define SVC_E_CRC  1  /* frame failed its CRC; nothing was run */
+#define SVC_E_OP   2  /* unknown op */
+#define SVC_E_ALG  3  /* parameter set not in this build */
+#define SVC_E_LEN  4  /* payload length does not match op and alg */
+#define SVC_E_SLOT 5  /* slot out of range, empty, or holding another alg's key */
+#define SVC_E_KEM  6  /* the KEM call failed */
+
+#define SVC_HEADER_BYTES 8
+#define SVC_CRC_BYTES    2
+
+/* The largest payload is an ENC response */
+#define SVC_MAX_PAYLOAD (KYBER_ALG_MAX_CIPHERTEXTBYTES + 32)
+#define SVC_MAX_FRAME   (SVC_HEADER_BYTES + SVC_MAX_PAYLOAD + SVC_CRC_BYTES)
+
+#ifndef SVC_QUEUE_DEPTH
+#define SVC_QUEUE_DEPTH 4 /* the RP2350's FIFO holds 4 words */
+#endif
+#ifndef SVC_SLOTS
+#define SVC_SLOTS 8
+#endif
+
+/* ================= FRAMES ================= */
+
+typedef struct {
+    uint8_t op;
+    uint8_t alg;
+    uint8_t arg;      /* slot, or status in a response */
+    uint16_t seq;
+    uint16_t len;
+    const uint8_t *payload;
+} svc_frame_t;
+
+uint16_t svc_crc16(const uint8_t *p, size_t n);
+
+/* Writes the frame to out (SVC_HEADER_BYTES + len + SVC_CRC_BYTES); returns its size */
+size_t svc_frame_encode(uint8_t *out, uint8_t op, uint8_t alg, uint8_t arg, uint16_t seq,
+                        const uint8_t *payload, size_t len);
+
+/*
+ * Receive buffer: read into buf + fill, then take frames off the front.
+ * svc_rx_next() returns 1 with a whole frame in f (payload points into
+ * buf), -1 for a frame whose CRC failed (header fields in f), 0 if more
+ * bytes are needed; bytes before the magic and headers announcing more
+ * than SVC_MAX_PAYLOAD are dropped. svc_rx_consume() removes the frame.
+ */
+typedef struct {
+    uint8_t buf[SVC_MAX_FRAME];
+    size_t fill;
+} svc_rx_t;
+
+int svc_rx_next(svc_rx_t *rx, svc_frame_t *f);
+void svc_rx_consume(svc_rx_t *rx, const svc_frame_t *f);
+
+/* ================= SERVICE ================= */
+
+typedef struct {
+    /* Up to len bytes without blocking: the count, 0 if none, -1 once closed */
+    int (*read)(void *ctx, uint8_t *buf, size_t len);
+    /* All len bytes: len, or -1 once closed */
+    int (*write)(void *ctx, const uint8_t *buf, size_t len);
+    void *ctx;
+} svc_link_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t rejected;                /* answered with an error on arrival */
+    uint32_t jobs[SVC_OP_DEC + 1];    /* completed jobs per op */
+    uint64_t queue_us[SVC_OP_DEC + 1]; /* request complete -> core1 start */
+    uint64_t run_us[SVC_OP_DEC + 1];   /* core1 start -> end */
+    uint32_t queue_full;              /* polls that left a request waiting */
+    uint32_t streamed;                /* responses started before their job finished */
+    uint64_t stream_lead_us;          /* first bytes sent -> job end, summed over those */
+} svc_stats_t;
+
+extern svc_stats_t svc_stats;
+
+/* Takes over core1 and the workspace and starts serving link */
+void svc_start(const svc_link_t *link);
+
+/* One round of I/O on core0: 1 if anything moved, 0 if idle, -1 once the link closed */
+int svc_poll(void);
+
+/* Waits for the queued jobs, answers them if the link is still up, and frees core1 */
+void svc_stop(void);
+
+/* Streamed ENC responses, on by default; set before svc_start() */
+void svc_set_streaming(int enabled);
+
+/*
+ * A link that sends through inner no faster than bytes_per_s, to stand in
+ * for a slow wire (a UART, a radio) on a fast one: each write is passed on
+ * in pieces of SVC_PACE_CHUNK bytes, every piece once the wire would have
+ * carried it, so the peer sees the bytes arrive as they would over the
+ * slow link. Reads go straight to inner.
+ */
+#define SVC_PACE_CHUNK 64
+
+typedef struct {
+    const svc_link_t *inner;
+    uint32_t bytes_per_s;
+    uint64_t wire_free;     /* time the last byte written is through */
+} svc_pace_t;
+
+void svc_link_paced(svc_link_t *link, svc_pace_t *pace, const svc_link_t *inner, uint32_t bytes_per_s);
+
+#ifdef KYBER_HOST
+/* Link over a file descriptor (pty, socketpair, pipe), made non-blocking */
+void svc_link_fd(svc_link_t *link, int *fd);
+#endif
+
+#endif
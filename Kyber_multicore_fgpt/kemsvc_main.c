@@ -0,0 +1,159 @@
+/*
+ * KEM co-processor firmware (kemsvc.h).
+ *
+ * On the board the service answers on the USB-CDC port once a host
+ * connects; the log lines printed before it starts are skipped by any
+ * reader that looks for the frame magic. On the host it serves a pty
+ * instead and prints the slave's path, which tools/kem_loadgen.py opens
+ * like the board's /dev/ttyACM0:
+ *
+ *   kemsvc [-r BYTES_PER_S] [-b] [LINK]
+ *
+ *   LINK   also symlink LINK to the pty; runs until SIGINT/SIGTERM
+ *   -r     send no faster than BYTES_PER_S, as over a slow wire (svc_link_paced)
+ *   -b     buffered ENC responses, sent only once the ciphertext is whole
+ */
+#ifdef KYBER_HOST
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "kemsvc.h"
+#include "kernels.h"
+
+#ifndef KYBER_VARIANT
+#define KYBER_VARIANT "unknown"
+#endif
+
+static void svc_banner(void)
+{
+    printf("kemsvc %s: %u parameter sets, kernels %s (%s), clk_sys %u kHz\n",
+           KYBER_VARIANT, kyber_alg_count, kernels_init(), kernels_cpu(),
+           (unsigned int)(clock_get_hz(clk_sys) / 1000));
+}
+
+#ifndef KYBER_HOST
+
+/* USB stdio without CR/LF translation; the SDK buffers and flushes it */
+static int usb_read(void *ctx, uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    int c;
+
+    (void)ctx;
+    while (n < len && (c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+        buf[n++] = (uint8_t)c;
+    return (int)n;
+}
+
+static int usb_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    stdio_put_string((const char *)buf, (int)len, false, false);
+    stdio_flush();
+    return (int)len;
+}
+
+int main(void)
+{
+    static const svc_link_t usb_link = {usb_read, usb_write, NULL};
+
+    stdio_init_all();
+    stdio_usb_init();
+    while (!stdio_usb_connected())
+        sleep_ms(100);
+
+    svc_banner();
+    svc_start(&usb_link);
+    for (;;)
+        svc_poll();
+}
+
+#else
+
+static volatile sig_atomic_t svc_quit;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    svc_quit = 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *link_path;
+    struct termios tio;
+    svc_link_t link, paced_link;
+    svc_pace_t pace;
+    uint32_t bytes_per_s = 0;
+    int master, slave, opt;
+
+    while ((opt = getopt(argc, argv, "r:b")) != -1) {
+        switch (opt) {
+        case 'r':
+            bytes_per_s = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            svc_set_streaming(0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-r BYTES_PER_S] [-b] [LINK]\n", argv[0]);
+            return 2;
+        }
+    }
+    link_path = optind < argc ? argv[optind] : NULL;
+
+    stdio_init_all();
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) {
+        perror("kemsvc: pty");
+        return 1;
+    }
+    /* Holding the slave open keeps the master readable between clients */
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &tio)) {
+        perror("kemsvc: pty slave");
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    if (link_path) {
+        unlink(link_path);
+        if (symlink(ptsname(master), link_path)) {
+            perror(link_path);
+            return 1;
+        }
+    }
+
+    svc_banner();
+    printf("kemsvc: serving on %s\n", link_path ? link_path : ptsname(master));
+    if (bytes_per_s)
+        printf("kemsvc: responses paced to %u B/s\n", (unsigned int)bytes_per_s);
+
+    svc_link_fd(&link, &master);
+    if (bytes_per_s)
+        svc_link_paced(&paced_link, &pace, &link, bytes_per_s);
+    svc_start(bytes_per_s ? &paced_link : &link);
+    while (!svc_quit && svc_poll() >= 0)
+        ;
+    svc_stop();
+
+    if (link_path)
+        unlink(link_path);
+    close(slave);
+    close(master);
+    return 0;
+}
+
+#endif
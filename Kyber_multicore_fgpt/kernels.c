@@ -0,0 +1,191 @@
+#include "kernels.h"
+#include <string.h>
+#include "ntt.h"
+#include "cbd.h"
+#include "fips202.h"
+
+/* Entry points of a backend built with KYBER_BACKEND=b */
+#define KERNELS_DECLARE(b)                                                                   \
+    void pqcrystals_kyber_common_##b##_ntt(int16_t r[256]);                                  \
+    void pqcrystals_kyber_common_##b##_invntt(int16_t r[256]);                               \
+    void pqcrystals_kyber_common_##b##_basemul_montgomery(int16_t r[256], const int16_t a[256], \
+                                                          const int16_t b[256]);             \
+    void pqcrystals_kyber_common_##b##_cbd2(poly *r, const uint8_t buf[2*KYBER_N/4]);        \
+    void pqcrystals_kyber_common_##b##_cbd3(poly *r, const uint8_t buf[3*KYBER_N/4]);        \
+    void pqcrystals_kyber_fips202_##b##_KeccakF1600_StatePermute(uint64_t state[25]);
+
+#define KERNELS_ENTRY(b)                                                                      \
+    {#b, pqcrystals_kyber_common_##b##_ntt, pqcrystals_kyber_common_##b##_invntt,             \
+     pqcrystals_kyber_common_##b##_basemul_montgomery, pqcrystals_kyber_common_##b##_cbd2,    \
+     pqcrystals_kyber_common_##b##_cbd3, pqcrystals_kyber_fips202_##b##_KeccakF1600_StatePermute}
+
+static const kyber_kernels_t kernels_ref = {
+    "ref", ntt, invntt, basemul_montgomery, cbd2, cbd3, KeccakF1600_StatePermute
+};
+
+#ifdef KYBER_KERNELS_X86
+KERNELS_DECLARE(avx2)
+KERNELS_DECLARE(avx512)
+static const kyber_kernels_t kernels_avx2 = KERNELS_ENTRY(avx2);
+static const kyber_kernels_t kernels_avx512 = KERNELS_ENTRY(avx512);
+#endif
+
+const kyber_kernels_t *const kernels_backends[] = {
+    &kernels_ref,
+#ifdef KYBER_KERNELS_X86
+    &kernels_avx2,
+    &kernels_avx512,
+#endif
+};
+
+const unsigned int kernels_backend_count = sizeof(kernels_backends) / sizeof(kernels_backends[0]);
+
+kyber_kernels_t kyber_kernels = {
+    "ref", ntt, invntt, basemul_montgomery, cbd2, cbd3, KeccakF1600_StatePermute
+};
+
+const char *kernels_cpu(void)
+{
+#if defined(KYBER_KERNELS_X86)
+    if (__builtin_cpu_supports("avx512bw"))
+        return "x86-64 avx512bw";
+    if (__builtin_cpu_supports("avx2"))
+        return "x86-64 avx2";
+    return "x86-64";
+#elif defined(KYBER_HOST)
+    return "host";
+#elif defined(__riscv)
+    return "hazard3";
+#elif defined(__arm__)
+    /* SCB CPUID part number */
+    switch ((*(volatile uint32_t *)0xe000ed00u >> 4) & 0xfff) {
+    case 0xc60:
+        return "cortex-m0+";
+    case 0xd21:
+        return "cortex-m33";
+    default:
+        return "arm";
+    }
+#else
+    return "unknown";
+#endif
+}
+
+int kernels_supported(const kyber_kernels_t *k)
+{
+#ifdef KYBER_KERNELS_X86
+    if (k == &kernels_avx2)
+        return __builtin_cpu_supports("avx2");
+    if (k == &kernels_avx512)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    return k == &kernels_ref;
+}
+
+/* ================= SELF-TEST ================= */
+
+#define SELFTEST_ROUNDS 16
+
+/* xorshift32; the inputs only need to vary, not to be unpredictable */
+static uint32_t selftest_rand(uint32_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+/* Coefficients in (-q, q), the range the NTT and base multiplication see */
+static void selftest_poly(int16_t p[256], uint32_t *x)
+{
+    unsigned int i;
+    for (i = 0; i < 256; i++)
+        p[i] = (int16_t)((int32_t)(selftest_rand(x) % (2 * KYBER_Q - 1)) - (KYBER_Q - 1));
+}
+
+unsigned int kernels_selftest(const kyber_kernels_t *k)
+{
+    static poly a, b, r_ref, r;
+    static uint64_t s_ref[25], s[25];
+    uint8_t buf[3 * KYBER_N / 4];
+    uint32_t x = 0x9e3779b9u;
+    unsigned int round, i, fail = 0;
+
+    if (k == &kernels_ref)
+        return 0;
+
+    for (round = 0; round < SELFTEST_ROUNDS; round++) {
+        selftest_poly(a.coeffs, &x);
+        selftest_poly(b.coeffs, &x);
+        for (i = 0; i < sizeof(buf); i++)
+            buf[i] = (uint8_t)selftest_rand(&x);
+        for (i = 0; i < 25; i++)
+            s_ref[i] = (uint64_t)selftest_rand(&x) << 32 | selftest_rand(&x);
+
+        r_ref = a;
+        r = a;
+        kernels_ref.ntt_forward(r_ref.coeffs);
+        k->ntt_forward(r.coeffs);
+        if (memcmp(&r, &r_ref, sizeof(poly)))
+            fail |= KERNEL_NTT;
+
+        r_ref = a;
+        r = a;
+        kernels_ref.ntt_inverse(r_ref.coeffs);
+        k->ntt_inverse(r.coeffs);
+        if (memcmp(&r, &r_ref, sizeof(poly)))
+            fail |= KERNEL_INVNTT;
+
+        kernels_ref.basemul_mont(r_ref.coeffs, a.coeffs, b.coeffs);
+        k->basemul_mont(r.coeffs, a.coeffs, b.coeffs);
+        if (memcmp(&r, &r_ref, sizeof(poly)))
+            fail |= KERNEL_BASEMUL;
+
+        kernels_ref.sample_cbd2(&r_ref, buf);
+        k->sample_cbd2(&r, buf);
+        if (memcmp(&r, &r_ref, sizeof(poly)))
+            fail |= KERNEL_CBD2;
+
+        kernels_ref.sample_cbd3(&r_ref, buf);
+        k->sample_cbd3(&r, buf);
+        if (memcmp(&r, &r_ref, sizeof(poly)))
+            fail |= KERNEL_CBD3;
+
+        memcpy(s, s_ref, sizeof(s));
+        kernels_ref.keccakf1600(s_ref);
+        k->keccakf1600(s);
+        if (memcmp(s, s_ref, sizeof(s)))
+            fail |= KERNEL_KECCAKF1600;
+    }
+    return fail;
+}
+
+/* ================= SELECTION ================= */
+
+int kernels_use(const char *name)
+{
+    unsigned int i;
+
+    for (i = 0; i < kernels_backend_count; i++) {
+        const kyber_kernels_t *k = kernels_backends[i];
+
+        if (strcmp(k->name, name))
+            continue;
+        if (!kernels_supported(k) || kernels_selftest(k))
+            return -1;
+        kyber_kernels = *k;
+        return 0;
+    }
+    return -1;
+}
+
+const char *kernels_init(void)
+{
+    unsigned int i = kernels_backend_count;
+
+    while (i-- > 1)
+        if (!kernels_use(kernels_backends[i]->name))
+            return kyber_kernels.name;
+    kyber_kernels = kernels_ref;
+    return kyber_kernels.name;
+}
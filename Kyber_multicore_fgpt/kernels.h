@@ -0,0 +1,75 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+
+/*
+ * Backend dispatch for the arithmetic and hashing kernels.
+ *
+ * The NTT, the inverse NTT, the polynomial base multiplication, the CBD
+ * samplers and the Keccak permutation are called through kyber_kernels,
+ * one table of function pointers, instead of by name; everything above
+ * them (poly.c, cbd.h, fips202.c) is shared by every backend. A backend is
+ * the kernel sources (reduce.c, ntt.c, cbd.c, keccakf1600.c) compiled
+ * again with KYBER_BACKEND set to its name, so its symbols get their own
+ * namespace, plus an entry in kernels.c. Adding an optimised kernel means
+ * adding a backend, not forking the variant directory.
+ *
+ *   ref     the portable C kernels, on every CPU
+ *   avx2    the same C built for AVX2 (x86-64 host builds)
+ *   avx512  the same C built for AVX-512BW (x86-64 host builds)
+ *
+ * The board has only the ref backend: the RP2350's Cortex-M33 runs it,
+ * and the Cortex-M0+ of an RP2040 would run the same code. kernels_cpu()
+ * names the core either way.
+ *
+ * kyber_kernels holds the ref backend until kernels_init(), which picks
+ * the last backend in kernels_backends[] that the CPU supports and that
+ * passes kernels_selftest(): every kernel against ref on pseudo-random
+ * inputs, bit for bit. kernels_use() forces a backend by name, for the
+ * benchmarks. Both only switch between operations, with core1 idle.
+ */
+
+typedef struct {
+    const char *name;
+    /* Not named after the kernels: ntt.h and cbd.h #define those */
+    void (*ntt_forward)(int16_t r[256]);
+    void (*ntt_inverse)(int16_t r[256]);
+    void (*basemul_mont)(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+    void (*sample_cbd2)(poly *r, const uint8_t buf[2*KYBER_N/4]);
+    void (*sample_cbd3)(poly *r, const uint8_t buf[3*KYBER_N/4]);
+    void (*keccakf1600)(uint64_t state[25]);
+} kyber_kernels_t;
+
+/* Bits of the kernels_selftest() result, in table order */
+#define KERNEL_NTT         (1u << 0)
+#define KERNEL_INVNTT      (1u << 1)
+#define KERNEL_BASEMUL     (1u << 2)
+#define KERNEL_CBD2        (1u << 3)
+#define KERNEL_CBD3        (1u << 4)
+#define KERNEL_KECCAKF1600 (1u << 5)
+
+extern kyber_kernels_t kyber_kernels;
+
+/* Every backend built in, ref first */
+extern const kyber_kernels_t *const kernels_backends[];
+extern const unsigned int kernels_backend_count;
+
+/* Name of the CPU the backends were chosen for */
+const char *kernels_cpu(void);
+
+/* Nonzero if this CPU can run backend k */
+int kernels_supported(const kyber_kernels_t *k);
+
+/* KERNEL_* mask of the kernels of k that differ from ref; 0 is a pass */
+unsigned int kernels_selftest(const kyber_kernels_t *k);
+
+/* Makes the named backend active; -1 if unknown, unsupported or failing */
+int kernels_use(const char *name);
+
+/* Selects the best backend that passes; returns its name */
+const char *kernels_init(void);
+
+#endif
@@ -0,0 +1,35 @@
+#include "kyber_alg.h"
+#include "params.h"
+
+#define KYBER_ALG(id, name, ns)                                              \
+    {id, name, ns##_PUBLICKEYBYTES, ns##_SECRETKEYBYTES, ns##_CIPHERTEXTBYTES, \
+     ns##_BYTES, ns##_SEEDSECRETKEYBYTES, ns##_keypair_derand, ns##_keypair,   \
+     ns##_enc_derand, ns##_enc, ns##_enc_derand_stream, ns##_enc_stream,      \
+     ns##_HPKBYTES, ns##_enc_derand_hpk, ns##_enc_hpk, ns##_hash_pk,          \
+     ns##_hpk_seed, ns##_ENCSTATEBYTES, ns##_enc_init, ns##_enc_update,        \
+     ns##_enc_final_derand, ns##_enc_final, ns##_enc_abort, ns##_dec,          \
+     ns##_expand_sk, ns##_keypair_seed, ns##_dec_seed}
+
+const kyber_alg_t kyber_algs[] = {
+#if defined(KYBER_ALL_K) || KYBER_K == 2
+    KYBER_ALG(KYBER_ALG_512, "Kyber512", pqcrystals_kyber512_ref),
+#endif
+#if defined(KYBER_ALL_K) || KYBER_K == 3
+    KYBER_ALG(KYBER_ALG_768, "Kyber768", pqcrystals_kyber768_ref),
+#endif
+#if defined(KYBER_ALL_K) || KYBER_K == 4
+    KYBER_ALG(KYBER_ALG_1024, "Kyber1024", pqcrystals_kyber1024_ref),
+#endif
+};
+
+const unsigned int kyber_alg_count = sizeof(kyber_algs) / sizeof(kyber_algs[0]);
+
+const kyber_alg_t *kyber_alg(unsigned int id)
+{
+    unsigned int i;
+
+    for (i = 0; i < kyber_alg_count; i++)
+        if ((unsigned int)kyber_algs[i].id == id)
+            return &kyber_algs[i];
+    return NULL;
+}
@@ -0,0 +1,109 @@
+#ifndef KYBER_ALG_H
+#define KYBER_ALG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "api.h"
+
+/*
+ * Parameter set chosen at run time.
+ *
+ * A normal build compiles one parameter set, KYBER_K, and kem.h names its
+ * functions through KYBER_NAMESPACE. With the KYBER_ALL_K CMake option the
+ * K-dependent sources (kem, indcpa, poly, polyvec, symmetric-shake,
+ * skcache, atcache) are compiled once per K into the same image, each
+ * under its own namespace, and the code that does not depend on K (NTT,
+ * reductions, CBD, verify, Keccak, the core1 scheduler and the workspace)
+ * is linked once, under KYBER_COMMON_NAMESPACE; the compression kernels
+ * are inline in compress.h. Each K runs the code and constants of its
+ * single-K build, so its timings are the same; the image grows by the
+ * K-dependent code only.
+ *
+ * kyber_alg() maps an algorithm ID to the sizes and entry points of that
+ * parameter set, so one firmware serves peers at every security level:
+ *
+ *     const kyber_alg_t *alg = kyber_alg(id);
+ *     if (!alg)
+ *         return -1;
+ *     alg->enc(ct, ss, pk);
+ *
+ * A single-K build has only its own entry. The workspace is shared and
+ * sized for the largest K. skcache and atcache are kept per K. atcache
+ * splits its one ATC_BYTES budget between the three (atcache.h), so each
+ * K has fewer A^T entries than in its own build (1 instead of 7/3/1 at
+ * 16 KiB): encapsulating to more than one peer key per level misses more
+ * often. skcache keeps SKC_ENTRIES keys per K, as each level's keys are
+ * distinct, so its RAM is taken three times (14808 bytes at
+ * SKC_ENTRIES=2, against 3400/4936/6472 for K=2/3/4 alone).
+ *
+ * RAM (.bss) of the host build of Kyber_multicore_fgpt, whose large
+ * buffers are the board's (pointers and padding differ): 48692, 61684
+ * and 71764 bytes for K=2, 3 and 4 alone, 77940 bytes with all K
+ * (atcache 14956, skcache 14808).
+ * The board's flash cost of the extra K-dependent code is not measured
+ * here; compare the size of the ELFs of a KYBER_ALL_K board build and a
+ * KYBER_K=4 one (arm-none-eabi-size).
+ */
+
+/* The ID is the module rank */
+typedef enum {
+    KYBER_ALG_512 = 2,
+    KYBER_ALG_768 = 3,
+    KYBER_ALG_1024 = 4
+} kyber_alg_id_t;
+
+typedef struct {
+    kyber_alg_id_t id;
+    const char *name;             /* CRYPTO_ALGNAME */
+    size_t publickeybytes;
+    size_t secretkeybytes;
+    size_t ciphertextbytes;
+    size_t bytes;                 /* shared secret */
+    size_t seedsecretkeybytes;
+    int (*keypair_derand)(uint8_t *pk, uint8_t *sk, const uint8_t *coins);
+    int (*keypair)(uint8_t *pk, uint8_t *sk);
+    int (*enc_derand)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins);
+    int (*enc)(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
+    int (*enc_derand_stream)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins,
+                             kyber_emit_t emit, void *ctx);
+    int (*enc_stream)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kyber_emit_t emit, void *ctx);
+    size_t hpkbytes;              /* H(pk) for enc_hpk (kem.h) */
+    int (*enc_derand_hpk)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk,
+                          const uint8_t *coins, kyber_emit_t emit, void *ctx);
+    int (*enc_hpk)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *hpk,
+                   kyber_emit_t emit, void *ctx);
+    int (*hash_pk)(uint8_t *hpk, const uint8_t *pk);
+    int (*hpk_seed)(uint8_t *hpk, const uint8_t *seedsk);
+    size_t enc_state_bytes;       /* state of enc_init/enc_update/enc_final (kem.h) */
+    int (*enc_init)(void *state);
+    int (*enc_update)(void *state, const uint8_t *pk, size_t len);
+    int (*enc_final_derand)(uint8_t *ct, uint8_t *ss, void *state, const uint8_t *coins,
+                            kyber_emit_t emit, void *ctx);
+    int (*enc_final)(uint8_t *ct, uint8_t *ss, void *state, kyber_emit_t emit, void *ctx);
+    int (*enc_abort)(void *state);
+    int (*dec)(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+    int (*expand_sk)(uint8_t *sk, const uint8_t *seedsk);
+    int (*keypair_seed)(uint8_t *pk, uint8_t *seedsk);
+    int (*dec_seed)(uint8_t *ss, const uint8_t *ct, const uint8_t *seedsk);
+} kyber_alg_t;
+
+/* Buffer sizes that hold any parameter set */
+#define KYBER_ALG_MAX_PUBLICKEYBYTES  pqcrystals_kyber1024_PUBLICKEYBYTES
+#define KYBER_ALG_MAX_SECRETKEYBYTES  pqcrystals_kyber1024_SECRETKEYBYTES
+#define KYBER_ALG_MAX_CIPHERTEXTBYTES pqcrystals_kyber1024_CIPHERTEXTBYTES
+#define KYBER_ALG_MAX_ENCSTATEBYTES   pqcrystals_kyber1024_ENCSTATEBYTES
+
+/* Holds the enc_init state of any parameter set */
+typedef union {
+    uint64_t align;
+    uint8_t bytes[KYBER_ALG_MAX_ENCSTATEBYTES];
+} kyber_alg_enc_state_t;
+
+/* The parameter sets of this build, in increasing K */
+extern const kyber_alg_t kyber_algs[];
+extern const unsigned int kyber_alg_count;
+
+/* Entry for id, or NULL if this build does not include it */
+const kyber_alg_t *kyber_alg(unsigned int id);
+
+#endif
@@ -2,6 +2,7 @@
 #include "params.h"
 #include "ntt.h"
 #include "reduce.h"
+#include "ramfunc.h"
 
 /* Code to generate zetas and zetas_inv used in the number-theoretic transform:
 
@@ -36,7 +37,7 @@ void init_ntt() {
 }
 */
 
-const int16_t zetas[128] = {
+const int16_t KYBER_HOT_DATA("kyber_zetas") zetas[128] = {
   -1044,  -758,  -359, -1517,  1493,  1422,   287,   202,
    -171,   622,  1577,   182,   962, -1202, -1474,  1468,
     573, -1325,   264,   383,  -829,  1458, -1602,  -130,
@@ -65,7 +66,7 @@ const int16_t zetas[128] = {
 *
 * Returns 16-bit integer congruent to a*b*R^{-1} mod q
 **************************************************/
-static int16_t fqmul(int16_t a, int16_t b) {
+static int16_t KYBER_HOT(fqmul)(int16_t a, int16_t b) {
   return montgomery_reduce((int32_t)a*b);
 }
 
@@ -77,7 +78,7 @@ static int16_t fqmul(int16_t a, int16_t b) {
 *
 * Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
 **************************************************/
-void ntt(int16_t r[256]) {
+void KYBER_HOT(ntt)(int16_t r[256]) {
   unsigned int len, start, j, k;
   int16_t t, zeta;
 
@@ -103,7 +104,7 @@ void ntt(int16_t r[256]) {
 *
 * Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
 **************************************************/
-void invntt(int16_t r[256]) {
+void KYBER_HOT(invntt)(int16_t r[256]) {
   unsigned int start, len, j, k;
   int16_t t, zeta;
   const int16_t f = 1441; // mont^2/128
@@ -136,7 +137,7 @@ void invntt(int16_t r[256]) {
 *              - const int16_t b[2]: pointer to the second factor
 *              - int16_t zeta: integer defining the reduction polynomial
 **************************************************/
-void basemul(int16_t r[2], const int16_t a[2], const int16_t b[2], int16_t zeta)
+void KYBER_HOT(basemul)(int16_t r[2], const int16_t a[2], const int16_t b[2], int16_t zeta)
 {
   r[0]  = fqmul(a[1], b[1]);
   r[0]  = fqmul(r[0], zeta);
@@ -144,3 +145,22 @@ void basemul(int16_t r[2], const int16_t a[2], const int16_t b[2], int16_t zeta)
   r[1]  = fqmul(a[0], b[1]);
   r[1] += fqmul(a[1], b[0]);
 }
+
+/*************************************************
+* Name:        basemul_montgomery
+*
+* Description: Multiplication of two polynomials in NTT domain,
+*              basemul over all 64 quadratic factors
+*
+* Arguments:   - int16_t r[256]: pointer to the output polynomial
+*              - const int16_t a[256]: pointer to the first factor
+*              - const int16_t b[256]: pointer to the second factor
+**************************************************/
+void KYBER_HOT(basemul_montgomery)(int16_t r[256], const int16_t a[256], const int16_t b[256])
+{
+  unsigned int i;
+  for(i=0;i<KYBER_N/4;i++) {
+    basemul(&r[4*i], &a[4*i], &b[4*i], zetas[64+i]);
+    basemul(&r[4*i+2], &a[4*i+2], &b[4*i+2], -zetas[64+i]);
+  }
+}
@@ -4,16 +4,19 @@
 #include <stdint.h>
 #include "params.h"
 
-#define zetas KYBER_NAMESPACE(zetas)
+#define zetas KYBER_COMMON_NAMESPACE(zetas)
 extern const int16_t zetas[128];
 
-#define ntt KYBER_NAMESPACE(ntt)
+#define ntt KYBER_COMMON_NAMESPACE(ntt)
 void ntt(int16_t poly[256]);
 
-#define invntt KYBER_NAMESPACE(invntt)
+#define invntt KYBER_COMMON_NAMESPACE(invntt)
 void invntt(int16_t poly[256]);
 
-#define basemul KYBER_NAMESPACE(basemul)
+#define basemul KYBER_COMMON_NAMESPACE(basemul)
 void basemul(int16_t r[2], const int16_t a[2], const int16_t b[2], int16_t zeta);
 
+#define basemul_montgomery KYBER_COMMON_NAMESPACE(basemul_montgomery)
+void basemul_montgomery(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+
 #endif
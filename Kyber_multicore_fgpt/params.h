@@ -17,6 +17,18 @@
 #error "KYBER_K must be in {2,3,4}"
 #endif
 
+/*
+ * Code that does not depend on KYBER_K; a KYBER_ALL_K build links one copy
+ * for all three. The kernel backends (kernels.h) compile the kernels among
+ * it again with KYBER_BACKEND set to their name.
+ */
+#ifndef KYBER_BACKEND
+#define KYBER_BACKEND ref
+#endif
+#define KYBER_CAT4_(a, b, c, d) a##b##c##d
+#define KYBER_CAT4(a, b, c, d) KYBER_CAT4_(a, b, c, d)
+#define KYBER_COMMON_NAMESPACE(s) KYBER_CAT4(pqcrystals_kyber_common_, KYBER_BACKEND, _, s)
+
 #define KYBER_N 256
 #define KYBER_Q 3329
 
@@ -39,6 +51,8 @@
 #define KYBER_POLYCOMPRESSEDBYTES    160
 #define KYBER_POLYVECCOMPRESSEDBYTES (KYBER_K * 352)
 #endif
+/* One polynomial of the compressed u-part */
+#define KYBER_POLYCOMPRESSEDBYTES_DU (KYBER_POLYVECCOMPRESSEDBYTES / KYBER_K)
 
 #define KYBER_ETA2 2
 
@@ -51,5 +65,7 @@
 /* 32 bytes of additional space to save H(pk) */
 #define KYBER_SECRETKEYBYTES  (KYBER_INDCPA_SECRETKEYBYTES + KYBER_INDCPA_PUBLICKEYBYTES + 2*KYBER_SYMBYTES)
 #define KYBER_CIPHERTEXTBYTES (KYBER_INDCPA_BYTES)
+/* Seed-format secret key: the keygen coins (d, z) only, see skcache.h */
+#define KYBER_SEEDSECRETKEYBYTES (2*KYBER_SYMBYTES)
 
 #endif
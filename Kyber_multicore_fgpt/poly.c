@@ -6,6 +6,9 @@
 #include "cbd.h"
 #include "symmetric.h"
 #include "verify.h"
+#include "compress.h"
+#include "kernels.h"
+#include "ramfunc.h"
 
 /*************************************************
 * Name:        poly_compress
@@ -19,49 +22,24 @@
 void poly_compress(uint8_t r[KYBER_POLYCOMPRESSEDBYTES], const poly *a)
 {
   unsigned int i,j;
-  int16_t u;
-  uint32_t d0;
-  uint8_t t[8];
+  uint32_t t[8];
 
 #if (KYBER_POLYCOMPRESSEDBYTES == 128)
-
   for(i=0;i<KYBER_N/8;i++) {
-    for(j=0;j<8;j++) {
-      // map to positive standard representatives
-      u  = a->coeffs[8*i+j];
-      u += (u >> 15) & KYBER_Q;
-/*    t[j] = ((((uint16_t)u << 4) + KYBER_Q/2)/KYBER_Q) & 15; */
-      d0 = u << 4;
-      d0 += 1665;
-      d0 *= 80635;
-      d0 >>= 28;
-      t[j] = d0 & 0xf;
-    }
+    for(j=0;j<8;j++)
+      t[j] = compress_d4(compress_csubq(a->coeffs[8*i+j]));
 
-    r[0] = t[0] | (t[1] << 4);
-    r[1] = t[2] | (t[3] << 4);
-    r[2] = t[4] | (t[5] << 4);
-    r[3] = t[6] | (t[7] << 4);
+    store32_le(r, t[0] | (t[1] << 4) | (t[2] << 8) | (t[3] << 12) |
+                  (t[4] << 16) | (t[5] << 20) | (t[6] << 24) | (t[7] << 28));
     r += 4;
   }
 #elif (KYBER_POLYCOMPRESSEDBYTES == 160)
   for(i=0;i<KYBER_N/8;i++) {
-    for(j=0;j<8;j++) {
-      // map to positive standard representatives
-      u  = a->coeffs[8*i+j];
-      u += (u >> 15) & KYBER_Q;
-/*    t[j] = ((((uint32_t)u << 5) + KYBER_Q/2)/KYBER_Q) & 31; */
-      d0 = u << 5;
-      d0 += 1664;
-      d0 *= 40318;
-      d0 >>= 27;
-      t[j] = d0 & 0x1f;
-    }
+    for(j=0;j<8;j++)
+      t[j] = compress_d5(compress_csubq(a->coeffs[8*i+j]));
 
-    r[0] = (t[0] >> 0) | (t[1] << 5);
-    r[1] = (t[1] >> 3) | (t[2] << 2) | (t[3] << 7);
-    r[2] = (t[3] >> 1) | (t[4] << 4);
-    r[3] = (t[4] >> 4) | (t[5] << 1) | (t[6] << 6);
+    store32_le(r, t[0] | (t[1] << 5) | (t[2] << 10) | (t[3] << 15) |
+                  (t[4] << 20) | (t[5] << 25) | (t[6] << 30));
     r[4] = (t[6] >> 2) | (t[7] << 3);
     r += 5;
   }
@@ -248,6 +226,29 @@ void poly_getnoise_eta2(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t non
   poly_cbd_eta2(r, buf);
 }
 
+/*************************************************
+* Name:        poly_getnoise_eta1_ntt
+*
+* Description: Sample a polynomial like poly_getnoise_eta1 and transform it
+*              to the NTT domain straight away; same result as
+*              poly_getnoise_eta1 followed by poly_ntt, but the polynomial
+*              is transformed while it is still hot instead of in a
+*              separate pass over the whole vector
+*
+* Arguments:   - poly *r: pointer to output polynomial (bitreversed order)
+*              - const uint8_t *seed: pointer to input seed
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t nonce: one-byte input nonce
+**************************************************/
+void poly_getnoise_eta1_ntt(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce)
+{
+  uint8_t buf[KYBER_ETA1*KYBER_N/4];
+  prf(buf, sizeof(buf), seed, nonce);
+  poly_cbd_eta1(r, buf);
+  kyber_kernels.ntt_forward(r->coeffs);
+  poly_reduce(r);
+}
+
 
 /*************************************************
 * Name:        poly_ntt
@@ -260,7 +261,7 @@ void poly_getnoise_eta2(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t non
 **************************************************/
 void poly_ntt(poly *r)
 {
-  ntt(r->coeffs);
+  kyber_kernels.ntt_forward(r->coeffs);
   poly_reduce(r);
 }
 
@@ -275,7 +276,7 @@ void poly_ntt(poly *r)
 **************************************************/
 void poly_invntt_tomont(poly *r)
 {
-  invntt(r->coeffs);
+  kyber_kernels.ntt_inverse(r->coeffs);
 }
 
 /*************************************************
@@ -287,13 +288,9 @@ void poly_invntt_tomont(poly *r)
 *              - const poly *a: pointer to first input polynomial
 *              - const poly *b: pointer to second input polynomial
 **************************************************/
-void poly_basemul_montgomery(poly *r, const poly *a, const poly *b)
+void KYBER_HOT(poly_basemul_montgomery)(poly *r, const poly *a, const poly *b)
 {
-  unsigned int i;
-  for(i=0;i<KYBER_N/4;i++) {
-    basemul(&r->coeffs[4*i], &a->coeffs[4*i], &b->coeffs[4*i], zetas[64+i]);
-    basemul(&r->coeffs[4*i+2], &a->coeffs[4*i+2], &b->coeffs[4*i+2], -zetas[64+i]);
-  }
+  kyber_kernels.basemul_mont(r->coeffs, a->coeffs, b->coeffs);
 }
 
 /*************************************************
@@ -336,7 +333,7 @@ void poly_reduce(poly *r)
 *            - const poly *a: pointer to first input polynomial
 *            - const poly *b: pointer to second input polynomial
 **************************************************/
-void poly_add(poly *r, const poly *a, const poly *b)
+void KYBER_HOT(poly_add)(poly *r, const poly *a, const poly *b)
 {
   unsigned int i;
   for(i=0;i<KYBER_N;i++)
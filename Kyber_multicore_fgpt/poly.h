@@ -33,6 +33,9 @@ void poly_getnoise_eta1(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t non
 #define poly_getnoise_eta2 KYBER_NAMESPACE(poly_getnoise_eta2)
 void poly_getnoise_eta2(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce);
 
+#define poly_getnoise_eta1_ntt KYBER_NAMESPACE(poly_getnoise_eta1_ntt)
+void poly_getnoise_eta1_ntt(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce);
+
 #define poly_ntt KYBER_NAMESPACE(poly_ntt)
 void poly_ntt(poly *r);
 #define poly_invntt_tomont KYBER_NAMESPACE(poly_invntt_tomont)
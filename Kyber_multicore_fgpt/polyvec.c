@@ -2,80 +2,69 @@
 #include "params.h"
 #include "poly.h"
 #include "polyvec.h"
+#include "workspace.h"
+#include "ramfunc.h"
+#include "compress.h"
 
 /*************************************************
-* Name:        polyvec_compress
+* Name:        poly_compress_du
 *
-* Description: Compress and serialize vector of polynomials
+* Description: Compress and serialize one polynomial of a vector with
+*              KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K bytes per polynomial;
+*              lets the caller consume the u-part one polynomial at a time
 *
 * Arguments:   - uint8_t *r: pointer to output byte array
-*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES)
-*              - const polyvec *a: pointer to input vector of polynomials
+*                            (needs space for KYBER_POLYCOMPRESSEDBYTES_DU)
+*              - const poly *a: pointer to input polynomial
 **************************************************/
-void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+void poly_compress_du(uint8_t r[KYBER_POLYCOMPRESSEDBYTES_DU], const poly *a)
 {
-  unsigned int i,j,k;
-  uint64_t d0;
+  unsigned int j,k;
+  uint32_t t[8];
 
 #if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
-  uint16_t t[8];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/8;j++) {
-      for(k=0;k<8;k++) {
-        t[k]  = a->vec[i].coeffs[8*j+k];
-        t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
-/*      t[k]  = ((((uint32_t)t[k] << 11) + KYBER_Q/2)/KYBER_Q) & 0x7ff; */
-        d0 = t[k];
-        d0 <<= 11;
-        d0 += 1664;
-        d0 *= 645084;
-        d0 >>= 31;
-        t[k] = d0 & 0x7ff;
-      }
-
-      r[ 0] = (t[0] >>  0);
-      r[ 1] = (t[0] >>  8) | (t[1] << 3);
-      r[ 2] = (t[1] >>  5) | (t[2] << 6);
-      r[ 3] = (t[2] >>  2);
-      r[ 4] = (t[2] >> 10) | (t[3] << 1);
-      r[ 5] = (t[3] >>  7) | (t[4] << 4);
-      r[ 6] = (t[4] >>  4) | (t[5] << 7);
-      r[ 7] = (t[5] >>  1);
-      r[ 8] = (t[5] >>  9) | (t[6] << 2);	
-      r[ 9] = (t[6] >>  6) | (t[7] << 5);
-      r[10] = (t[7] >>  3);
-      r += 11;
-    }
+  for(j=0;j<KYBER_N/8;j++) {
+    for(k=0;k<8;k++)
+      t[k] = compress_d11(compress_csubq(a->coeffs[8*j+k]));
+
+    store32_le(r,     t[0] | (t[1] << 11) | (t[2] << 22));
+    store32_le(r + 4, (t[2] >> 10) | (t[3] << 1) | (t[4] << 12) | (t[5] << 23));
+    store16_le(r + 8, (t[5] >> 9) | (t[6] << 2) | (t[7] << 13));
+    r[10] = t[7] >> 3;
+    r += 11;
   }
 #elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
-  uint16_t t[4];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/4;j++) {
-      for(k=0;k<4;k++) {
-        t[k]  = a->vec[i].coeffs[4*j+k];
-        t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
-/*      t[k]  = ((((uint32_t)t[k] << 10) + KYBER_Q/2)/ KYBER_Q) & 0x3ff; */
-        d0 = t[k];
-        d0 <<= 10;
-        d0 += 1665;
-        d0 *= 1290167;
-        d0 >>= 32;
-        t[k] = d0 & 0x3ff;
-      }
-
-      r[0] = (t[0] >> 0);
-      r[1] = (t[0] >> 8) | (t[1] << 2);
-      r[2] = (t[1] >> 6) | (t[2] << 4);
-      r[3] = (t[2] >> 4) | (t[3] << 6);
-      r[4] = (t[3] >> 2);
-      r += 5;
-    }
+  for(j=0;j<KYBER_N/8;j++) {
+    for(k=0;k<8;k++)
+      t[k] = compress_d10(compress_csubq(a->coeffs[8*j+k]));
+
+    store32_le(r,     t[0] | (t[1] << 10) | (t[2] << 20) | (t[3] << 30));
+    store32_le(r + 4, (t[3] >> 2) | (t[4] << 8) | (t[5] << 18) | (t[6] << 28));
+    store16_le(r + 8, (t[6] >> 4) | (t[7] << 6));
+    r += 10;
   }
 #else
 #error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
 #endif
 }
 
+/*************************************************
+* Name:        polyvec_compress
+*
+* Description: Compress and serialize vector of polynomials
+*
+* Arguments:   - uint8_t *r: pointer to output byte array
+*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES)
+*              - const polyvec *a: pointer to input vector of polynomials
+**************************************************/
+void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_K;i++)
+    poly_compress_du(r + i*KYBER_POLYCOMPRESSEDBYTES_DU, &a->vec[i]);
+}
+
 /*************************************************
 * Name:        polyvec_decompress
 *
@@ -200,18 +189,22 @@ void polyvec_invntt_tomont(polyvec *r)
 *            - const polyvec *a: pointer to first input vector of polynomials
 *            - const polyvec *b: pointer to second input vector of polynomials
 **************************************************/
-void polyvec_basemul_acc_montgomery(poly *r, const polyvec *a, const polyvec *b)
+void KYBER_HOT(polyvec_basemul_acc_montgomery)(poly *r, const polyvec *a, const polyvec *b)
 {
   unsigned int i;
-  poly t;
+  // Runs on both cores at once, so t comes from the caller's own scratch
+  ws_arena_t *ws = ws_local();
+  size_t mark = ws_mark(ws);
+  poly *t = ws_alloc(ws, sizeof(poly));
 
   poly_basemul_montgomery(r, &a->vec[0], &b->vec[0]);
   for(i=1;i<KYBER_K;i++) {
-    poly_basemul_montgomery(&t, &a->vec[i], &b->vec[i]);
-    poly_add(r, r, &t);
+    poly_basemul_montgomery(t, &a->vec[i], &b->vec[i]);
+    poly_add(r, r, t);
   }
 
   poly_reduce(r);
+  ws_release(ws, mark);
 }
 
 /*************************************************
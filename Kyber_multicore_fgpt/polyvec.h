@@ -9,6 +9,8 @@ typedef struct{
   poly vec[KYBER_K];
 } polyvec;
 
+#define poly_compress_du KYBER_NAMESPACE(poly_compress_du)
+void poly_compress_du(uint8_t r[KYBER_POLYCOMPRESSEDBYTES_DU], const poly *a);
 #define polyvec_compress KYBER_NAMESPACE(polyvec_compress)
 void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a);
 #define polyvec_decompress KYBER_NAMESPACE(polyvec_decompress)
@@ -0,0 +1,179 @@
+#include "powerpolicy.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/clocks.h"
+#include "hardware/vreg.h"
+#include "energy.h"
+
+/* Regulator settling time before the clock may go up */
+#ifndef POWER_VREG_SETTLE_US
+#define POWER_VREG_SETTLE_US 1000
+#endif
+
+const char *const power_preset_names[POWER_PRESET_COUNT] = {"min-latency", "min-energy", "deadline"};
+
+static const struct {
+    uint32_t clock_khz;
+    uint16_t mv;
+} power_points[] = {POWER_POINTS};
+
+#define POWER_NPOINTS (sizeof(power_points) / sizeof(power_points[0]))
+
+static uint16_t power_mv = POWER_DEFAULT_MV;
+
+/* Profiled work of one operation, in cycles of the profiling clock */
+typedef struct {
+    double wall;          /* with core1 */
+    double active[2];
+    double serial_wall;   /* without core1 */
+} op_cycles_t;
+
+static void op_cycles(op_cycles_t *w, prof_op_t op, double op_us, int runs)
+{
+    energy_coeffs_t c;
+    energy_part_t parts[ENERGY_PARTS];
+    const energy_part_t *total = &parts[ENERGY_PART_TOTAL];
+    double mhz, handoff = 0;
+    int ph;
+
+    energy_coeffs(&c);
+    energy_estimate(&c, op, op_us, runs, parts);
+    mhz = c.clock_khz / 1000.0;
+
+    for (ph = 0; ph < PROF_PHASE_COUNT; ph++)
+        handoff += (sched_prof[op][ph].launch + sched_prof[op][ph].reset) / (double)runs;
+
+    w->wall = total->wall_us * mhz;
+    w->active[0] = total->active_us[0] * mhz;
+    w->active[1] = total->active_us[1] * mhz;
+    /* core0's active time includes launching and resetting core1 */
+    w->serial_wall = (total->active_us[0] + total->active_us[1] - handoff) * mhz;
+}
+
+static void predict(power_point_t *pt, const op_cycles_t *w, uint32_t khz, uint16_t mv, int core1)
+{
+    double mhz = khz / 1000.0;
+    double v = mv / (double)ENERGY_FIT_MV;
+    double scale = khz / (double)ENERGY_FIT_CLOCK_KHZ * v * v;
+    double a0, a1;
+
+    pt->clock_khz = khz;
+    pt->mv = mv;
+    pt->core1 = (uint8_t)core1;
+    if (core1) {
+        pt->pred_us = w->wall / mhz;
+        a0 = w->active[0] / mhz;
+        a1 = w->active[1] / mhz;
+    } else {
+        pt->pred_us = w->serial_wall / mhz;
+        a0 = pt->pred_us;
+        a1 = 0;
+    }
+    pt->pred_uj = (ENERGY_BASE_MW * pt->pred_us +
+                   scale * (ENERGY_CORE0_MW * a0 + ENERGY_CORE1_MW * a1)) / 1000.0;
+}
+
+void power_policy_plan(kyber_power_policy_t *p, power_preset_t preset, uint32_t deadline_us,
+                       const double op_us[PROF_OP_COUNT], int runs)
+{
+    op_cycles_t w;
+    power_point_t pt, fastest = {0}, best = {0};
+    unsigned int i;
+    int op, core1, have;
+
+    p->preset = preset;
+    p->deadline_us = deadline_us;
+
+    for (op = 0; op < PROF_OP_COUNT; op++) {
+        op_cycles(&w, (prof_op_t)op, op_us[op], runs);
+        have = 0;
+
+        for (i = 0; i < POWER_NPOINTS; i++) {
+            for (core1 = 1; core1 >= 0; core1--) {
+                predict(&pt, &w, power_points[i].clock_khz, power_points[i].mv, core1);
+
+                if ((i == 0 && core1) || pt.pred_us < fastest.pred_us)
+                    fastest = pt;
+
+                if (preset == POWER_MIN_LATENCY)
+                    continue;
+                if (preset == POWER_DEADLINE && pt.pred_us > deadline_us)
+                    continue;
+                if (!have || pt.pred_uj < best.pred_uj) {
+                    best = pt;
+                    have = 1;
+                }
+            }
+        }
+
+        p->op[op] = have ? best : fastest;
+        p->met[op] = p->op[op].pred_us <= deadline_us || preset != POWER_DEADLINE;
+    }
+}
+
+/* The VSEL codes from 0.85 V to 1.30 V are consecutive, 50 mV apart */
+static enum vreg_voltage power_vsel(uint16_t mv)
+{
+    if (mv < 850)
+        mv = 850;
+    if (mv > 1300)
+        mv = 1300;
+    return (enum vreg_voltage)(VREG_VOLTAGE_0_85 + (mv - 850) / 50);
+}
+
+static int power_apply(uint32_t khz, uint16_t mv)
+{
+    uint16_t old_mv = power_mv;
+
+    if (mv > power_mv) {
+        vreg_set_voltage(power_vsel(mv));
+        power_mv = mv;
+        busy_wait_us(POWER_VREG_SETTLE_US);
+    }
+
+    if (khz != clock_get_hz(clk_sys) / 1000 && !set_sys_clock_khz(khz, false)) {
+        if (power_mv != old_mv) {
+            vreg_set_voltage(power_vsel(old_mv));
+            power_mv = old_mv;
+        }
+        return -1;
+    }
+
+    if (mv < power_mv) {
+        vreg_set_voltage(power_vsel(mv));
+        power_mv = mv;
+    }
+    return 0;
+}
+
+int power_policy_enter(const kyber_power_policy_t *p, prof_op_t op)
+{
+    const power_point_t *pt = &p->op[op];
+
+    if (power_apply(pt->clock_khz, pt->mv))
+        return -1;
+    sched_set_core1(pt->core1);
+    return 0;
+}
+
+void power_policy_exit(void)
+{
+    sched_set_core1(1);
+    power_apply(POWER_DEFAULT_CLOCK_KHZ, POWER_DEFAULT_MV);
+}
+
+void power_policy_print(const kyber_power_policy_t *p)
+{
+    int op;
+
+    for (op = 0; op < PROF_OP_COUNT; op++) {
+        const power_point_t *pt = &p->op[op];
+
+        printf("%s,%" PRIu32 ",%s,%" PRIu32 ",%u,%u,%.2f,%.2f,%u\n",
+               power_preset_names[p->preset], p->deadline_us, prof_op_names[op],
+               pt->clock_khz, (unsigned int)pt->mv, (unsigned int)pt->core1,
+               pt->pred_us, pt->pred_uj, (unsigned int)p->met[op]);
+    }
+}
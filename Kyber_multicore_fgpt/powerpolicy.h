@@ -0,0 +1,96 @@
+#ifndef POWERPOLICY_H
+#define POWERPOLICY_H
+
+#include <stdint.h>
+#include "profile.h"
+
+/*
+ * Clock, core voltage and core1 use per KEM operation.
+ *
+ * power_policy_plan() picks an operating point for keygen, enc and dec
+ * from the averages of a profiled run at the current clock with core1 in
+ * use (sched_prof, the same input as energy.h) and the energy model
+ * coefficients. Each candidate clock has the lowest core voltage it is
+ * run at (POWER_POINTS); with or without core1 it predicts
+ *
+ *   time   = cycles / f, the profiled cycles, or without core1 the work
+ *            of both cores back to back minus the launch/reset hand-off
+ *   energy = base * time + core increments * active time, the increments
+ *            scaled by f / f_fit and (V / V_fit)^2
+ *
+ * and keeps the point the preset asks for:
+ *
+ *   POWER_MIN_LATENCY  shortest predicted time
+ *   POWER_MIN_ENERGY   least predicted energy
+ *   POWER_DEADLINE     least energy within deadline_us per operation,
+ *                      the shortest time if no point meets it
+ *
+ * With the board's constant draw in the base term, the lowest-energy point
+ * tends to be the fastest clock a given voltage allows, and core1 pays only
+ * where its share of the phases outweighs the launch/reset hand-off, which
+ * is least likely for the small K=2 operations.
+ * tools/power_policy.py runs the same model on a serial log.
+ *
+ * power_policy_enter() applies an operation's point around one call or a
+ * whole batch; power_policy_exit() returns to the default clock and
+ * voltage with core1 enabled. The voltage is raised before the clock goes
+ * up and lowered after it comes down. A clock change relocks the PLL, so
+ * entering once per batch is cheaper than once per operation.
+ *
+ * The voltage per clock is conservative and not characterised per part;
+ * override POWER_POINTS for a board that has been.
+ */
+
+#ifndef POWER_DEFAULT_CLOCK_KHZ
+#define POWER_DEFAULT_CLOCK_KHZ 150000
+#endif
+
+#ifndef POWER_DEFAULT_MV
+#define POWER_DEFAULT_MV 1100
+#endif
+
+/* {clock_khz, mv}; every clock must be exact from the 12 MHz crystal */
+#ifndef POWER_POINTS
+#define POWER_POINTS \
+    {48000, 950}, {64000, 950}, {96000, 1000}, {120000, 1050}, {150000, 1100}
+#endif
+
+typedef enum {
+    POWER_MIN_LATENCY,
+    POWER_MIN_ENERGY,
+    POWER_DEADLINE,
+    POWER_PRESET_COUNT
+} power_preset_t;
+
+extern const char *const power_preset_names[POWER_PRESET_COUNT];
+
+typedef struct {
+    uint32_t clock_khz;
+    uint16_t mv;
+    uint8_t core1;        /* 0: core1 stays in reset, its jobs run on core0 */
+    double pred_us;
+    double pred_uj;
+} power_point_t;
+
+typedef struct {
+    power_preset_t preset;
+    uint32_t deadline_us;
+    power_point_t op[PROF_OP_COUNT];
+    uint8_t met[PROF_OP_COUNT];   /* the point meets the deadline */
+} kyber_power_policy_t;
+
+/*
+ * op_us are per-call averages over runs calls, profiled at the current
+ * clock with core1 enabled
+ */
+void power_policy_plan(kyber_power_policy_t *p, power_preset_t preset, uint32_t deadline_us,
+                       const double op_us[PROF_OP_COUNT], int runs);
+
+/* Returns 0, or -1 if the clock could not be set (nothing is changed then) */
+int power_policy_enter(const kyber_power_policy_t *p, prof_op_t op);
+void power_policy_exit(void);
+
+/* Rows of the "# POWER POLICY" CSV block, one per operation */
+void power_policy_print(const kyber_power_policy_t *p);
+
+#endif
@@ -1,13 +1,172 @@
 #include "profile.h"
 #include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "trace.h"
 
 keygen_profile_t kg_prof;
 enc_profile_t enc_prof;
 dec_profile_t dec_prof;
 
+sched_profile_t sched_prof[PROF_OP_COUNT][PROF_PHASE_COUNT];
+volatile prof_op_t prof_op;
+
+const char *const prof_op_names[PROF_OP_COUNT] = {"keygen", "enc", "dec"};
+const char *const prof_phase_names[PROF_PHASE_COUNT] = {"hash_genA", "frommsg", "noise", "matmul", "pack"};
+
+/* Phase the current core1 job belongs to; set by core0 at launch */
+static volatile prof_phase_t sched_phase;
+
+/* Hand-off timestamps, each written by one core and read by the other
+   after the FIFO word that orders them */
+static volatile uint64_t stamp_push;
+static volatile uint64_t stamp_done;
+
+/* Phase and job start, each private to the core that writes it */
+static uint64_t stamp_launch;
+static uint64_t stamp_start;
+
+/* Settles a job left running on core1 (sched_hold_core1), or NULL */
+static void (*sched_settle)(void);
+
+/* Core1 disabled: the entry and its job wait for core0 in sched_wait_core1 */
+static int sched_inline;
+static void (*inline_entry)(void);
+static uintptr_t inline_job;
+
+static sched_profile_t *sched_cur(void)
+{
+    return &sched_prof[prof_op][sched_phase];
+}
+
 void profile_reset(void)
 {
     memset(&kg_prof, 0, sizeof(kg_prof));
     memset(&enc_prof, 0, sizeof(enc_prof));
     memset(&dec_prof, 0, sizeof(dec_prof));
+    memset(sched_prof, 0, sizeof(sched_prof));
+}
+
+void sched_set_core1(int enabled)
+{
+    sched_inline = !enabled;
+}
+
+int sched_core1_enabled(void)
+{
+    return !sched_inline;
+}
+
+void sched_hold_core1(void (*settle)(void))
+{
+    sched_settle = settle;
+}
+
+void sched_settle_core1(void)
+{
+    void (*settle)(void) = sched_settle;
+
+    sched_settle = NULL;
+    if (settle)
+        settle();
+}
+
+void sched_launch_core1(prof_phase_t phase, void (*entry)(void))
+{
+    uint64_t t0, t1;
+
+    sched_settle_core1();
+    sched_phase = phase;
+    t0 = time_us_64();
+    stamp_launch = t0;
+    if (sched_inline) {
+        inline_entry = entry;
+        return;
+    }
+    multicore_launch_core1(entry);
+    t1 = time_us_64();
+    sched_cur()->launch += t1 - t0;
+    TRACE_SYNC("core1_launch", t0, t1);
+}
+
+void sched_push_job(uintptr_t job)
+{
+    if (sched_inline) {
+        inline_job = job;
+        return;
+    }
+    stamp_push = time_us_64();
+    multicore_fifo_push_blocking(job);
+}
+
+void sched_wait_core1(void)
+{
+    sched_profile_t *s = sched_cur();
+    uint64_t t0, t1;
+
+    if (sched_inline) {
+        inline_entry();
+        s->jobs++;
+        return;
+    }
+
+    t0 = time_us_64();
+    multicore_fifo_pop_blocking();
+    t1 = time_us_64();
+    s->core0_blocked += t1 - t0;
+    s->completion += t1 - stamp_done;
+    s->jobs++;
+    TRACE_WAIT("core0.wait_core1", t0, t1);
+}
+
+void sched_reset_core1(void)
+{
+    sched_profile_t *s = sched_cur();
+    uint64_t t0, t1;
+
+    sched_settle = NULL;
+    if (sched_inline) {
+        s->wall += time_us_64() - stamp_launch;
+        return;
+    }
+
+    t0 = time_us_64();
+    multicore_reset_core1();
+    t1 = time_us_64();
+    s->reset += t1 - t0;
+    s->wall += t1 - stamp_launch;
+    TRACE_SYNC("core1_reset", t0, t1);
+}
+
+uintptr_t sched_core1_get_job(void)
+{
+    sched_profile_t *s = sched_cur();
+    uintptr_t job;
+    uint64_t t0, t1;
+
+    if (sched_inline)
+        return inline_job;
+
+    t0 = time_us_64();
+    job = multicore_fifo_pop_blocking();
+    t1 = time_us_64();
+    s->core1_blocked += t1 - t0;
+    s->dispatch += t1 - stamp_push;
+    TRACE_WAIT("core1.wait_job", t0, t1);
+    stamp_start = t1;
+    return job;
+}
+
+void sched_core1_job_done(void)
+{
+    uint64_t t;
+
+    if (sched_inline)
+        return;
+
+    t = time_us_64();
+    sched_cur()->core1_active += t - stamp_start;
+    stamp_done = t;
+    multicore_fifo_push_blocking(1);
 }
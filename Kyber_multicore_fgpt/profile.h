@@ -7,8 +7,7 @@
 
 typedef struct {
     /* Core0 local work */
-    uint64_t noise;
-    uint64_t ntt;
+    uint64_t noise;       /* sampling and forward NTT, fused */
     uint64_t add_reduce;
 
     /* Parallel phase wall times */
@@ -28,20 +27,23 @@ typedef struct {
 typedef struct {
     uint64_t unpack;
     uint64_t gen_at;
-    uint64_t noise;
-    uint64_t ntt;
-    uint64_t invntt;
-    uint64_t add_reduce;
-    uint64_t pack;
+    uint64_t noise;       /* core0's lanes, sampling and forward NTT */
+    uint64_t matmul;      /* core0's rows and v, matmul through compression */
 
     /* Parallel phase wall times */
     uint64_t phase_frommsg;
+    uint64_t phase_noise;
     uint64_t phase_matmul;
 
     /* Core1 actual compute */
     uint64_t core1_frommsg;
+    uint64_t core1_noise;
     uint64_t core1_matmul;
 
+    /* Public-matrix cache (atcache.h) */
+    uint32_t at_hits;
+    uint32_t at_misses;
+
 } enc_profile_t;
 
 /* ================= DEC ================= */
@@ -55,6 +57,78 @@ typedef struct {
     uint64_t tomsg;
 } dec_profile_t;
 
+/* ================= CORE HAND-OFF ================= */
+
+/*
+ * Measured cost of moving work between the cores, accumulated per KEM
+ * operation and per parallel phase. indcpa_enc runs inside decapsulation
+ * as well, so kem.c sets prof_op to attribute its phases correctly.
+ */
+
+typedef enum {
+    PROF_OP_KEYGEN,
+    PROF_OP_ENC,
+    PROF_OP_DEC,
+    PROF_OP_COUNT
+} prof_op_t;
+
+typedef enum {
+    PROF_PHASE_HASH_GENA,
+    PROF_PHASE_FROMMSG,
+    PROF_PHASE_NOISE,
+    PROF_PHASE_MATMUL,
+    PROF_PHASE_PACK,
+    PROF_PHASE_COUNT
+} prof_phase_t;
+
+typedef struct {
+    uint64_t launch;        /* core0 inside multicore_launch_core1 */
+    uint64_t reset;         /* core0 inside multicore_reset_core1 */
+    uint64_t dispatch;      /* core0 push -> core1 job start */
+    uint64_t completion;    /* core1 job end -> core0 pop return */
+    uint64_t core0_blocked; /* core0 waiting for core1's result */
+    uint64_t core1_blocked; /* core1 waiting for its job descriptor */
+    uint64_t core1_active;  /* core1 job start -> job end */
+    uint64_t wall;          /* core0 launch start -> reset end */
+    uint32_t jobs;
+} sched_profile_t;
+
+extern sched_profile_t sched_prof[PROF_OP_COUNT][PROF_PHASE_COUNT];
+extern volatile prof_op_t prof_op;
+
+extern const char *const prof_op_names[PROF_OP_COUNT];
+extern const char *const prof_phase_names[PROF_PHASE_COUNT];
+
+/* core0 side */
+void sched_launch_core1(prof_phase_t phase, void (*entry)(void));
+void sched_push_job(uintptr_t job);
+void sched_wait_core1(void);
+void sched_reset_core1(void);
+
+/*
+ * A job left running on core1 after the call that launched it returns
+ * (the A^T expansion of an incremental encapsulation), or state that the
+ * next call must not disturb (the atcache entry such an encapsulation
+ * hit). settle must wait for the job and reset core1, or let the state
+ * go; sched_settle_core1() calls it, and so does the next
+ * sched_launch_core1(), unless sched_reset_core1() came first. KEM entry
+ * points settle before touching anything the holder relies on.
+ */
+void sched_hold_core1(void (*settle)(void));
+void sched_settle_core1(void);
+
+/*
+ * With core1 disabled, core1 stays in reset and each job runs on core0
+ * inside sched_wait_core1(), after core0's own share; the phase's wall
+ * time then counts as core0 active. Change only between operations.
+ */
+void sched_set_core1(int enabled);
+int sched_core1_enabled(void);
+
+/* core1 side */
+uintptr_t sched_core1_get_job(void);
+void sched_core1_job_done(void);
+
 extern keygen_profile_t kg_prof;
 extern enc_profile_t enc_prof;
 extern dec_profile_t dec_prof;
@@ -0,0 +1,34 @@
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+#include "pico/platform.h"
+
+/*
+ * Execute-from-SRAM placement for the hot kernels.
+ *
+ * By default everything runs from XIP flash through the cache, which the
+ * two cores share; when they run different code at once they evict each
+ * other's lines. With KYBER_RAM_KERNELS the functions and tables marked
+ * here are linked into .time_critical sections, which crt0 copies to SRAM
+ * at boot, so they never miss in the XIP cache.
+ *
+ * The set follows the phase profile (test_kyber_fgpt) and bench_primitives:
+ * matrix generation (KeccakF1600_StatePermute, rej_uniform), the matmul
+ * (basemul, poly_basemul_montgomery, polyvec_basemul_acc_montgomery,
+ * poly_add), the transforms (ntt, invntt, fqmul) and the reductions they
+ * call on every coefficient, plus the zetas and Keccak round-constant
+ * tables they read. The SRAM cost shows up as the "ramcode" column of
+ * tools/mem_map_report.py.
+ *
+ * The host shim defines the section macros away.
+ */
+
+#ifdef KYBER_RAM_KERNELS
+#define KYBER_HOT(func) __not_in_flash_func(func)
+#define KYBER_HOT_DATA(name) __not_in_flash(name)
+#else
+#define KYBER_HOT(func) func
+#define KYBER_HOT_DATA(name)
+#endif
+
+#endif
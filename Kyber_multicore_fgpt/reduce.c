@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include "params.h"
 #include "reduce.h"
+#include "ramfunc.h"
 
 /*************************************************
 * Name:        montgomery_reduce
@@ -13,7 +14,7 @@
 *
 * Returns:     integer in {-q+1,...,q-1} congruent to a * R^-1 modulo q.
 **************************************************/
-int16_t montgomery_reduce(int32_t a)
+int16_t KYBER_HOT(montgomery_reduce)(int32_t a)
 {
   int16_t t;
 
@@ -32,7 +33,7 @@ int16_t montgomery_reduce(int32_t a)
 *
 * Returns:     integer in {-(q-1)/2,...,(q-1)/2} congruent to a modulo q.
 **************************************************/
-int16_t barrett_reduce(int16_t a) {
+int16_t KYBER_HOT(barrett_reduce)(int16_t a) {
   int16_t t;
   const int16_t v = ((1<<26) + KYBER_Q/2)/KYBER_Q;
 
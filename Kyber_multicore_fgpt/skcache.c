@@ -0,0 +1,61 @@
+#include "skcache.h"
+#include <string.h>
+#include "pico/time.h"
+#include "kem.h"
+#include "verify.h"
+
+typedef struct {
+    uint8_t seed[KYBER_SEEDSECRETKEYBYTES];
+    uint8_t sk[KYBER_SECRETKEYBYTES];
+    uint32_t last_use; /* 0 = empty */
+} skc_entry_t;
+
+static skc_entry_t skc[SKC_ENTRIES];
+static uint32_t skc_clock;
+
+skc_stats_t skc_stats;
+
+const uint8_t *skc_get(const uint8_t seedsk[KYBER_SEEDSECRETKEYBYTES])
+{
+    skc_entry_t *e = NULL;
+    skc_entry_t *victim = &skc[0];
+    uint64_t t0;
+    unsigned int i;
+
+    /* compare against every entry so the lookup time does not depend on where the key is */
+    for (i = 0; i < SKC_ENTRIES; i++)
+    {
+        int diff = verify(skc[i].seed, seedsk, KYBER_SEEDSECRETKEYBYTES);
+        if (skc[i].last_use && !diff)
+            e = &skc[i];
+        if (skc[i].last_use < victim->last_use)
+            victim = &skc[i];
+    }
+
+    if (e)
+    {
+        skc_stats.hits++;
+    }
+    else
+    {
+        e = victim;
+        if (e->last_use)
+            skc_stats.evictions++;
+        skc_stats.misses++;
+
+        t0 = time_us_64();
+        crypto_kem_expand_sk(e->sk, seedsk);
+        skc_stats.expand_us += time_us_64() - t0;
+        memcpy(e->seed, seedsk, KYBER_SEEDSECRETKEYBYTES);
+    }
+
+    e->last_use = ++skc_clock;
+    return e->sk;
+}
+
+void skc_clear(void)
+{
+    secure_zero(skc, sizeof(skc));
+    skc_clock = 0;
+    memset(&skc_stats, 0, sizeof(skc_stats));
+}
@@ -0,0 +1,47 @@
+#ifndef SKCACHE_H
+#define SKCACHE_H
+
+#include <stdint.h>
+#include "params.h"
+
+/*
+ * Expansion cache for seed-format secret keys.
+ *
+ * A seed-format key is the 64-byte keygen input (d, z) instead of the
+ * KYBER_SECRETKEYBYTES expanded key, which holds skpv, the whole pk and
+ * H(pk) on top. Decapsulation needs the expanded form; skc_get() returns
+ * it from a small LRU cache in RAM and, on a miss, rebuilds it with
+ * crypto_kem_expand_sk() (one deterministic keygen) and evicts the least
+ * recently used entry.
+ *
+ * Seeds are compared with verify(), so a lookup does not leak how much of
+ * a cached seed matches. The cache holds key material: skc_clear()
+ * zeroises it. Core0 only; the expansion itself uses core1.
+ */
+
+#ifndef SKC_ENTRIES
+#define SKC_ENTRIES 2
+#endif
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;      /* each one is an expansion */
+    uint32_t evictions;
+    uint64_t expand_us;   /* total time spent expanding */
+} skc_stats_t;
+
+#define skc_stats KYBER_NAMESPACE(skc_stats)
+extern skc_stats_t skc_stats;
+
+/* Expanded secret key for seedsk; valid until the next skc_get() or skc_clear() */
+#define skc_get KYBER_NAMESPACE(skc_get)
+const uint8_t *skc_get(const uint8_t seedsk[KYBER_SEEDSECRETKEYBYTES]);
+
+/* Zeroises every entry and the statistics */
+#define skc_clear KYBER_NAMESPACE(skc_clear)
+void skc_clear(void);
+
+/* Bytes of RAM the cache occupies */
+#define SKC_BYTES (SKC_ENTRIES * (KYBER_SEEDSECRETKEYBYTES + KYBER_SECRETKEYBYTES))
+
+#endif
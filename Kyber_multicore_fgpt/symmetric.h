@@ -8,6 +8,7 @@
 #include "fips202.h"
 
 typedef keccak_state xof_state;
+typedef keccak_state hash_state;
 
 #define kyber_shake128_absorb KYBER_NAMESPACE(kyber_shake128_absorb)
 void kyber_shake128_absorb(keccak_state *s,
@@ -25,6 +26,9 @@ void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SY
 
 #define hash_h(OUT, IN, INBYTES) sha3_256(OUT, IN, INBYTES)
 #define hash_g(OUT, IN, INBYTES) sha3_512(OUT, IN, INBYTES)
+#define hash_h_init(STATE) sha3_256_init(STATE)
+#define hash_h_absorb(STATE, IN, INBYTES) sha3_256_absorb(STATE, IN, INBYTES)
+#define hash_h_finalize(OUT, STATE) sha3_256_finalize(OUT, STATE)
 #define xof_absorb(STATE, SEED, X, Y) kyber_shake128_absorb(STATE, SEED, X, Y)
 #define xof_squeezeblocks(OUT, OUTBLOCKS, STATE) shake128_squeezeblocks(OUT, OUTBLOCKS, STATE)
 #define prf(OUT, OUTBYTES, KEY, NONCE) kyber_shake256_prf(OUT, OUTBYTES, KEY, NONCE)
@@ -0,0 +1,417 @@
+/*
+ * KEM service protocol test (host build only).
+ *
+ * Runs the service engine of kemsvc.c over one end of a socketpair, as
+ * the board runs it over USB, and a client in a forked process on the
+ * other end:
+ *
+ *   - INFO, then KEYPAIR / ENC / DEC for every parameter set of the build,
+ *     with the DEC shared secret checked against the service's own ENC
+ *     and against an encapsulation by this process's copy of the KEM
+ *   - a burst of requests sent without waiting, deeper than the job queue,
+ *     all of which must come back, each once
+ *   - rejects: bad CRC, unknown op, alg and length mismatches, empty and
+ *     out-of-range slots, and a valid frame after garbage bytes
+ *
+ * ENC responses are streamed, as by default on the board.
+ *
+ *   test_kemsvc -r BYTES_PER_S [-n ENCS]
+ *
+ * instead paces the service's side of the link to BYTES_PER_S, a slow
+ * wire, and times ENC requests one at a time (request written -> first
+ * byte and -> whole response read) with buffered and then with streamed
+ * responses, so the reduction in end-to-end latency from sending the
+ * first rows of the ciphertext while the last are computed shows; each
+ * ciphertext is checked with a DEC on the service.
+ *
+ * The service exits when the client closes its end. Exits non-zero on any
+ * failure, so it runs under ctest.
+ */
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "kemsvc.h"
+
+/* Requests in the pipelined burst */
+#define BURST 24
+
+/* Whole test, in seconds, before it counts as hung */
+#define TIMEOUT_S 120
+
+/* Timed ENC requests per mode with -r */
+#define PACED_ENCS 50
+
+typedef struct {
+    double first_us;    /* request written -> first response byte, summed */
+    double total_us;    /* request written -> whole response, summed */
+    unsigned int n;
+} paced_result_t;
+
+static int cli_fd;
+static svc_rx_t cli_rx;
+static uint8_t cli_tx[SVC_MAX_FRAME];
+static uint16_t cli_seq;
+static unsigned int failures;
+
+#define CHECK(cond, ...)                                \
+    do {                                                \
+        if (!(cond)) {                                  \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                        \
+            printf("\n");                               \
+            failures++;                                 \
+        }                                               \
+    } while (0)
+
+/* ================= CLIENT ================= */
+
+static void cli_write(const uint8_t *p, size_t n)
+{
+    ssize_t w;
+
+    while (n) {
+        if ((w = write(cli_fd, p, n)) <= 0) {
+            perror("client write");
+            exit(1);
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+static uint16_t cli_send(uint8_t op, uint8_t alg, uint8_t slot, const uint8_t *payload, size_t len)
+{
+    uint16_t seq = cli_seq++;
+
+    cli_write(cli_tx, svc_frame_encode(cli_tx, op, alg, slot, seq, payload, len));
+    return seq;
+}
+
+/* Blocks for the next response; the caller consumes it. t_first, if set,
+   gets the time the first bytes after the previous response came in (left
+   as it is if they were already buffered). 0, or -1 once the link closed */
+static int cli_recv_timed(svc_frame_t *f, uint64_t *t_first)
+{
+    ssize_t n;
+
+    while (svc_rx_next(&cli_rx, f) <= 0) {
+        n = read(cli_fd, cli_rx.buf + cli_rx.fill, sizeof(cli_rx.buf) - cli_rx.fill);
+        if (n <= 0) {
+            printf("client: service closed the link\n");
+            return -1;
+        }
+        if (t_first && !cli_rx.fill)
+            *t_first = time_us_64();
+        cli_rx.fill += (size_t)n;
+    }
+    return 0;
+}
+
+static void cli_recv(svc_frame_t *f)
+{
+    if (cli_recv_timed(f, NULL))
+        exit(1);
+}
+
+/* One request and its response; returns the status and copies the payload to out */
+static uint8_t cli_call(uint8_t op, uint8_t alg, uint8_t slot, const uint8_t *payload, size_t len,
+                        uint8_t *out, size_t *out_len)
+{
+    uint16_t seq = cli_send(op, alg, slot, payload, len);
+    svc_frame_t f;
+    uint8_t status;
+
+    cli_recv(&f);
+    CHECK(f.seq == seq && f.op == (op | SVC_OP_RESPONSE),
+          "response op 0x%02x seq %u to op 0x%02x seq %u", f.op, f.seq, op, seq);
+    status = f.arg;
+    if (out)
+        memcpy(out, f.payload, f.len);
+    if (out_len)
+        *out_len = f.len;
+    svc_rx_consume(&cli_rx, &f);
+    return status;
+}
+
+static void test_info(void)
+{
+    static uint8_t text[SVC_MAX_PAYLOAD + 1];
+    size_t n;
+
+    CHECK(cli_call(SVC_OP_INFO, 0, 0, NULL, 0, text, &n) == SVC_OK, "info");
+    text[n] = 0;
+    CHECK(strstr((char *)text, "queue_depth=") != NULL, "info text: %s", text);
+}
+
+static void test_kem(const kyber_alg_t *alg, uint8_t slot)
+{
+    static uint8_t pk[KYBER_ALG_MAX_PUBLICKEYBYTES], ct[KYBER_ALG_MAX_CIPHERTEXTBYTES + 32];
+    static uint8_t ss[32], ss_dec[32];
+    size_t n;
+
+    CHECK(cli_call(SVC_OP_KEYPAIR, alg->id, slot, NULL, 0, pk, &n) == SVC_OK, "%s keypair", alg->name);
+    CHECK(n == alg->publickeybytes, "%s pk length %zu", alg->name, n);
+
+    CHECK(cli_call(SVC_OP_ENC, alg->id, 0, pk, alg->publickeybytes, ct, &n) == SVC_OK,
+          "%s enc", alg->name);
+    CHECK(n == alg->ciphertextbytes + alg->bytes, "%s enc length %zu", alg->name, n);
+    CHECK(cli_call(SVC_OP_DEC, alg->id, slot, ct, alg->ciphertextbytes, ss_dec, &n) == SVC_OK,
+          "%s dec", alg->name);
+    CHECK(n == alg->bytes && !memcmp(ss_dec, ct + alg->ciphertextbytes, alg->bytes),
+          "%s dec of the service's ct", alg->name);
+
+    alg->enc(ct, ss, pk);
+    CHECK(cli_call(SVC_OP_DEC, alg->id, slot, ct, alg->ciphertextbytes, ss_dec, &n) == SVC_OK,
+          "%s dec", alg->name);
+    CHECK(n == alg->bytes && !memcmp(ss_dec, ss, alg->bytes), "%s dec of a local ct", alg->name);
+
+    /* The slot holds this alg's key only */
+    if (kyber_alg_count > 1) {
+        const kyber_alg_t *other = &kyber_algs[alg == &kyber_algs[0]];
+
+        CHECK(cli_call(SVC_OP_DEC, other->id, slot, ct, other->ciphertextbytes, NULL, NULL)
+                  == SVC_E_SLOT, "%s key used as %s", alg->name, other->name);
+    }
+}
+
+static void test_burst(const kyber_alg_t *alg, uint8_t slot)
+{
+    static uint8_t pk[KYBER_ALG_MAX_PUBLICKEYBYTES];
+    uint8_t seen[BURST] = {0};
+    uint16_t first;
+    svc_frame_t f;
+    unsigned int i;
+
+    CHECK(cli_call(SVC_OP_KEYPAIR, alg->id, slot, NULL, 0, pk, NULL) == SVC_OK, "burst keypair");
+
+    first = cli_seq;
+    for (i = 0; i < BURST; i++)
+        cli_send(SVC_OP_ENC, alg->id, 0, pk, alg->publickeybytes);
+    for (i = 0; i < BURST; i++) {
+        uint16_t k;
+
+        cli_recv(&f);
+        k = (uint16_t)(f.seq - first);
+        CHECK(k < BURST && !seen[k] && f.arg == SVC_OK && f.len == alg->ciphertextbytes + alg->bytes,
+              "burst response seq %u status %u", f.seq, f.arg);
+        if (k < BURST)
+            seen[k] = 1;
+        svc_rx_consume(&cli_rx, &f);
+    }
+}
+
+static void test_rejects(const kyber_alg_t *alg)
+{
+    static const uint8_t garbage[] = "boot log line\r\n\x01\x02";
+    static uint8_t ct[KYBER_ALG_MAX_CIPHERTEXTBYTES];
+    svc_frame_t f;
+    size_t n;
+
+    /* Flip one payload bit after the CRC is computed */
+    memset(ct, 0x5a, sizeof(ct));
+    n = svc_frame_encode(cli_tx, SVC_OP_DEC, alg->id, 0, cli_seq, ct, alg->ciphertextbytes);
+    cli_tx[SVC_HEADER_BYTES + 3] ^= 1;
+    cli_write(cli_tx, n);
+    cli_recv(&f);
+    CHECK(f.seq == cli_seq && f.arg == SVC_E_CRC, "bad crc -> status %u", f.arg);
+    svc_rx_consume(&cli_rx, &f);
+    cli_seq++;
+
+    CHECK(cli_call(0x7f, alg->id, 0, NULL, 0, NULL, NULL) == SVC_E_OP, "unknown op");
+    CHECK(cli_call(SVC_OP_KEYPAIR, 9, 0, NULL, 0, NULL, NULL) == SVC_E_ALG, "unknown alg");
+    CHECK(cli_call(SVC_OP_DEC, alg->id, 0, ct, alg->ciphertextbytes - 1, NULL, NULL) == SVC_E_LEN,
+          "short ct");
+    CHECK(cli_call(SVC_OP_KEYPAIR, alg->id, 0, ct, 1, NULL, NULL) == SVC_E_LEN, "keypair payload");
+    CHECK(cli_call(SVC_OP_KEYPAIR, alg->id, SVC_SLOTS, NULL, 0, NULL, NULL) == SVC_E_SLOT,
+          "slot out of range");
+    CHECK(cli_call(SVC_OP_DEC, alg->id, SVC_SLOTS - 1, ct, alg->ciphertextbytes, NULL, NULL)
+              == SVC_E_SLOT, "empty slot");
+
+    cli_write(garbage, sizeof(garbage) - 1);
+    CHECK(cli_call(SVC_OP_INFO, 0, 0, NULL, 0, NULL, NULL) == SVC_OK, "frame after garbage");
+}
+
+static int client(void)
+{
+    unsigned int a;
+
+    test_info();
+    for (a = 0; a < kyber_alg_count; a++)
+        test_kem(&kyber_algs[a], (uint8_t)a);
+    test_burst(&kyber_algs[0], SVC_SLOTS - 2);
+    test_rejects(&kyber_algs[0]);
+
+    close(cli_fd);
+    return failures ? 1 : 0;
+}
+
+/* ================= PACED LINK ================= */
+
+static unsigned int paced_encs = PACED_ENCS;
+static paced_result_t *paced_result;
+
+/* ENC to the largest parameter set, one request at a time */
+static int client_paced(void)
+{
+    static uint8_t pk[KYBER_ALG_MAX_PUBLICKEYBYTES], ct[KYBER_ALG_MAX_CIPHERTEXTBYTES + 32];
+    const kyber_alg_t *alg = &kyber_algs[kyber_alg_count - 1];
+    uint8_t ss[32];
+    uint64_t t0, t_first, t_end;
+    svc_frame_t f;
+    unsigned int i;
+    size_t n;
+
+    CHECK(cli_call(SVC_OP_KEYPAIR, alg->id, 0, NULL, 0, pk, NULL) == SVC_OK, "%s keypair", alg->name);
+    for (i = 0; i < paced_encs && !failures; i++) {
+        t0 = time_us_64();
+        t_first = t0;
+        cli_send(SVC_OP_ENC, alg->id, 0, pk, alg->publickeybytes);
+        if (cli_recv_timed(&f, &t_first)) {
+            CHECK(0, "no response to enc %u", i);
+            break;
+        }
+        t_end = time_us_64();
+        CHECK(f.op == (SVC_OP_ENC | SVC_OP_RESPONSE) && f.arg == SVC_OK
+              && f.len == alg->ciphertextbytes + alg->bytes, "enc %u status %u", i, f.arg);
+        if (failures)
+            break;
+        memcpy(ct, f.payload, f.len);
+        svc_rx_consume(&cli_rx, &f);
+
+        CHECK(cli_call(SVC_OP_DEC, alg->id, 0, ct, alg->ciphertextbytes, ss, &n) == SVC_OK
+              && n == alg->bytes && !memcmp(ss, ct + alg->ciphertextbytes, alg->bytes),
+              "dec of enc %u", i);
+        paced_result->first_us += (double)(t_first - t0);
+        paced_result->total_us += (double)(t_end - t0);
+        paced_result->n++;
+    }
+
+    close(cli_fd);
+    return failures ? 1 : 0;
+}
+
+/* ================= MAIN ================= */
+
+/* Serves a forked client over a socketpair; 0 if the client passed */
+static int serve(int (*client_main)(void), int streaming, uint32_t bytes_per_s)
+{
+    svc_link_t fd_link, paced_link;
+    svc_pace_t pace;
+    int sv[2], status, svc_fd;
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) {
+        perror("socketpair");
+        exit(2);
+    }
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(2);
+    }
+    if (pid == 0) {
+        close(sv[0]);
+        cli_fd = sv[1];
+        exit(client_main());
+    }
+
+    close(sv[1]);
+    svc_fd = sv[0];
+    svc_link_fd(&fd_link, &svc_fd);
+    if (bytes_per_s)
+        svc_link_paced(&paced_link, &pace, &fd_link, bytes_per_s);
+    svc_set_streaming(streaming);
+    svc_start(bytes_per_s ? &paced_link : &fd_link);
+    while (svc_poll() >= 0)
+        ;
+    svc_stop();
+    close(svc_fd);
+
+    waitpid(pid, &status, 0);
+    printf("requests %u, rejected %u, queue full %u, streamed %u; jobs keypair %u enc %u dec %u\n",
+           svc_stats.requests, svc_stats.rejected, svc_stats.queue_full, svc_stats.streamed,
+           svc_stats.jobs[SVC_OP_KEYPAIR], svc_stats.jobs[SVC_OP_ENC], svc_stats.jobs[SVC_OP_DEC]);
+    return !WIFEXITED(status) || WEXITSTATUS(status);
+}
+
+static int paced(uint32_t bytes_per_s)
+{
+    static const char *const modes[2] = {"buffered", "streamed"};
+    const kyber_alg_t *alg = &kyber_algs[kyber_alg_count - 1];
+    paced_result_t *res;
+    double mean[2];
+    int m, fail = 0;
+
+    res = mmap(NULL, 2 * sizeof(*res), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (res == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    memset(res, 0, 2 * sizeof(*res));
+
+    printf("%s ENC x%u, responses paced to %u B/s (%zu-byte frame: %.0f us on the wire)\n",
+           alg->name, paced_encs, (unsigned int)bytes_per_s,
+           SVC_HEADER_BYTES + alg->ciphertextbytes + alg->bytes + SVC_CRC_BYTES,
+           (SVC_HEADER_BYTES + alg->ciphertextbytes + alg->bytes + SVC_CRC_BYTES) * 1e6 / bytes_per_s);
+    for (m = 0; m < 2; m++) {
+        paced_result = &res[m];
+        fail |= serve(client_paced, m, bytes_per_s);
+        if (!res[m].n) {
+            fail = 1;
+            continue;
+        }
+        mean[m] = res[m].total_us / res[m].n;
+        printf("  %s: first byte %.1f us, whole response %.1f us (mean of %u); "
+               "service: enc %.1f us, sending began %.1f us before its end\n",
+               modes[m], res[m].first_us / res[m].n, mean[m], res[m].n,
+               (double)svc_stats.run_us[SVC_OP_ENC] / svc_stats.jobs[SVC_OP_ENC],
+               svc_stats.streamed ? (double)svc_stats.stream_lead_us / svc_stats.streamed : 0.0);
+    }
+    if (!fail)
+        printf("  streaming saves %.1f us per ENC (%.1f %%)\n",
+               mean[0] - mean[1], 100.0 * (mean[0] - mean[1]) / mean[0]);
+    printf("kemsvc paced %s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t bytes_per_s = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:")) != -1) {
+        switch (opt) {
+        case 'r':
+            bytes_per_s = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            paced_encs = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-r BYTES_PER_S [-n ENCS]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    stdio_init_all();
+    signal(SIGPIPE, SIG_IGN);
+    alarm(TIMEOUT_S);
+
+    if (bytes_per_s)
+        return paced(bytes_per_s);
+
+    if (serve(client, 1, 0)) {
+        printf("kemsvc FAIL\n");
+        return 1;
+    }
+    printf("kemsvc PASS\n");
+    return 0;
+}
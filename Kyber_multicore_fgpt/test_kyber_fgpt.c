@@ -10,9 +10,25 @@
 #include <stdio.h>
 #include "pico/cyw43_arch.h"
 #include "pico/time.h"
+#include "hardware/clocks.h"
 #include "profile.h"
+#include "trace.h"
+#include "workspace.h"
+#include "skcache.h"
+#include "atcache.h"
+#include "energy.h"
+#include "powerpolicy.h"
+#include "kernels.h"
 
 #define NTESTS 1000
+#define SEED_RUNS 20
+
+/* High for the timed loop; GP2 drives the INA219 rig (Arduino_test_file.ino) */
+#define ENERGY_SIGNAL_PIN 2
+
+/* Power policy check: calls per operation at its point, deadline preset */
+#define POLICY_RUNS 20
+#define POLICY_DEADLINE_US 50000
 
 static int test_keys_timed(uint64_t *d_keygen, uint64_t *d_enc, uint64_t *d_dec) {
   static uint8_t pk[CRYPTO_PUBLICKEYBYTES];
@@ -100,6 +116,174 @@ static int test_invalid_ciphertext(void)
     return 0;
 }
 
+/*
+ * Seed-format secret keys (skcache.h). Decapsulates repeatedly with one
+ * key, which stays cached, then round-robin over SKC_ENTRIES + 1 keys,
+ * which makes every lookup an LRU miss and so an expansion. Reports the
+ * storage saved per key against the expansion cost. Runs after the
+ * profile is printed: expansions are keygens and count in kg_prof.
+ */
+static int test_seed_keys(void)
+{
+    static uint8_t pk[SKC_ENTRIES + 1][CRYPTO_PUBLICKEYBYTES];
+    static uint8_t seedsk[SKC_ENTRIES + 1][CRYPTO_SEEDSECRETKEYBYTES];
+    static uint8_t ct[SKC_ENTRIES + 1][CRYPTO_CIPHERTEXTBYTES];
+    static uint8_t key_a[CRYPTO_BYTES];
+    static uint8_t key_b[SKC_ENTRIES + 1][CRYPTO_BYTES];
+    uint64_t t0, hit_us = 0, miss_us = 0;
+    unsigned int i, n = SKC_ENTRIES + 1;
+
+    skc_clear();
+    for (i = 0; i < n; i++) {
+        crypto_kem_keypair_seed(pk[i], seedsk[i]);
+        crypto_kem_enc(ct[i], key_b[i], pk[i]);
+    }
+
+    /* the last key generated is the most recently used entry */
+    for (i = 0; i < SEED_RUNS; i++) {
+        t0 = time_us_64();
+        crypto_kem_dec_seed(key_a, ct[n - 1], seedsk[n - 1]);
+        hit_us += time_us_64() - t0;
+        if (memcmp(key_a, key_b[n - 1], CRYPTO_BYTES)) {
+            printf("ERROR seed key (cached)\n");
+            return 1;
+        }
+    }
+
+    skc_stats.hits = skc_stats.misses = skc_stats.evictions = 0;
+    skc_stats.expand_us = 0;
+    for (i = 0; i < SEED_RUNS; i++) {
+        t0 = time_us_64();
+        crypto_kem_dec_seed(key_a, ct[i % n], seedsk[i % n]);
+        miss_us += time_us_64() - t0;
+        if (memcmp(key_a, key_b[i % n], CRYPTO_BYTES)) {
+            printf("ERROR seed key (expanded)\n");
+            return 1;
+        }
+    }
+
+    printf("\n# SEED KEYS\n");
+    printf("sk_bytes,seed_sk_bytes,saved_bytes_per_key,cache_entries,cache_bytes\n");
+    printf("%d,%d,%d,%d,%d\n", CRYPTO_SECRETKEYBYTES, CRYPTO_SEEDSECRETKEYBYTES,
+           CRYPTO_SECRETKEYBYTES - CRYPTO_SEEDSECRETKEYBYTES, SKC_ENTRIES, (int)SKC_BYTES);
+    printf("dec_cached_us,dec_expanded_us,expand_us,misses,evictions\n");
+    printf("%.2f,%.2f,%.2f,%" PRIu32 ",%" PRIu32 "\n",
+           hit_us / (double)SEED_RUNS, miss_us / (double)SEED_RUNS,
+           skc_stats.misses ? skc_stats.expand_us / (double)skc_stats.misses : 0.0,
+           skc_stats.misses, skc_stats.evictions);
+
+    skc_clear();
+    return 0;
+}
+
+/*
+ * Operating points of every power-policy preset (powerpolicy.h), planned
+ * from the profile of the timed loop, then POLICY_RUNS calls of each
+ * operation at its point so the measured time can be set against the
+ * prediction. The host cannot change its clock, so there only the core1
+ * choice shows in the measured column.
+ */
+static int test_power_policy(const double op_us[PROF_OP_COUNT])
+{
+    static uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+    static uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    static uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+    static uint8_t key_a[CRYPTO_BYTES];
+    static uint8_t key_b[CRYPTO_BYTES];
+    static kyber_power_policy_t policy[POWER_PRESET_COUNT];
+    uint64_t t0, dt[PROF_OP_COUNT];
+    unsigned int i;
+    int pr, op;
+
+    printf("\n# POWER POLICY\n");
+    printf("preset,deadline_us,op,clock_khz,mv,core1,pred_us,pred_uj,meets_deadline\n");
+    for (pr = 0; pr < POWER_PRESET_COUNT; pr++) {
+        power_policy_plan(&policy[pr], (power_preset_t)pr, POLICY_DEADLINE_US, op_us, NTESTS);
+        power_policy_print(&policy[pr]);
+    }
+
+    printf("preset,op,measured_us\n");
+    for (pr = 0; pr < POWER_PRESET_COUNT; pr++) {
+        for (op = 0; op < PROF_OP_COUNT; op++) {
+            if (power_policy_enter(&policy[pr], (prof_op_t)op)) {
+                power_policy_exit();
+                printf("ERROR power policy: clock not accepted (%s)\n", power_preset_names[pr]);
+                return 1;
+            }
+
+            t0 = time_us_64();
+            for (i = 0; i < POLICY_RUNS; i++) {
+                if (op == PROF_OP_KEYGEN)
+                    crypto_kem_keypair(pk, sk);
+                else if (op == PROF_OP_ENC)
+                    crypto_kem_enc(ct, key_b, pk);
+                else
+                    crypto_kem_dec(key_a, ct, sk);
+            }
+            dt[op] = time_us_64() - t0;
+        }
+        power_policy_exit();
+
+        if (memcmp(key_a, key_b, CRYPTO_BYTES)) {
+            printf("ERROR keys (%s)\n", power_preset_names[pr]);
+            return 1;
+        }
+        for (op = 0; op < PROF_OP_COUNT; op++)
+            printf("%s,%s,%.2f\n", power_preset_names[pr], prof_op_names[op],
+                   dt[op] / (double)POLICY_RUNS);
+    }
+    return 0;
+}
+
+/*
+ * Measured core hand-off costs, per KEM call. dispatch is core0's push to
+ * core1 starting the job, completion is core1 finishing to core0's pop
+ * returning; the blocked columns are time spent inside
+ * multicore_fifo_pop_blocking on each core. The dec rows are the
+ * re-encryption inside decapsulation.
+ */
+static void print_sched_results(int prof_runs,
+                                double avg_keygen_total,
+                                double avg_enc_total,
+                                double avg_dec_total)
+{
+    const double op_total[PROF_OP_COUNT] = {avg_keygen_total, avg_enc_total, avg_dec_total};
+
+    printf("\n# SCHED\n");
+    printf("op,phase,launch_us,dispatch_us,core1_blocked_us,core0_blocked_us,"
+           "completion_us,reset_us,overhead_pct\n");
+
+    for (int op = 0; op < PROF_OP_COUNT; op++) {
+        double op_overhead = 0;
+
+        for (int ph = 0; ph < PROF_PHASE_COUNT; ph++) {
+            const sched_profile_t *s = &sched_prof[op][ph];
+            if (s->jobs == 0)
+                continue;
+
+            double launch   = s->launch / (double)prof_runs;
+            double dispatch = s->dispatch / (double)prof_runs;
+            double c1_block = s->core1_blocked / (double)prof_runs;
+            double c0_block = s->core0_blocked / (double)prof_runs;
+            double complete = s->completion / (double)prof_runs;
+            double reset    = s->reset / (double)prof_runs;
+
+            /* time core0 is not computing because of the hand-off */
+            double overhead = launch + c0_block + reset;
+            op_overhead += overhead;
+
+            printf("%s,%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+                   prof_op_names[op], prof_phase_names[ph],
+                   launch, dispatch, c1_block, c0_block, complete, reset,
+                   100.0 * overhead / op_total[op]);
+        }
+
+        if (op_overhead > 0)
+            printf("%s,total,,,,,,,%.2f\n", prof_op_names[op],
+                   100.0 * op_overhead / op_total[op]);
+    }
+}
+
 void print_profile_results(int prof_runs,
                            double avg_keygen_total,
                            double avg_enc_total,
@@ -118,7 +302,6 @@ void print_profile_results(int prof_runs,
     double kg_phase_pack = kg_prof.phase_pack / (double)prof_runs;
 
     double kg_noise  = kg_prof.noise / (double)prof_runs;
-    double kg_ntt    = kg_prof.ntt / (double)prof_runs;
     double kg_addred = kg_prof.add_reduce / (double)prof_runs;
 
     double kg_c1_hash = kg_prof.core1_hash_gena / (double)prof_runs;
@@ -131,59 +314,56 @@ void print_profile_results(int prof_runs,
     printf("keygen,phase_matmul,%.2f,%.2f\n",   kg_phase_mul,  100.0 * kg_phase_mul  / kg_total);
     printf("keygen,phase_pack,%.2f,%.2f\n",     kg_phase_pack, 100.0 * kg_phase_pack / kg_total);
 
-    printf("keygen,core0_noise,%.2f,%.2f\n",    kg_noise,  100.0 * kg_noise  / kg_total);
-    printf("keygen,core0_ntt,%.2f,%.2f\n",      kg_ntt,    100.0 * kg_ntt    / kg_total);
+    printf("keygen,core0_noise_ntt,%.2f,%.2f\n", kg_noise, 100.0 * kg_noise  / kg_total);
     printf("keygen,core0_add_reduce,%.2f,%.2f\n",kg_addred,100.0 * kg_addred/ kg_total);
 
     printf("keygen,core1_hash_genA,%.2f,%.2f\n", kg_c1_hash,100.0 * kg_c1_hash / kg_total);
     printf("keygen,core1_matmul,%.2f,%.2f\n",    kg_c1_mul, 100.0 * kg_c1_mul  / kg_total);
     printf("keygen,core1_pack,%.2f,%.2f\n",      kg_c1_pack,100.0 * kg_c1_pack / kg_total);
 
-    /* Efficiency estimates */
-    double kg_idle_core0 = kg_phase_hash - (kg_noise + kg_ntt);
-    if (kg_idle_core0 < 0) kg_idle_core0 = 0;
-
-    double kg_idle_core1 = kg_phase_hash - kg_c1_hash;
-    if (kg_idle_core1 < 0) kg_idle_core1 = 0;
-
-    printf("keygen,core0_idle_est,%.2f,%.2f\n", kg_idle_core0, 100.0 * kg_idle_core0 / kg_total);
-    printf("keygen,core1_idle_est,%.2f,%.2f\n", kg_idle_core1, 100.0 * kg_idle_core1 / kg_total);
-
 
     /* ================= ENC ================= */
 
     double enc_total = avg_enc_total;
 
     double enc_phase_frommsg = enc_prof.phase_frommsg / (double)prof_runs;
+    double enc_phase_noise   = enc_prof.phase_noise / (double)prof_runs;
     double enc_phase_mul     = enc_prof.phase_matmul / (double)prof_runs;
 
     double enc_unpack = enc_prof.unpack / (double)prof_runs;
     double enc_genat  = enc_prof.gen_at / (double)prof_runs;
     double enc_noise  = enc_prof.noise / (double)prof_runs;
-    double enc_ntt    = enc_prof.ntt / (double)prof_runs;
-    double enc_invntt = enc_prof.invntt / (double)prof_runs;
-    double enc_addred = enc_prof.add_reduce / (double)prof_runs;
-    double enc_pack   = enc_prof.pack / (double)prof_runs;
+    double enc_mul    = enc_prof.matmul / (double)prof_runs;
 
     double enc_c1_frommsg = enc_prof.core1_frommsg / (double)prof_runs;
+    double enc_c1_noise   = enc_prof.core1_noise / (double)prof_runs;
     double enc_c1_mul     = enc_prof.core1_matmul / (double)prof_runs;
 
     printf("\n# ENC\n");
 
     printf("enc,phase_frommsg,%.2f,%.2f\n", enc_phase_frommsg, 100.0 * enc_phase_frommsg / enc_total);
+    printf("enc,phase_noise,%.2f,%.2f\n",   enc_phase_noise,   100.0 * enc_phase_noise / enc_total);
     printf("enc,phase_matmul,%.2f,%.2f\n",  enc_phase_mul,     100.0 * enc_phase_mul / enc_total);
 
     printf("enc,core0_unpack,%.2f,%.2f\n", enc_unpack, 100.0 * enc_unpack / enc_total);
     printf("enc,core0_gen_at,%.2f,%.2f\n", enc_genat,  100.0 * enc_genat  / enc_total);
-    printf("enc,core0_noise,%.2f,%.2f\n", enc_noise, 100.0 * enc_noise / enc_total);
-    printf("enc,core0_ntt,%.2f,%.2f\n", enc_ntt, 100.0 * enc_ntt / enc_total);
-    printf("enc,core0_invntt,%.2f,%.2f\n", enc_invntt, 100.0 * enc_invntt / enc_total);
-    printf("enc,core0_add_reduce,%.2f,%.2f\n", enc_addred, 100.0 * enc_addred / enc_total);
-    printf("enc,core0_pack,%.2f,%.2f\n", enc_pack, 100.0 * enc_pack / enc_total);
+    printf("enc,core0_noise_ntt,%.2f,%.2f\n", enc_noise, 100.0 * enc_noise / enc_total);
+    printf("enc,core0_matmul,%.2f,%.2f\n", enc_mul, 100.0 * enc_mul / enc_total);
 
     printf("enc,core1_frommsg,%.2f,%.2f\n", enc_c1_frommsg, 100.0 * enc_c1_frommsg / enc_total);
+    printf("enc,core1_noise_ntt,%.2f,%.2f\n", enc_c1_noise, 100.0 * enc_c1_noise / enc_total);
     printf("enc,core1_matmul,%.2f,%.2f\n", enc_c1_mul, 100.0 * enc_c1_mul / enc_total);
 
+    /* Each iteration encapsulates to a fresh key (miss) and decapsulates
+     * with it (hit), so a warm cache shows up as a 50% hit rate here */
+    uint32_t at_lookups = enc_prof.at_hits + enc_prof.at_misses;
+
+    printf("\n# AT CACHE\n");
+    printf("entries,bytes,hits,misses,hit_rate_pct\n");
+    printf("%d,%d,%" PRIu32 ",%" PRIu32 ",%.2f\n", (int)ATC_ENTRIES, (int)(ATC_ENTRIES * ATC_ENTRY_BYTES),
+           enc_prof.at_hits, enc_prof.at_misses,
+           at_lookups ? 100.0 * enc_prof.at_hits / at_lookups : 0.0);
+
 
     /* ================= DEC ================= */
 
@@ -204,6 +384,8 @@ void print_profile_results(int prof_runs,
     printf("dec,invntt,%.2f,%.2f\n", dec_invntt, 100.0 * dec_invntt / dec_total);
     printf("dec,sub_reduce,%.2f,%.2f\n", dec_sub, 100.0 * dec_sub / dec_total);
     printf("dec,tomsg,%.2f,%.2f\n", dec_msg, 100.0 * dec_msg / dec_total);
+
+    print_sched_results(prof_runs, avg_keygen_total, avg_enc_total, avg_dec_total);
 }
 
 void pico_set_led(bool led_on)
@@ -242,9 +424,24 @@ int main(void)
 
 
     uint64_t sum_keygen = 0, sum_enc = 0, sum_dec = 0;
+    energy_part_t window;
     unsigned int i;
     int r = 0;
 
+    gpio_init(ENERGY_SIGNAL_PIN);
+    gpio_set_dir(ENERGY_SIGNAL_PIN, GPIO_OUT);
+    gpio_put(ENERGY_SIGNAL_PIN, 0);
+
+    // Batch markers and build metadata for tools/power_log.py
+    printf("variant = %s\nkyber_k = %d\nclock_khz = %" PRIu32 "\n",
+           KYBER_VARIANT, KYBER_K, clock_get_hz(clk_sys) / 1000);
+    printf("kernels = %s (%s)\n", kernels_init(), kernels_cpu());
+    printf("NTESTS = %d\n", NTESTS);
+    printf("--- KEM batch start ---\n");
+
+    energy_window_begin();
+    gpio_put(ENERGY_SIGNAL_PIN, 1);
+
     for (i = 0; i < NTESTS; i++) {
         uint64_t dkg=0, den=0, ddc=0;
         r = test_keys_timed(&dkg, &den, &ddc);
@@ -254,6 +451,10 @@ int main(void)
         sum_dec    += ddc;
     }
 
+    gpio_put(ENERGY_SIGNAL_PIN, 0);
+    energy_window_end(&window);
+    printf("--- KEM batch end ---\n");
+
     // Run correctness-negative tests (not included in timings)
     r |= test_invalid_sk_a();
     r |= test_invalid_ciphertext();
@@ -277,6 +478,26 @@ int main(void)
     sum_dec/NTESTS
   );
 
+    // Estimated energy per operation and phase, and over the GPIO window
+    const double op_us[PROF_OP_COUNT] = {
+        sum_keygen / (double)NTESTS, sum_enc / (double)NTESTS, sum_dec / (double)NTESTS
+    };
+    energy_print(NTESTS, op_us, &window);
+
+    // Arena sizes are compile-time; the peaks should reach them exactly
+    ws_print_usage();
+
+    if (test_power_policy(op_us))
+        return 1;
+
+    if (test_seed_keys())
+        return 1;
+
+#ifdef KYBER_TRACE
+    // Timeline of the last iterations still held in the per-core rings
+    trace_dump_json(CRYPTO_ALGNAME " multicore");
+#endif
+
     pico_set_led(false);
     
     return 0;
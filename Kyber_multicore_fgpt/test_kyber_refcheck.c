@@ -0,0 +1,806 @@
+/*
+ * Cross-check against the pq-crystals reference (host build only).
+ *
+ * lib/ holds the reference Kyber as shared objects, built from the same
+ * sources this tree started from. For every parameter set of the build
+ * (kyber_alg.h: the KYBER_K one, or all three with KYBER_ALL_K) this
+ * harness loads the matching object with dlopen() and drives it and this
+ * tree's KEM with the same deterministic coins, comparing pk, sk, ct and
+ * ss byte for byte:
+ *
+ *   seeds  coins from SHAKE256(base seed || index); per seed keygen, two
+ *          encapsulations under the same pk (the second one hits atcache),
+ *          decapsulation with the full and the seed-format secret key, and
+ *          decapsulation of a ciphertext with one bit flipped (implicit
+ *          rejection, ss = J(z, ct)); each encapsulation is also streamed
+ *          (enc_derand_stream) with core1 on and with its phases inline,
+ *          and the emitted pieces must add up to the reference ct, and
+ *          repeated with the pk passed in pieces of varying size
+ *          (enc_init / enc_update / enc_final_derand) and with H(pk)
+ *          passed in (enc_derand_hpk, from hash_pk and hpk_seed, which
+ *          must equal the H(pk) in the reference sk). A transfer is then
+ *          abandoned once its seed is in, by enc_abort, a new enc_init or
+ *          another KEM call, and encapsulating under that seed must still
+ *          match the reference; also with the seed already cached, where
+ *          a call to another key takes the entry the transfer hit, after
+ *          which its enc_final must fail
+ *   kat    the 100 vectors of NIST's PQCgenKAT_kem: the AES-256 CTR_DRBG
+ *          seeded with 0..47 gives each vector's seed, and that seed's
+ *          DRBG gives the keygen and encapsulation coins. -r PREFIX writes
+ *          them as PREFIX<sk bytes>.rsp, to compare with the published
+ *          PQCkemKAT_<sk bytes>.rsp
+ *   bench  ITERS calls of each operation on either side, timed
+ *
+ * Both sides export the same pqcrystals_kyberNNN_ref_* and
+ * pqcrystals_kyber_fips202_ref_* names. The executable is not linked with
+ * -rdynamic, so none of its symbols are visible to the loaded objects, and
+ * the reference is loaded with RTLD_DEEPBIND so its own definitions come
+ * first anyway; its fips202 calls go to libpqcrystals_fips202_ref.so. Its
+ * randombytes() stays unresolved, which RTLD_LAZY allows as long as only
+ * the _derand entry points are called.
+ *
+ *   test_kyber_refcheck [-a ID] [-B BACKEND|all] [-n SEEDS] [-s SEED] [-k] [-r PREFIX]
+ *                       [-b ITERS] [-l DIR]
+ *
+ * -a restricts the run to one algorithm ID (the rank, 2 to 4). -B runs
+ * the checks with the named kernel backend (kernels.h), or once with each
+ * backend the CPU supports; by default kernels_init() picks one. Exits
+ * non-zero if anything differed or a requested backend failed its
+ * self-test, so it doubles as the ctest check of the host build.
+ */
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "kyber_alg.h"
+#include "fips202.h"
+#include "kernels.h"
+#include "profile.h"
+
+#ifndef KYBER_VARIANT
+#define KYBER_VARIANT "unknown"
+#endif
+#ifndef KYBER_CFLAGS
+#define KYBER_CFLAGS ""
+#endif
+
+/* lib/ of the source tree, set by CMakeLists.txt */
+#ifndef KYBER_REF_LIB_DIR
+#define KYBER_REF_LIB_DIR "lib"
+#endif
+
+#define SYMBYTES 32
+#define REFCHECK_SEEDS 2000
+#define KAT_VECTORS 100
+
+/* ================= REFERENCE ================= */
+
+typedef int (*ref_keypair_fn)(uint8_t *pk, uint8_t *sk, const uint8_t *coins);
+typedef int (*ref_enc_fn)(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins);
+typedef int (*ref_dec_fn)(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+
+static ref_keypair_fn ref_keypair;
+static ref_enc_fn ref_enc;
+static ref_dec_fn ref_dec;
+
+static void *ref_sym(void *h, const kyber_alg_t *alg, const char *name)
+{
+    char full[64];
+    void *p;
+
+    snprintf(full, sizeof(full), "pqcrystals_kyber%u_ref_%s", 256 * alg->id, name);
+    p = dlsym(h, full);
+    if (!p)
+        fprintf(stderr, "%s: %s\n", full, dlerror());
+    return p;
+}
+
+static int ref_load(const char *dir, const kyber_alg_t *alg)
+{
+    static int fips202_loaded;
+    char path[1024];
+    void *h;
+
+    if (!fips202_loaded) {
+        snprintf(path, sizeof(path), "%s/libpqcrystals_fips202_ref.so", dir);
+        if (!dlopen(path, RTLD_NOW | RTLD_GLOBAL)) {
+            fprintf(stderr, "%s\n", dlerror());
+            return -1;
+        }
+        fips202_loaded = 1;
+    }
+
+    snprintf(path, sizeof(path), "%s/libpqcrystals_kyber%u_ref.so", dir, 256 * alg->id);
+    h = dlopen(path, RTLD_LAZY | RTLD_LOCAL | RTLD_DEEPBIND);
+    if (!h) {
+        fprintf(stderr, "%s\n", dlerror());
+        return -1;
+    }
+
+    ref_keypair = (ref_keypair_fn)ref_sym(h, alg, "keypair_derand");
+    ref_enc = (ref_enc_fn)ref_sym(h, alg, "enc_derand");
+    ref_dec = (ref_dec_fn)ref_sym(h, alg, "dec");
+    if (!ref_keypair || !ref_enc || !ref_dec)
+        return -1;
+
+    /* the reference's keygen must not be this tree's under another name */
+    if (ref_keypair == alg->keypair_derand) {
+        fprintf(stderr, "%s resolved to this tree's keypair_derand\n", path);
+        return -1;
+    }
+    printf("\n%s reference: %s\n", alg->name, path);
+    return 0;
+}
+
+/* ================= COMPARISON ================= */
+
+enum {
+    CHK_PK,
+    CHK_SK,
+    CHK_CT,
+    CHK_SS,
+    CHK_DEC,
+    CHK_DEC_SEED,
+    CHK_REJECT,
+    CHK_STREAM,
+    CHK_INGEST,
+    CHK_HPK,
+    CHK_ABANDON,
+    CHK_COUNT
+};
+
+static const char *const chk_names[CHK_COUNT] = {
+    "pk", "sk", "ct", "ss", "dec", "dec_seed", "reject", "stream", "ingest", "hpk", "abandon"
+};
+
+static unsigned int mismatches[CHK_COUNT];
+
+static void check(int what, const uint8_t *ours, const uint8_t *ref, size_t len, const char *label,
+                  unsigned int idx)
+{
+    size_t i;
+
+    if (!memcmp(ours, ref, len))
+        return;
+    /* the first few are enough to see the pattern */
+    if (mismatches[what]++ < 4) {
+        for (i = 0; i < len && ours[i] == ref[i]; i++)
+            ;
+        printf("MISMATCH %s %s %u: first differing byte %zu (ours %02x, ref %02x)\n",
+               label, chk_names[what], idx, i, ours[i], ref[i]);
+    }
+}
+
+static uint8_t pk[KYBER_ALG_MAX_PUBLICKEYBYTES], pk_ref[KYBER_ALG_MAX_PUBLICKEYBYTES];
+static uint8_t sk[KYBER_ALG_MAX_SECRETKEYBYTES], sk_ref[KYBER_ALG_MAX_SECRETKEYBYTES];
+static uint8_t ct[KYBER_ALG_MAX_CIPHERTEXTBYTES], ct_ref[KYBER_ALG_MAX_CIPHERTEXTBYTES];
+static uint8_t ss[SYMBYTES], ss_ref[SYMBYTES], ss_dec[SYMBYTES];
+
+/* What enc_derand_stream emitted, in order */
+static uint8_t streamed[KYBER_ALG_MAX_CIPHERTEXTBYTES];
+static size_t streamed_len;
+
+static void stream_emit(void *ctx, const uint8_t *bytes, size_t len)
+{
+    (void)ctx;
+    if (streamed_len + len <= sizeof(streamed))
+        memcpy(streamed + streamed_len, bytes, len);
+    streamed_len += len;
+}
+
+static void check_stream(const kyber_alg_t *alg, const uint8_t *enc_coins, const char *label,
+                         unsigned int idx)
+{
+    int core1;
+
+    for (core1 = 1; core1 >= 0; core1--) {
+        sched_set_core1(core1);
+        streamed_len = 0;
+        alg->enc_derand_stream(ct, ss, pk, enc_coins, stream_emit, NULL);
+        if (streamed_len != alg->ciphertextbytes) {
+            if (mismatches[CHK_STREAM]++ < 4)
+                printf("MISMATCH %s stream %u: %zu bytes emitted with core1 %s\n",
+                       label, idx, streamed_len, core1 ? "on" : "inline");
+            continue;
+        }
+        check(CHK_STREAM, streamed, ct_ref, alg->ciphertextbytes, label, idx);
+        check(CHK_STREAM, ct, ct_ref, alg->ciphertextbytes, label, idx);
+    }
+    sched_set_core1(1);
+}
+
+/* pk in pieces of 1 to 256 bytes, their sizes taken from the coins */
+static void check_ingest(const kyber_alg_t *alg, const uint8_t *enc_coins, const char *label,
+                         unsigned int idx)
+{
+    static kyber_alg_enc_state_t st;
+    size_t off, n;
+    unsigned int i = 0;
+
+    alg->enc_init(&st);
+    for (off = 0; off < alg->publickeybytes; off += n) {
+        n = (size_t)enc_coins[i++ % SYMBYTES] + 1;
+        if (n > alg->publickeybytes - off)
+            n = alg->publickeybytes - off;
+        alg->enc_update(&st, pk + off, n);
+    }
+    streamed_len = 0;
+    if (alg->enc_update(&st, pk, 1) == 0 ||
+        alg->enc_final_derand(ct, ss, &st, enc_coins, stream_emit, NULL)) {
+        if (mismatches[CHK_INGEST]++ < 4)
+            printf("MISMATCH %s ingest %u: pk length not enforced\n", label, idx);
+        return;
+    }
+    check(CHK_INGEST, ct, ct_ref, alg->ciphertextbytes, label, idx);
+    check(CHK_INGEST, ss, ss_ref, alg->bytes, label, idx);
+    if (streamed_len == alg->ciphertextbytes)
+        check(CHK_INGEST, streamed, ct_ref, alg->ciphertextbytes, label, idx);
+    else if (mismatches[CHK_INGEST]++ < 4)
+        printf("MISMATCH %s ingest %u: %zu bytes emitted\n", label, idx, streamed_len);
+}
+
+/* H(pk) computed, and kept by keygen for the seed-format key kg_coins */
+static void check_hpk(const kyber_alg_t *alg, const uint8_t *kg_coins, const uint8_t *enc_coins,
+                      const char *label, unsigned int idx)
+{
+    uint8_t hpk[SYMBYTES];
+
+    alg->hash_pk(hpk, pk);
+    check(CHK_HPK, hpk, sk_ref + alg->secretkeybytes - 2 * SYMBYTES, SYMBYTES, label, idx);
+    alg->hpk_seed(hpk, kg_coins);
+    check(CHK_HPK, hpk, sk_ref + alg->secretkeybytes - 2 * SYMBYTES, SYMBYTES, label, idx);
+    alg->enc_derand_hpk(ct, ss, pk, hpk, enc_coins, NULL, NULL);
+    check(CHK_HPK, ct, ct_ref, alg->ciphertextbytes, label, idx);
+    check(CHK_HPK, ss, ss_ref, alg->bytes, label, idx);
+}
+
+/*
+ * Transfers abandoned after their seed, with core1 expanding A^T into an
+ * atcache entry nobody waits for: the entry must not turn into a hit for
+ * a matrix that is not there, and the abandoned state must be refused.
+ * Each uses a seed not cached yet (the last byte of pk changed).
+ */
+static void check_abandon(const kyber_alg_t *alg, const uint8_t *enc_coins, const char *label,
+                          unsigned int idx)
+{
+    static const char *const how[3] = {"enc_abort", "enc_init", "enc_derand"};
+    static kyber_alg_enc_state_t st, st_next;
+    static uint8_t pk_alt[KYBER_ALG_MAX_PUBLICKEYBYTES];
+    unsigned int way;
+    int core1;
+
+    for (core1 = 1; core1 >= 0; core1--) {
+        sched_set_core1(core1);
+        for (way = 0; way < 3; way++) {
+            memcpy(pk_alt, pk, alg->publickeybytes);
+            pk_alt[alg->publickeybytes - 1] ^= (uint8_t)(1 + way + 3 * core1);
+            ref_enc(ct_ref, ss_ref, pk_alt, enc_coins);
+
+            alg->enc_init(&st);
+            alg->enc_update(&st, pk_alt, alg->publickeybytes);
+            if (way == 0)
+                alg->enc_abort(&st);
+            else if (way == 1)
+                alg->enc_init(&st_next);
+            alg->enc_derand(ct, ss, pk_alt, enc_coins);
+            check(CHK_ABANDON, ct, ct_ref, alg->ciphertextbytes, label, idx);
+            check(CHK_ABANDON, ss, ss_ref, alg->bytes, label, idx);
+            /* and once more, now from the cache */
+            alg->enc_derand(ct, ss, pk_alt, enc_coins);
+            check(CHK_ABANDON, ct, ct_ref, alg->ciphertextbytes, label, idx);
+
+            if (alg->enc_final_derand(ct, ss, &st, enc_coins, NULL, NULL) == 0 &&
+                mismatches[CHK_ABANDON]++ < 4)
+                printf("MISMATCH %s abandon %u: state left by %s still accepted\n",
+                       label, idx, how[way]);
+        }
+    }
+    sched_set_core1(1);
+}
+
+/*
+ * A transfer whose seed hits in atcache, followed by an encapsulation to
+ * another key (enc_derand, or a second transfer reaching its seed) that
+ * may take the entry it hit: the transfer must be abandoned, not finished
+ * with the other key's A^T. At K=4 the cache has one entry.
+ */
+static void check_abandon_hit(const kyber_alg_t *alg, const uint8_t *enc_coins, const char *label,
+                              unsigned int idx)
+{
+    static kyber_alg_enc_state_t st, st_other;
+    static uint8_t pk_alt[KYBER_ALG_MAX_PUBLICKEYBYTES];
+    unsigned int way;
+
+    for (way = 0; way < 2; way++) {
+        memcpy(pk_alt, pk, alg->publickeybytes);
+        pk_alt[alg->publickeybytes - 1] ^= (uint8_t)(0x10 + way);
+
+        alg->enc_derand(ct, ss, pk, enc_coins);     /* pk's seed is cached */
+        alg->enc_init(&st);
+        alg->enc_update(&st, pk, alg->publickeybytes);
+        if (way == 0) {
+            alg->enc_derand(ct, ss, pk_alt, enc_coins);
+        } else {
+            alg->enc_init(&st_other);
+            alg->enc_update(&st_other, pk_alt, alg->publickeybytes);
+            alg->enc_abort(&st_other);
+        }
+        if (alg->enc_final_derand(ct, ss, &st, enc_coins, NULL, NULL) == 0 &&
+            mismatches[CHK_ABANDON]++ < 4)
+            printf("MISMATCH %s abandon %u: cached transfer finished after %s to another key\n",
+                   label, idx, way ? "enc_update" : "enc_derand");
+    }
+
+    ref_enc(ct_ref, ss_ref, pk_ref, enc_coins);
+    alg->enc_derand(ct, ss, pk, enc_coins);
+    check(CHK_ABANDON, ct, ct_ref, alg->ciphertextbytes, label, idx);
+    check(CHK_ABANDON, ss, ss_ref, alg->bytes, label, idx);
+}
+
+/* kg_coins are 2 * SYMBYTES, also the seed-format sk; flip past the ciphertext skips the rejection check */
+static void check_encaps(const kyber_alg_t *alg, const uint8_t *kg_coins, const uint8_t *enc_coins,
+                         unsigned int flip, const char *label, unsigned int idx)
+{
+    alg->enc_derand(ct, ss, pk, enc_coins);
+    ref_enc(ct_ref, ss_ref, pk_ref, enc_coins);
+    check(CHK_CT, ct, ct_ref, alg->ciphertextbytes, label, idx);
+    check(CHK_SS, ss, ss_ref, alg->bytes, label, idx);
+    check_stream(alg, enc_coins, label, idx);
+    check_ingest(alg, enc_coins, label, idx);
+    check_hpk(alg, kg_coins, enc_coins, label, idx);
+
+    alg->dec(ss_dec, ct_ref, sk_ref);
+    check(CHK_DEC, ss_dec, ss_ref, alg->bytes, label, idx);
+    alg->dec_seed(ss_dec, ct_ref, kg_coins);
+    check(CHK_DEC_SEED, ss_dec, ss_ref, alg->bytes, label, idx);
+
+    if (flip < 8 * alg->ciphertextbytes) {
+        ct_ref[flip / 8] ^= (uint8_t)(1u << (flip % 8));
+        alg->dec(ss_dec, ct_ref, sk_ref);
+        ref_dec(ss_ref, ct_ref, sk_ref);
+        check(CHK_REJECT, ss_dec, ss_ref, alg->bytes, label, idx);
+    }
+}
+
+static void check_keypair(const kyber_alg_t *alg, const uint8_t *coins, const char *label,
+                          unsigned int idx)
+{
+    alg->keypair_derand(pk, sk, coins);
+    ref_keypair(pk_ref, sk_ref, coins);
+    check(CHK_PK, pk, pk_ref, alg->publickeybytes, label, idx);
+    check(CHK_SK, sk, sk_ref, alg->secretkeybytes, label, idx);
+}
+
+static void run_seeds(const kyber_alg_t *alg, unsigned int n, uint64_t base)
+{
+    uint8_t in[16], coins[4 * SYMBYTES + 4];
+    unsigned int i, flip, nbits = 8 * (unsigned int)alg->ciphertextbytes;
+    int b;
+
+    for (i = 0; i < n; i++) {
+        for (b = 0; b < 8; b++) {
+            in[b] = (uint8_t)(base >> (8 * b));
+            in[8 + b] = (uint8_t)((uint64_t)i >> (8 * b));
+        }
+        shake256(coins, sizeof(coins), in, sizeof(in));
+        flip = (uint32_t)coins[4 * SYMBYTES] | (uint32_t)coins[4 * SYMBYTES + 1] << 8 |
+               (uint32_t)coins[4 * SYMBYTES + 2] << 16;
+
+        check_keypair(alg, coins, "seed", i);
+        check_encaps(alg, coins, coins + 2 * SYMBYTES, flip % nbits, "seed", i);
+        check_encaps(alg, coins, coins + 3 * SYMBYTES, nbits, "seed", i);
+        check_abandon(alg, coins + 3 * SYMBYTES, "seed", i);
+        check_abandon_hit(alg, coins + 3 * SYMBYTES, "seed", i);
+    }
+}
+
+/* ================= NIST KAT DRBG ================= */
+
+/*
+ * AES-256 encryption only, table-free apart from the S-box; speed does not
+ * matter for a few hundred DRBG blocks
+ */
+static const uint8_t aes_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static uint8_t aes_xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+static void aes256_ecb(const uint8_t key[32], const uint8_t in[16], uint8_t out[16])
+{
+    uint8_t rk[240], s[16], t[16], rcon = 1;
+    unsigned int i, r, c;
+
+    memcpy(rk, key, 32);
+    for (i = 32; i < 240; i += 4) {
+        uint8_t w[4] = {rk[i - 4], rk[i - 3], rk[i - 2], rk[i - 1]};
+
+        if (i % 32 == 0) {
+            uint8_t w0 = w[0];
+            w[0] = (uint8_t)(aes_sbox[w[1]] ^ rcon);
+            w[1] = aes_sbox[w[2]];
+            w[2] = aes_sbox[w[3]];
+            w[3] = aes_sbox[w0];
+            rcon = aes_xtime(rcon);
+        } else if (i % 32 == 16) {
+            for (c = 0; c < 4; c++)
+                w[c] = aes_sbox[w[c]];
+        }
+        for (c = 0; c < 4; c++)
+            rk[i + c] = rk[i - 32 + c] ^ w[c];
+    }
+
+    for (i = 0; i < 16; i++)
+        s[i] = in[i] ^ rk[i];
+    for (r = 1; r <= 14; r++) {
+        /* SubBytes and ShiftRows; the state is column-major */
+        for (i = 0; i < 16; i++)
+            t[i] = aes_sbox[s[(i + 4 * (i % 4)) % 16]];
+        if (r < 14) {
+            for (c = 0; c < 16; c += 4) {
+                uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+                uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+                t[c] ^= all ^ aes_xtime(a0 ^ a1);
+                t[c + 1] ^= all ^ aes_xtime(a1 ^ a2);
+                t[c + 2] ^= all ^ aes_xtime(a2 ^ a3);
+                t[c + 3] ^= all ^ aes_xtime(a3 ^ a0);
+            }
+        }
+        for (i = 0; i < 16; i++)
+            s[i] = t[i] ^ rk[16 * r + i];
+    }
+    memcpy(out, s, 16);
+}
+
+/* NIST rng.c, without personalization string or reseeding */
+static struct {
+    uint8_t key[32];
+    uint8_t v[16];
+} drbg;
+
+static void drbg_increment_v(void)
+{
+    int j;
+
+    for (j = 15; j >= 0; j--) {
+        if (drbg.v[j] == 0xff) {
+            drbg.v[j] = 0x00;
+        } else {
+            drbg.v[j]++;
+            break;
+        }
+    }
+}
+
+static void drbg_update(const uint8_t *provided)
+{
+    uint8_t temp[48];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        drbg_increment_v();
+        aes256_ecb(drbg.key, drbg.v, temp + 16 * i);
+    }
+    if (provided)
+        for (i = 0; i < 48; i++)
+            temp[i] ^= provided[i];
+    memcpy(drbg.key, temp, 32);
+    memcpy(drbg.v, temp + 32, 16);
+}
+
+static void drbg_init(const uint8_t entropy[48])
+{
+    memset(drbg.key, 0, sizeof(drbg.key));
+    memset(drbg.v, 0, sizeof(drbg.v));
+    drbg_update(entropy);
+}
+
+static void drbg_bytes(uint8_t *x, size_t len)
+{
+    uint8_t block[16];
+    size_t n;
+
+    while (len > 0) {
+        drbg_increment_v();
+        aes256_ecb(drbg.key, drbg.v, block);
+        n = len < 16 ? len : 16;
+        memcpy(x, block, n);
+        x += n;
+        len -= n;
+    }
+    drbg_update(NULL);
+}
+
+/* FIPS-197 C.3 and the count = 0 seed every PQCkemKAT file starts with */
+static int drbg_selftest(void)
+{
+    static const uint8_t aes_ct[16] = {
+        0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+    };
+    static const uint8_t seed0[48] = {
+        0x06, 0x15, 0x50, 0x23, 0x4d, 0x15, 0x8c, 0x5e, 0xc9, 0x55, 0x95, 0xfe, 0x04, 0xef, 0x7a, 0x25,
+        0x76, 0x7f, 0x2e, 0x24, 0xcc, 0x2b, 0xc4, 0x79, 0xd0, 0x9d, 0x86, 0xdc, 0x9a, 0xbc, 0xfd, 0xe7,
+        0x05, 0x6a, 0x8c, 0x26, 0x6f, 0x9e, 0xf9, 0x7e, 0xd0, 0x85, 0x41, 0xdb, 0xd2, 0xe1, 0xff, 0xa1
+    };
+    uint8_t key[32], pt[16], out[48];
+    int i;
+
+    for (i = 0; i < 32; i++)
+        key[i] = (uint8_t)i;
+    for (i = 0; i < 16; i++)
+        pt[i] = (uint8_t)(0x11 * i);
+    aes256_ecb(key, pt, out);
+    if (memcmp(out, aes_ct, 16))
+        return -1;
+
+    for (i = 0; i < 48; i++)
+        out[i] = (uint8_t)i;
+    drbg_init(out);
+    drbg_bytes(out, 48);
+    return memcmp(out, seed0, 48) ? -1 : 0;
+}
+
+static void rsp_hex(FILE *f, const char *name, const uint8_t *x, size_t len)
+{
+    size_t i;
+
+    fprintf(f, "%s = ", name);
+    for (i = 0; i < len; i++)
+        fprintf(f, "%02X", x[i]);
+    fprintf(f, "\n");
+}
+
+static int run_kat(const kyber_alg_t *alg, const char *rsp_prefix)
+{
+    uint8_t entropy[48], seeds[KAT_VECTORS][48];
+    uint8_t kg_coins[2 * SYMBYTES], enc_coins[SYMBYTES];
+    char rsp_path[1024];
+    FILE *rsp = NULL;
+    unsigned int i;
+
+    if (drbg_selftest()) {
+        printf("MISMATCH kat drbg: AES-256 or CTR_DRBG self-test failed\n");
+        return -1;
+    }
+
+    for (i = 0; i < 48; i++)
+        entropy[i] = (uint8_t)i;
+    drbg_init(entropy);
+    for (i = 0; i < KAT_VECTORS; i++)
+        drbg_bytes(seeds[i], 48);
+
+    if (rsp_prefix) {
+        snprintf(rsp_path, sizeof(rsp_path), "%s%zu.rsp", rsp_prefix, alg->secretkeybytes);
+        rsp = fopen(rsp_path, "w");
+        if (!rsp) {
+            perror(rsp_path);
+            return -1;
+        }
+        fprintf(rsp, "# %s\n\n", alg->name);
+    }
+
+    for (i = 0; i < KAT_VECTORS; i++) {
+        /* crypto_kem_keypair and crypto_kem_enc draw their coins in these sizes */
+        drbg_init(seeds[i]);
+        drbg_bytes(kg_coins, sizeof(kg_coins));
+        drbg_bytes(enc_coins, sizeof(enc_coins));
+
+        check_keypair(alg, kg_coins, "kat", i);
+        check_encaps(alg, kg_coins, enc_coins, 8 * (unsigned int)alg->ciphertextbytes, "kat", i);
+
+        if (rsp) {
+            fprintf(rsp, "count = %u\n", i);
+            rsp_hex(rsp, "seed", seeds[i], 48);
+            rsp_hex(rsp, "pk", pk, alg->publickeybytes);
+            rsp_hex(rsp, "sk", sk, alg->secretkeybytes);
+            rsp_hex(rsp, "ct", ct, alg->ciphertextbytes);
+            rsp_hex(rsp, "ss", ss, alg->bytes);
+            fprintf(rsp, "\n");
+        }
+    }
+
+    if (rsp) {
+        fclose(rsp);
+        printf("wrote %s\n", rsp_path);
+    }
+    return 0;
+}
+
+/* ================= BENCHMARK ================= */
+
+typedef struct {
+    const char *impl;
+    const char *op;
+    uint64_t us;
+} bench_row_t;
+
+static void run_bench(const kyber_alg_t *alg, unsigned int iters)
+{
+    static uint8_t coins[3 * SYMBYTES];
+    char impl[64];
+    const uint8_t *enc_coins = coins + 2 * SYMBYTES;
+    bench_row_t rows[6];
+    uint64_t t0;
+    unsigned int i, r;
+
+    snprintf(impl, sizeof(impl), "%s/%s", KYBER_VARIANT, kyber_kernels.name);
+    shake256(coins, sizeof(coins), (const uint8_t *)"bench", 5);
+    alg->keypair_derand(pk, sk, coins);
+    alg->enc_derand(ct, ss, pk, enc_coins);
+
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        alg->keypair_derand(pk, sk, coins);
+    rows[0] = (bench_row_t){impl, "keygen", time_us_64() - t0};
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        ref_keypair(pk_ref, sk_ref, coins);
+    rows[1] = (bench_row_t){"ref", "keygen", time_us_64() - t0};
+
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        alg->enc_derand(ct, ss, pk, enc_coins);
+    rows[2] = (bench_row_t){impl, "enc", time_us_64() - t0};
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        ref_enc(ct_ref, ss_ref, pk_ref, enc_coins);
+    rows[3] = (bench_row_t){"ref", "enc", time_us_64() - t0};
+
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        alg->dec(ss_dec, ct, sk);
+    rows[4] = (bench_row_t){impl, "dec", time_us_64() - t0};
+    t0 = time_us_64();
+    for (i = 0; i < iters; i++)
+        ref_dec(ss_dec, ct_ref, sk_ref);
+    rows[5] = (bench_row_t){"ref", "dec", time_us_64() - t0};
+
+    for (r = 0; r < 6; r++) {
+        const bench_row_t *row = &rows[r];
+        const bench_row_t *ref = &rows[r | 1];
+        double mean = (double)row->us / iters;
+
+        printf("%s,%u,\"%s\",\"%s\",%s,%s,%u,%" PRIu64 ",%.2f,%.1f,%.3f\n",
+               KYBER_VARIANT, (unsigned int)alg->id, __VERSION__, KYBER_CFLAGS, row->impl, row->op,
+               iters, row->us, mean, mean > 0 ? 1e6 / mean : 0.0,
+               row->us ? (double)ref->us / row->us : 0.0);
+    }
+}
+
+/* ================= MAIN ================= */
+
+int main(int argc, char **argv)
+{
+    const char *lib_dir = KYBER_REF_LIB_DIR, *rsp_prefix = NULL, *backend = NULL;
+    unsigned int seeds = REFCHECK_SEEDS, bench_iters = 0, only = 0, failed = 0, ran = 0, a, b;
+    uint64_t base = 0;
+    int kat = 0, opt, c;
+
+    while ((opt = getopt(argc, argv, "a:B:n:s:kr:b:l:")) != -1) {
+        switch (opt) {
+        case 'a':
+            only = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'B':
+            backend = optarg;
+            break;
+        case 'n':
+            seeds = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            base = strtoull(optarg, NULL, 0);
+            break;
+        case 'k':
+            kat = 1;
+            break;
+        case 'r':
+            kat = 1;
+            rsp_prefix = optarg;
+            break;
+        case 'b':
+            bench_iters = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            lib_dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-a ID] [-B BACKEND|all] [-n SEEDS] [-s SEED] [-k] [-r PREFIX] [-b ITERS] "
+                    "[-l LIBDIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    stdio_init_all();
+    printf("Kyber reference cross-check (%s, %u parameter sets)\n", KYBER_VARIANT, kyber_alg_count);
+    if (only && !kyber_alg(only)) {
+        fprintf(stderr, "algorithm %u is not in this build\n", only);
+        return 2;
+    }
+
+    if (!backend)
+        backend = kernels_init();
+
+    if (bench_iters)
+        printf("\n=== REFCHECK BENCH BEGIN ===\n"
+               "variant,kyber_k,compiler,cflags,impl,op,iters,total_us,mean_us,ops_per_s,vs_ref\n");
+
+    for (b = 0; b < kernels_backend_count; b++) {
+        const kyber_kernels_t *k = kernels_backends[b];
+
+        if (strcmp(backend, "all") && strcmp(backend, k->name))
+            continue;
+        ran++;
+        if (!strcmp(backend, "all") && !kernels_supported(k)) {
+            printf("kernels %s: not supported on %s, skipped\n", k->name, kernels_cpu());
+            continue;
+        }
+        if (kernels_use(k->name)) {
+            printf("kernels %s: %s on %s\n", k->name,
+                   kernels_supported(k) ? "self-test FAIL" : "not supported", kernels_cpu());
+            failed = 1;
+            continue;
+        }
+        printf("kernels %s on %s\n", k->name, kernels_cpu());
+
+        for (a = 0; a < kyber_alg_count; a++) {
+            const kyber_alg_t *alg = &kyber_algs[a];
+            unsigned int alg_failed = 0;
+
+            if (only && alg->id != only)
+                continue;
+            if (ref_load(lib_dir, alg))
+                return 2;
+
+            memset(mismatches, 0, sizeof(mismatches));
+            run_seeds(alg, seeds, base);
+            printf("seeds: %u from base %" PRIu64 "\n", seeds, base);
+            if (kat) {
+                if (run_kat(alg, rsp_prefix))
+                    alg_failed = 1;
+                printf("kat: %u NIST vectors\n", KAT_VECTORS);
+            }
+
+            for (c = 0; c < CHK_COUNT; c++) {
+                printf("%-9s %u mismatches\n", chk_names[c], mismatches[c]);
+                if (mismatches[c])
+                    alg_failed = 1;
+            }
+            printf("%s %s %s\n", alg->name, k->name, alg_failed ? "FAIL" : "PASS");
+            failed |= alg_failed;
+
+            if (bench_iters && !alg_failed)
+                run_bench(alg, bench_iters);
+        }
+    }
+
+    if (!ran) {
+        fprintf(stderr, "no kernel backend %s in this build\n", backend);
+        return 2;
+    }
+    if (bench_iters)
+        printf("=== REFCHECK BENCH END ===\n");
+    return failed ? 1 : 0;
+}
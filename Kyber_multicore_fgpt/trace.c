@@ -0,0 +1,70 @@
+#include "trace.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "pico/stdlib.h"
+
+#ifdef KYBER_TRACE
+
+static trace_event_t trace_ring[2][TRACE_RING_EVENTS];
+static uint32_t trace_head[2];
+
+void trace_record(const char *name, const char *cat, uint64_t t0, uint64_t t1)
+{
+    unsigned int core = get_core_num();
+    trace_event_t *ev = &trace_ring[core][trace_head[core] % TRACE_RING_EVENTS];
+
+    ev->ts = t0;
+    ev->name = name;
+    ev->cat = cat;
+    ev->dur = (uint32_t)(t1 - t0);
+    trace_head[core]++;
+}
+
+void trace_reset(void)
+{
+    trace_head[0] = 0;
+    trace_head[1] = 0;
+}
+
+void trace_dump_json(const char *process_name)
+{
+    unsigned int core, i, n, first;
+
+    printf("\n=== TRACE JSON BEGIN ===\n");
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+           "\"args\":{\"name\":\"%s\"}}", process_name);
+
+    for (core = 0; core < 2; core++) {
+        printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+               "\"args\":{\"name\":\"core%u\"}}", core, core);
+
+        n = trace_head[core] < TRACE_RING_EVENTS ? trace_head[core] : TRACE_RING_EVENTS;
+        first = trace_head[core] - n;
+
+        for (i = 0; i < n; i++) {
+            const trace_event_t *ev = &trace_ring[core][(first + i) % TRACE_RING_EVENTS];
+            printf(",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64
+                   ",\"dur\":%" PRIu32 ",\"pid\":0,\"tid\":%u}",
+                   ev->name, ev->cat, ev->ts, ev->dur, core);
+        }
+    }
+
+    printf("\n],\"otherData\":{\"dropped_core0\":%" PRIu32 ",\"dropped_core1\":%" PRIu32 "}}\n",
+           trace_head[0] > TRACE_RING_EVENTS ? trace_head[0] - TRACE_RING_EVENTS : 0,
+           trace_head[1] > TRACE_RING_EVENTS ? trace_head[1] - TRACE_RING_EVENTS : 0);
+    printf("=== TRACE JSON END ===\n");
+}
+
+#else
+
+void trace_reset(void)
+{
+}
+
+void trace_dump_json(const char *process_name)
+{
+    (void)process_name;
+}
+
+#endif
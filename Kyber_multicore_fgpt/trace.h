@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Per-core event trace.
+ *
+ * Every job, every blocking FIFO wait and every parallel phase (on core0,
+ * spanning the jobs it encloses) is recorded as a complete event
+ * (name, start, duration) in a ring buffer owned by the core that ran it,
+ * so recording needs no locking. When a ring is full the oldest events are
+ * overwritten. trace_dump_json() prints what is left as Chrome trace-event
+ * JSON between marker lines; tools/trace_to_perfetto.py extracts it from
+ * the serial log and opens it in Perfetto.
+ *
+ * Only compiled in when KYBER_TRACE is defined; otherwise the TRACE_*
+ * macros expand to nothing and the profiled build is unchanged.
+ */
+
+#ifndef TRACE_RING_EVENTS
+#define TRACE_RING_EVENTS 512 /* per core */
+#endif
+
+#define TRACE_CAT_JOB  "job"
+#define TRACE_CAT_WAIT "wait"
+#define TRACE_CAT_SYNC "sync"
+#define TRACE_CAT_PHASE "phase"
+
+typedef struct {
+    uint64_t ts;
+    const char *name;
+    const char *cat;
+    uint32_t dur;
+} trace_event_t;
+
+#ifdef KYBER_TRACE
+
+void trace_record(const char *name, const char *cat, uint64_t t0, uint64_t t1);
+
+#define TRACE_JOB(name, t0, t1)  trace_record(name, TRACE_CAT_JOB, t0, t1)
+#define TRACE_WAIT(name, t0, t1) trace_record(name, TRACE_CAT_WAIT, t0, t1)
+#define TRACE_SYNC(name, t0, t1) trace_record(name, TRACE_CAT_SYNC, t0, t1)
+#define TRACE_PHASE(name, t0, t1) trace_record(name, TRACE_CAT_PHASE, t0, t1)
+
+#else
+
+#define TRACE_JOB(name, t0, t1)  ((void)0)
+#define TRACE_WAIT(name, t0, t1) ((void)0)
+#define TRACE_SYNC(name, t0, t1) ((void)0)
+#define TRACE_PHASE(name, t0, t1) ((void)0)
+
+#endif
+
+void trace_reset(void);
+void trace_dump_json(const char *process_name);
+
+#endif
@@ -73,3 +73,19 @@ void cmov_int16(int16_t *r, int16_t v, uint16_t b)
   b = -b;
   *r ^= b & ((*r) ^ v);
 }
+
+/*************************************************
+* Name:        secure_zero
+*
+* Description: Zeroises n bytes through a volatile pointer,
+*              so the stores are not dropped as dead
+*
+* Arguments:   void *v:  pointer to the memory to clear
+*              size_t n: number of bytes
+**************************************************/
+void secure_zero(void *v, size_t n)
+{
+  volatile uint8_t *p = (volatile uint8_t *)v;
+  while (n--)
+    *p++ = 0;
+}
@@ -5,13 +5,17 @@
 #include <stdint.h>
 #include "params.h"
 
-#define verify KYBER_NAMESPACE(verify)
+/* Zeroisation the compiler cannot drop */
+#define secure_zero KYBER_COMMON_NAMESPACE(secure_zero)
+void secure_zero(void *v, size_t n);
+
+#define verify KYBER_COMMON_NAMESPACE(verify)
 int verify(const uint8_t *a, const uint8_t *b, size_t len);
 
-#define cmov KYBER_NAMESPACE(cmov)
+#define cmov KYBER_COMMON_NAMESPACE(cmov)
 void cmov(uint8_t *r, const uint8_t *x, size_t len, uint8_t b);
 
-#define cmov_int16 KYBER_NAMESPACE(cmov_int16)
+#define cmov_int16 KYBER_COMMON_NAMESPACE(cmov_int16)
 void cmov_int16(int16_t *r, int16_t v, uint16_t b);
 
 #endif
@@ -0,0 +1,98 @@
+#include "workspace.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+static uint8_t ws_mem[KYBER_WS_BYTES] __attribute__((aligned(WS_ALIGN)));
+
+static kyber_ws_t ws_default = {{
+    {ws_mem, KYBER_WS_CORE0_BYTES, 0, 0},
+    {ws_mem + KYBER_WS_CORE0_BYTES, KYBER_WS_CORE1_BYTES, 0, 0},
+}};
+
+static kyber_ws_t ws_single;
+
+static kyber_ws_t *ws_active = &ws_default;
+
+#ifdef KYBER_WS_BANKED
+/* Each core's private scratch sits in the bank that also holds its stack */
+static uint8_t __scratch_y("kyber_ws") ws_bank0[KYBER_WS_LOCAL_BYTES] __attribute__((aligned(WS_ALIGN)));
+static uint8_t __scratch_x("kyber_ws") ws_bank1[KYBER_WS_LOCAL_BYTES] __attribute__((aligned(WS_ALIGN)));
+
+static ws_arena_t ws_bank[2] = {
+    {ws_bank0, KYBER_WS_LOCAL_BYTES, 0, 0},
+    {ws_bank1, KYBER_WS_LOCAL_BYTES, 0, 0},
+};
+
+ws_arena_t *ws_local(void)
+{
+    return &ws_bank[get_core_num()];
+}
+#endif
+
+void ws_init(kyber_ws_t *ws, void *mem, size_t len)
+{
+    uint8_t *p = (uint8_t *)mem;
+
+    if (len < KYBER_WS_BYTES || ((uintptr_t)p & (WS_ALIGN - 1)))
+        panic("workspace: need %u aligned bytes, got %u at %p",
+              (unsigned int)KYBER_WS_BYTES, (unsigned int)len, mem);
+
+    ws->core[0] = (ws_arena_t){p, KYBER_WS_CORE0_BYTES, 0, 0};
+    ws->core[1] = (ws_arena_t){p + KYBER_WS_CORE0_BYTES, len - KYBER_WS_CORE0_BYTES, 0, 0};
+}
+
+void ws_use(kyber_ws_t *ws)
+{
+    ws_active = ws ? ws : &ws_default;
+}
+
+void ws_use_single_core(unsigned int core)
+{
+    ws_single.core[core] = (ws_arena_t){ws_mem, KYBER_WS_BYTES, 0, 0};
+    ws_single.core[core ^ 1] = (ws_arena_t){NULL, 0, 0, 0};
+    ws_active = &ws_single;
+}
+
+ws_arena_t *ws_arena(void)
+{
+    return &ws_active->core[get_core_num()];
+}
+
+void *ws_alloc(ws_arena_t *a, size_t n)
+{
+    size_t top = a->top;
+    n = WS_ROUND(n);
+
+    if (n > a->size - top)
+        panic("workspace: core%u arena exhausted (%u + %u > %u bytes)",
+              get_core_num(), (unsigned int)top, (unsigned int)n, (unsigned int)a->size);
+
+    a->top = top + n;
+    if (a->top > a->peak)
+        a->peak = a->top;
+    return a->base + top;
+}
+
+static void ws_print_arena(const char *name, const ws_arena_t *a)
+{
+    printf("%s,%p,%u,%u\n", name, (void *)a->base, (unsigned int)a->size, (unsigned int)a->peak);
+}
+
+void ws_print_usage(void)
+{
+    const kyber_ws_t *ws = ws_active;
+
+    printf("\n# WORKSPACE\n");
+#ifdef KYBER_WS_BANKED
+    printf("placement,banked\n");
+#else
+    printf("placement,default\n");
+#endif
+    printf("arena,base,size_bytes,peak_bytes\n");
+    ws_print_arena("core0", &ws->core[0]);
+    ws_print_arena("core1", &ws->core[1]);
+#ifdef KYBER_WS_BANKED
+    ws_print_arena("core0_local", &ws_bank[0]);
+    ws_print_arena("core1_local", &ws_bank[1]);
+#endif
+}
@@ -0,0 +1,157 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "symmetric.h"
+#include "indcpa.h"
+#include "atcache.h"
+
+/*
+ * Bump-arena workspace for the IND-CPA temporaries.
+ *
+ * Every polynomial, matrix, seed buffer and core1 job descriptor used by
+ * indcpa_keypair_derand/indcpa_enc/indcpa_dec, the gen_matrix XOF buffer,
+ * the product in polyvec_basemul_acc_montgomery and the compare chunk of
+ * the decapsulation re-encryption are carved out of one contiguous block
+ * instead of living in function statics or on the stacks. The block is
+ * split into one sub-arena per core, so the two cores allocate
+ * concurrently without locking. Functions take a mark on entry and release back to it on exit;
+ * nothing is ever freed individually.
+ *
+ * The sizes below are the exact peak of each operation, in the order
+ * indcpa.c and kem.c allocate, so KYBER_WS_BYTES is the whole IND-CPA
+ * working set for the build's KYBER_K. It has to fit in one SRAM bank
+ * (KYBER_WS_MAX_BYTES), which is checked at compile time. A request that
+ * does not fit at run time panics instead of corrupting memory.
+ *
+ * A default workspace in .bss is active at start-up; ws_init()/ws_use()
+ * switch to caller-provided memory. Only switch between operations.
+ *
+ * Objects both cores touch (matrix, vectors, job descriptors) come from
+ * ws_arena(); scratch only the calling core touches (gen_matrix buffers,
+ * the basemul product, the matmul row accumulator and the compare chunk)
+ * from ws_local().
+ * Normally ws_local() is the core's sub-arena as well. With
+ * KYBER_WS_BANKED it is a separate block in the core's own non-striped
+ * scratch bank (SCRATCH_Y for core0, SCRATCH_X for core1, next to the
+ * stacks), so during the matmul phases the two cores only meet in the
+ * striped banks on the reads of A and s. The linker fails the build if
+ * the scratch banks overflow. The host build ignores the placement.
+ */
+
+#define WS_ALIGN 8
+#define WS_ROUND(n) (((size_t)(n) + WS_ALIGN - 1) & ~(size_t)(WS_ALIGN - 1))
+#define WS_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* One core1 job descriptor, 32 bytes on the target; indcpa.c checks each descriptor fits */
+#define KYBER_WS_JOB_BYTES (8 * sizeof(void *))
+
+/* Core-local scratch: gen_matrix, or a matmul row plus either the basemul
+ * product or the compressed row being compared */
+#define KYBER_WS_GEN_MATRIX_BYTES \
+  (WS_ROUND(GEN_MATRIX_NBLOCKS * XOF_BLOCKBYTES) + WS_ROUND(sizeof(xof_state)))
+#define KYBER_WS_BASEMUL_BYTES WS_ROUND(sizeof(poly))
+#define KYBER_WS_ROW_BYTES WS_ROUND(sizeof(poly))
+#define KYBER_WS_CHUNK_BYTES \
+  WS_ROUND(WS_MAX(KYBER_POLYCOMPRESSEDBYTES_DU, KYBER_POLYCOMPRESSEDBYTES))
+#define KYBER_WS_LOCAL_BYTES                                              \
+  WS_MAX(KYBER_WS_GEN_MATRIX_BYTES,                                      \
+         KYBER_WS_ROW_BYTES + WS_MAX(KYBER_WS_BASEMUL_BYTES, KYBER_WS_CHUNK_BYTES))
+
+/* keygen: seeds, a[K], e, pkpv, skpv, 3 jobs */
+#define KYBER_WS_KEYGEN_SHARED_BYTES                                      \
+  (WS_ROUND(2 * KYBER_SYMBYTES) + (KYBER_K + 3) * sizeof(polyvec) +      \
+   3 * KYBER_WS_JOB_BYTES)
+
+/* A^T lives in the matrix cache unless it is disabled (atcache.h) */
+#if ATC_ENTRIES > 0
+#define KYBER_WS_AT_BYTES 0
+#else
+#define KYBER_WS_AT_BYTES (KYBER_K * sizeof(polyvec))
+#endif
+
+/* enc: seed, at[K], sp, pkpv, ep, k, epp, 3 jobs; b and v stay in local scratch */
+#define KYBER_WS_ENC_SHARED_BYTES                                         \
+  (WS_ROUND(KYBER_SYMBYTES) + KYBER_WS_AT_BYTES + 3 * sizeof(polyvec) +  \
+   2 * sizeof(poly) + 3 * KYBER_WS_JOB_BYTES)
+
+/* dec: b, skpv, v, mp */
+#define KYBER_WS_DEC_SHARED_BYTES (2 * sizeof(polyvec) + 2 * sizeof(poly))
+
+/* crypto_kem_dec compares its re-encryption chunk by chunk, so it holds nothing across the calls */
+#define KYBER_WS_KEM_DEC_SHARED_BYTES \
+  WS_MAX(KYBER_WS_DEC_SHARED_BYTES, KYBER_WS_ENC_SHARED_BYTES)
+
+/* All shared objects are allocated by core0 */
+#define KYBER_WS_SHARED_BYTES \
+  WS_MAX(KYBER_WS_KEYGEN_SHARED_BYTES, KYBER_WS_KEM_DEC_SHARED_BYTES)
+
+#ifdef KYBER_WS_BANKED
+#define KYBER_WS_CORE0_BYTES KYBER_WS_SHARED_BYTES
+#define KYBER_WS_CORE1_BYTES 0
+#else
+#define KYBER_WS_CORE0_BYTES (KYBER_WS_SHARED_BYTES + KYBER_WS_LOCAL_BYTES)
+#define KYBER_WS_CORE1_BYTES KYBER_WS_LOCAL_BYTES
+#endif
+#define KYBER_WS_BYTES (KYBER_WS_CORE0_BYTES + KYBER_WS_CORE1_BYTES)
+
+#ifndef KYBER_WS_MAX_BYTES
+#define KYBER_WS_MAX_BYTES (64 * 1024) /* one RP2350 SRAM bank */
+#endif
+
+_Static_assert(KYBER_WS_BYTES <= KYBER_WS_MAX_BYTES,
+               "IND-CPA workspace does not fit in one SRAM bank");
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t top;   /* next free byte */
+    size_t peak;  /* high-water mark since ws_init() */
+} ws_arena_t;
+
+typedef struct {
+    ws_arena_t core[2];
+} kyber_ws_t;
+
+/* Splits mem (WS_ALIGN-aligned, at least KYBER_WS_BYTES) into the two sub-arenas */
+void ws_init(kyber_ws_t *ws, void *mem, size_t len);
+
+/* Makes ws the active workspace; NULL goes back to the built-in one */
+void ws_use(kyber_ws_t *ws);
+
+/*
+ * Makes the whole built-in workspace the sub-arena of one core, for
+ * running every operation on that core with core1 disabled (the KEM
+ * service runs them all on core1, see kemsvc.h). ws_use(NULL) undoes it.
+ */
+void ws_use_single_core(unsigned int core);
+
+/* Sub-arena of the calling core in the active workspace */
+ws_arena_t *ws_arena(void);
+
+/* Scratch arena private to the calling core (its scratch bank when banked) */
+#ifdef KYBER_WS_BANKED
+ws_arena_t *ws_local(void);
+#else
+#define ws_local() ws_arena()
+#endif
+
+void *ws_alloc(ws_arena_t *a, size_t n);
+
+static inline size_t ws_mark(const ws_arena_t *a)
+{
+    return a->top;
+}
+
+static inline void ws_release(ws_arena_t *a, size_t mark)
+{
+    a->top = mark;
+}
+
+void ws_print_usage(void);
+
+#endif
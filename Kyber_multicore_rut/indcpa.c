@@ -13,8 +13,6 @@
 #include <stdio.h>
 #include "pico/stdio_usb.h"
 #include "pico/stdlib.h"
-#include "mem_profile.h"
-
 
 // Volatile pointer zeroisation
 void secure_zero(void *v, size_t n)
@@ -254,13 +252,10 @@ void core1_hash_worker()
   // Wait for data from core 0
   core1_hash_data_t *data = (core1_hash_data_t *)multicore_fifo_pop_blocking();
 
-  // Core 1 does hashing and gen_a
+  // Core 1 does gen_a; core0 has already run hash_g on the seed
   const uint8_t *publicseed = data->buf;
-  hash_g(data->buf, data->buf, KYBER_SYMBYTES + 1);
   gen_a(data->a, publicseed);
 
-  check_stack_usage_core1();
-
   // Signal completion to core 0
   multicore_fifo_push_blocking(1);
 }
@@ -278,7 +273,6 @@ void core1_mul_worker()
     poly_tomont(&data->pkpv->vec[i]);
   }
 
-  check_stack_usage_core1();
   // Signal completion to core0
   multicore_fifo_push_blocking(1);
 }
@@ -290,7 +284,6 @@ void core1_pack_worker()
   // Core1 does pack_pk
   pack_pk(data->pk, data->pkpv, data->publicseed);
 
-  check_stack_usage_core1();
   // Signal completion to core0
   multicore_fifo_push_blocking(1);
 }
@@ -323,7 +316,11 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
   memcpy(buf, coins, KYBER_SYMBYTES);
   buf[KYBER_SYMBYTES] = KYBER_K;
 
-  // Launch core 1 worker for hashing
+  // core0 samples noise from noiseseed straight away, so hash_g has to be
+  // done before core1 is started; only gen_a runs in parallel
+  hash_g(buf, buf, KYBER_SYMBYTES + 1);
+
+  // Launch core 1 worker for gen_a
   multicore_launch_core1(core1_hash_worker);
 
   // Prepare and send data for core 1
@@ -342,7 +339,7 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
 
   polyvec_ntt(&skpv);
   polyvec_ntt(&e);
-  check_stack_usage_core0();
+
   // Wait for core 1 to finish hash & gen_a
   multicore_fifo_pop_blocking();
   multicore_reset_core1();
@@ -372,7 +369,7 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
     polyvec_basemul_acc_montgomery(&pkpv.vec[i], &a[i], &skpv);
     poly_tomont(&pkpv.vec[i]);
   }
-  check_stack_usage_core0();
+
   // Wait for core1 to finish before proceeding
   multicore_fifo_pop_blocking();
   multicore_reset_core1();
@@ -399,15 +396,15 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
 
   // Core0 packs secret key in parallel
   pack_sk(sk, &skpv);
-  check_stack_usage_core0();
-  // Securely zeroise 'pkpv' after use
-  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
-  secure_zero(pkpv.vec, sizeof(pkpv.vec));
 
   // Wait for core1
   multicore_fifo_pop_blocking();
   multicore_reset_core1();
 
+  // Securely zeroise 'pkpv' after use
+  // memset(pkpv.vec, 0, sizeof(pkpv.vec));
+  secure_zero(pkpv.vec, sizeof(pkpv.vec));
+
   // Finally, zeroise the secret key
   // memset(skpv.vec, 0, sizeof(skpv.vec));
   secure_zero(skpv.vec, sizeof(skpv.vec));
@@ -428,8 +425,6 @@ void core1_mul_worker_enc()
     polyvec_basemul_acc_montgomery(&data->b->vec[i], &data->at[i], data->sp);
   }
 
-  check_stack_usage_core1();
-
   // Signal completion
   multicore_fifo_push_blocking(1);
 }
@@ -438,8 +433,6 @@ void core1_frommsg_worker()
 {
   core1_frommsg_data_t *data = (core1_frommsg_data_t *)multicore_fifo_pop_blocking();
   poly_frommsg(data->k, data->m);
-  check_stack_usage_core1();
-
   multicore_fifo_push_blocking(1); // signal completion
 }
 
@@ -487,7 +480,7 @@ void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
   multicore_reset_core1();
 
   gen_at(at, seed);
-  check_stack_usage_core0();
+
   for (i = 0; i < KYBER_K; i++)
     poly_getnoise_eta1(sp.vec + i, coins, nonce++);
   for (i = 0; i < KYBER_K; i++)
@@ -521,15 +514,14 @@ void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
     polyvec_basemul_acc_montgomery(&b.vec[i], &at[i], &sp);
   }
 
-  check_stack_usage_core0();
   polyvec_basemul_acc_montgomery(&v, &pkpv, &sp);
+
   // Wait for core1 and cleanup
   multicore_fifo_pop_blocking();
   multicore_reset_core1();
 
   polyvec_invntt_tomont(&b);
   poly_invntt_tomont(&v);
-  check_stack_usage_core0();
 
   polyvec_add(&b, &b, &ep);
   poly_add(&v, &v, &epp);
@@ -587,7 +579,6 @@ void indcpa_dec(uint8_t m[KYBER_INDCPA_MSGBYTES],
   polyvec_ntt(&b);
   polyvec_basemul_acc_montgomery(&mp, &skpv, &b);
   poly_invntt_tomont(&mp);
-  check_stack_usage_core0();
   poly_sub(&mp, &v, &mp);
   poly_reduce(&mp);
   poly_tomsg(m, &mp);
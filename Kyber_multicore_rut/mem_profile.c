@@ -1,61 +1,189 @@
+#ifdef KYBER_HOST
+#define _GNU_SOURCE /* pthread_getattr_np */
+#endif
 #include "mem_profile.h"
 #include <stdio.h>
 #include <stdint.h>
-#include <malloc.h>
+#include <inttypes.h>
 
+#ifdef KYBER_HOST
+#include <pthread.h>
+#include <unistd.h>
+#include "pico/multicore.h"
+#else
 extern char* sbrk(int incr);
+#endif
 
-/* Linker-provided symbol: top of stack (Core0) */
-extern uint32_t __StackTop;
+stack_profile_t stack_prof[MEM_OP_COUNT];
 
-/* Peak stack trackers */
-static uint32_t max_stack_usage_core0 = 0;
-volatile uint32_t max_stack_usage_core1 = 0;
+static const char *const mem_op_names[MEM_OP_COUNT] = {"keygen", "encaps", "decaps"};
+
+typedef struct {
+    uintptr_t lo;
+    uintptr_t hi;
+} stack_region_t;
 
 /* =========================
-   Core0 stack tracking
+   Stack regions
    ========================= */
-void check_stack_usage_core0(void) {
-    uint32_t sp;
-    asm volatile("mov %0, sp" : "=r"(sp));
+#ifdef KYBER_HOST
+
+/* The main thread's stack is 8 MiB; only this much below the caller is painted */
+#define HOST_CORE0_PAINT_BYTES (256 * 1024)
+
+static stack_region_t core0_stack;
+
+static stack_region_t core0_region(void) {
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+
+    if (core0_stack.hi == 0) {
+        pthread_getattr_np(pthread_self(), &attr);
+        pthread_attr_getstack(&attr, &addr, &size);
+        pthread_attr_destroy(&attr);
+
+        core0_stack.hi = (uintptr_t)addr + size;
+        core0_stack.lo = (uintptr_t)__builtin_frame_address(0) - HOST_CORE0_PAINT_BYTES;
+        if (core0_stack.lo < (uintptr_t)addr)
+            core0_stack.lo = (uintptr_t)addr;
+    }
+    return core0_stack;
+}
+
+static stack_region_t core1_region(void) {
+    stack_region_t r;
+    host_core1_stack_bounds(&r.lo, &r.hi);
+    return r;
+}
+
+#else
 
-    uint32_t stack_top = (uint32_t)&__StackTop;
-    uint32_t usage = stack_top - sp;
+/* Linker-provided stack bounds (SCRATCH_Y for core0, SCRATCH_X for core1) */
+extern uint32_t __StackBottom, __StackTop;
+extern uint32_t __StackOneBottom, __StackOneTop;
+
+static stack_region_t core0_region(void) {
+    stack_region_t r = {(uintptr_t)&__StackBottom, (uintptr_t)&__StackTop};
+    return r;
+}
 
-    if (usage > max_stack_usage_core0)
-        max_stack_usage_core0 = usage;
+static stack_region_t core1_region(void) {
+    stack_region_t r = {(uintptr_t)&__StackOneBottom, (uintptr_t)&__StackOneTop};
+    return r;
 }
 
+#endif
+
 /* =========================
-   Core1 stack tracking
+   Painting and scanning
    ========================= */
-void check_stack_usage_core1(void) {
-    uint32_t sp;
-    asm volatile("mov %0, sp" : "=r"(sp));
 
-    /*
-      Core1 stack top is typically same SRAM end.
-      Using same symbol works in RP2040 because both
-      stacks grow down from high memory.
-    */
-    uint32_t stack_top = (uint32_t)&__StackTop;
-    uint32_t usage = stack_top - sp;
+/* Fill core0's stack from its limit up to just below this frame */
+static __attribute__((noinline)) void paint_core0(void) {
+    stack_region_t r = core0_region();
+    uint32_t *p = (uint32_t *)r.lo;
+    /* leave this frame and the x86-64 red zone below it untouched */
+    uint32_t *end = (uint32_t *)((uintptr_t)__builtin_frame_address(0) - 256);
+
+    while (p < end)
+        *(volatile uint32_t *)p++ = STACK_PAINT_WORD;
+}
+
+static void paint_core1(void) {
+#ifdef KYBER_HOST
+    host_core1_paint_stack(STACK_PAINT_WORD);
+#else
+    /* core1 is in reset between operations, so its whole stack is free */
+    stack_region_t r = core1_region();
+    uint32_t *p = (uint32_t *)r.lo;
 
-    if (usage > max_stack_usage_core1)
-        max_stack_usage_core1 = usage;
+    while (p < (uint32_t *)r.hi)
+        *(volatile uint32_t *)p++ = STACK_PAINT_WORD;
+#endif
+}
+
+/* Bytes between the top of the stack and the deepest overwritten word */
+static uint32_t scan_stack(stack_region_t r, uint8_t *overflow) {
+    const volatile uint32_t *p = (const uint32_t *)r.lo;
+
+    if (r.lo == r.hi)
+        return 0;
+
+    while ((uintptr_t)p < r.hi && *p == STACK_PAINT_WORD)
+        p++;
+    if ((uintptr_t)p == r.lo)
+        *overflow = 1;
+    return (uint32_t)(r.hi - (uintptr_t)p);
+}
+
+void stack_profile_begin(void) {
+    paint_core1();
+    paint_core0();
+}
+
+void stack_profile_end(mem_op_t op) {
+    stack_profile_t *s = &stack_prof[op];
+    uint32_t used;
+
+    used = scan_stack(core0_region(), &s->core0_overflow);
+    if (used > s->core0)
+        s->core0 = used;
+
+    used = scan_stack(core1_region(), &s->core1_overflow);
+    if (used > s->core1)
+        s->core1 = used;
+
+    s->runs++;
 }
 
 /* =========================
    Reporting
    ========================= */
-void print_stack_usage_core0(void) {
-    printf("Core0 max stack usage: %u bytes\n", max_stack_usage_core0);
-}
+void print_stack_usage(unsigned int ncores) {
+    stack_region_t r0 = core0_region();
+    stack_region_t r1 = core1_region();
+    unsigned int i;
 
-void print_stack_usage_core1(void) {
-    printf("Core1 max stack usage: %u bytes\n", max_stack_usage_core1);
+    printf("Stack region: core0 %u bytes", (unsigned int)(r0.hi - r0.lo));
+    if (ncores > 1)
+        printf(", core1 %u bytes", (unsigned int)(r1.hi - r1.lo));
+    printf("\n");
+
+    printf("op,runs,core0_stack_bytes%s\n", ncores > 1 ? ",core1_stack_bytes" : "");
+    for (i = 0; i < MEM_OP_COUNT; i++) {
+        const stack_profile_t *s = &stack_prof[i];
+        printf("%s,%" PRIu32 ",%" PRIu32, mem_op_names[i], s->runs, s->core0);
+        if (ncores > 1)
+            printf(",%" PRIu32, s->core1);
+        printf("\n");
+    }
+
+    for (i = 0; i < MEM_OP_COUNT; i++) {
+        if (stack_prof[i].core0_overflow)
+            printf("WARNING: %s reached the core0 stack limit (overflow likely)\n", mem_op_names[i]);
+        if (ncores > 1 && stack_prof[i].core1_overflow)
+            printf("WARNING: %s reached the core1 stack limit (overflow likely)\n", mem_op_names[i]);
+    }
 }
 
+#ifdef KYBER_HOST
+extern char __data_start[], _edata[], __bss_start[], _end[];
+#define RAM_DATA_START __data_start
+#define RAM_DATA_END _edata
+#define RAM_BSS_START __bss_start
+#define RAM_BSS_END _end
+#else
+extern char __data_start__[], __data_end__[], __bss_start__[], __bss_end__[];
+#define RAM_DATA_START __data_start__
+#define RAM_DATA_END __data_end__
+#define RAM_BSS_START __bss_start__
+#define RAM_BSS_END __bss_end__
+#endif
+
 void print_ram_usage(void) {
+    printf(".data: %u bytes, .bss: %u bytes\n",
+           (unsigned int)(RAM_DATA_END - RAM_DATA_START),
+           (unsigned int)(RAM_BSS_END - RAM_BSS_START));
     printf("Heap end addr: %p\n", sbrk(0));
 }
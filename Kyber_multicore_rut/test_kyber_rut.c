@@ -21,12 +21,18 @@ static uint8_t key_a[CRYPTO_BYTES];
 static uint8_t key_b[CRYPTO_BYTES];
 
   //Alice generates a public key
+  stack_profile_begin();
   crypto_kem_keypair(pk, sk);
+  stack_profile_end(MEM_OP_KEYGEN);
 
   //Bob derives a secret key and creates a response
+  stack_profile_begin();
   crypto_kem_enc(ct, key_b, pk);
+  stack_profile_end(MEM_OP_ENC);
   //Alice uses Bobs response to get her shared key
+  stack_profile_begin();
   crypto_kem_dec(key_a, ct, sk);
+  stack_profile_end(MEM_OP_DEC);
   if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
     return 1;
   }
@@ -146,8 +152,7 @@ int main(void)
       return 1;
   }
     printf("\n=== MEMORY PROFILE (Multi-Core) ===\n");
-    print_stack_usage_core0();
-    print_stack_usage_core1();
+    print_stack_usage(2);
     print_ram_usage();
    us = time_us_64();                    // monotonic µs since boot
    ms = to_ms_since_boot(get_absolute_time()); // ms since boot
@@ -3,10 +3,49 @@
 
 #include <stdint.h>
 
-extern volatile uint32_t core1_stack_max;
+/*
+ * Stack high-water marks by stack painting.
+ *
+ * stack_profile_begin() fills the unused part of both cores' stacks with
+ * STACK_PAINT_WORD, and stack_profile_end() scans each stack up from its
+ * limit for the first overwritten word. That gives the deepest point
+ * reached in between, including inside kernels such as gen_matrix and
+ * KeccakF1600_StatePermute that sampling SP at call sites never sees.
+ * Core1 is painted while it is held in reset, so begin/end must be called
+ * between operations, never during one.
+ *
+ * Board: core0 runs on [__StackBottom, __StackTop) and core1 on the
+ * [__StackOneBottom, __StackOneTop) stack multicore_launch_core1() gives it.
+ * Host: core0 is the main thread and core1 the host_shim worker thread,
+ * which paints its own stack before the next launched job.
+ *
+ * Static RAM per module (.data/.bss) comes from the link map, see
+ * tools/mem_map_report.py; print_ram_usage() only prints the totals.
+ */
 
-void check_stack_usage_core0(void);
-void print_stack_usage_core0(void);
+#define STACK_PAINT_WORD 0x5AA5C33Cu
+
+typedef enum {
+    MEM_OP_KEYGEN,
+    MEM_OP_ENC,
+    MEM_OP_DEC,
+    MEM_OP_COUNT
+} mem_op_t;
+
+typedef struct {
+    uint32_t core0;          /* deepest use in bytes, over all runs */
+    uint32_t core1;
+    uint32_t runs;
+    uint8_t core0_overflow;  /* the word at the stack limit was overwritten */
+    uint8_t core1_overflow;
+} stack_profile_t;
+
+extern stack_profile_t stack_prof[MEM_OP_COUNT];
+
+void stack_profile_begin(void);
+void stack_profile_end(mem_op_t op);
+
+void print_stack_usage(unsigned int ncores);
 void print_ram_usage(void);
 
 #endif
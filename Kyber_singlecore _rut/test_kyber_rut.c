@@ -21,16 +21,19 @@ static int test_keys(void)
     uint8_t key_b[CRYPTO_BYTES];
 
     // Alice generates a public key
+    stack_profile_begin();
     crypto_kem_keypair(pk, sk);
-    check_stack_usage_core0();
+    stack_profile_end(MEM_OP_KEYGEN);
 
     // Bob derives a secret key and creates a response
+    stack_profile_begin();
     crypto_kem_enc(ct, key_b, pk);
-    check_stack_usage_core0();
+    stack_profile_end(MEM_OP_ENC);
 
     // Alice uses Bobs response to get her shared key
+    stack_profile_begin();
     crypto_kem_dec(key_a, ct, sk);
-    check_stack_usage_core0();
+    stack_profile_end(MEM_OP_DEC);
     
     if (memcmp(key_a, key_b, CRYPTO_BYTES))
     {
@@ -159,8 +162,7 @@ int main(void)
     }
 
     printf("\n=== MEMORY PROFILE (Single-Core) ===\n");
-    check_stack_usage_core0();
-    print_stack_usage_core0();
+    print_stack_usage(1);
     print_ram_usage();
     us = time_us_64();                          // monotonic µs since boot[15]
     ms = to_ms_since_boot(get_absolute_time()); // ms since boot[7]
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
 #include "kem.h"
@@ -9,9 +10,18 @@
 #include <stdio.h>
 #include "pico/cyw43_arch.h"
 #include "pico/time.h"
+#include "hardware/clocks.h"
 
 #define NTESTS 1000
 
+/* Build metadata; the CMake project passes the real values */
+#ifndef KYBER_VARIANT
+#define KYBER_VARIANT "unknown"
+#endif
+#ifndef KYBER_CFLAGS
+#define KYBER_CFLAGS ""
+#endif
+
 static double mean_u64(uint64_t *arr, size_t n)
 {
     double sum = 0.0;
@@ -32,6 +42,129 @@ static double stddev_u64(uint64_t *arr, size_t n, double mean)
     return sqrt(var);
 }
 
+/* Nearest-rank percentile of an ascending array */
+static uint64_t percentile_u64(const uint64_t *sorted, size_t n, unsigned int pct)
+{
+    size_t rank = (pct * n + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Log-scale histogram buckets: HIST_SUB_BITS bits below the leading one
+ * select the sub-bucket, so each power of two is split into
+ * 2^HIST_SUB_BITS buckets (values below that are bucketed exactly).
+ */
+#define HIST_SUB_BITS 2
+#define HIST_SUB (1u << HIST_SUB_BITS)
+
+static unsigned int hist_bucket(uint64_t v)
+{
+    unsigned int msb;
+
+    if (v < 2 * HIST_SUB)
+        return (unsigned int)v;
+    msb = 63 - __builtin_clzll(v);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB + ((v >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static uint64_t hist_bucket_lo(unsigned int b)
+{
+    unsigned int shift;
+
+    if (b < 2 * HIST_SUB)
+        return b;
+    shift = b / HIST_SUB - 1;
+    return (uint64_t)(HIST_SUB + b % HIST_SUB) << shift;
+}
+
+typedef struct
+{
+    const char *op;
+    uint64_t *samples; /* sorted in place by op_stats_compute */
+    size_t n;
+    double mean, sd;
+    uint64_t min, p50, p90, p99, max;
+} op_stats_t;
+
+static void op_stats_compute(op_stats_t *s)
+{
+    s->mean = mean_u64(s->samples, s->n);
+    s->sd = stddev_u64(s->samples, s->n, s->mean);
+
+    qsort(s->samples, s->n, sizeof(uint64_t), cmp_u64);
+    s->min = s->samples[0];
+    s->p50 = percentile_u64(s->samples, s->n, 50);
+    s->p90 = percentile_u64(s->samples, s->n, 90);
+    s->p99 = percentile_u64(s->samples, s->n, 99);
+    s->max = s->samples[s->n - 1];
+}
+
+/*
+ * Machine-readable report. Each block sits between marker lines so host
+ * tools can lift it out of the serial log; every row repeats the build
+ * metadata so rows from different runs and boards can be concatenated.
+ */
+#define BENCH_META_FMT "%s,%d,%" PRIu32 ",\"%s\",\"%s\""
+#define BENCH_META_ARGS KYBER_VARIANT, KYBER_K, clock_khz, __VERSION__, KYBER_CFLAGS
+
+static void print_raw_samples(const op_stats_t *ops, size_t nops, uint32_t clock_khz)
+{
+    printf("\n=== BENCH SAMPLES BEGIN ===\n");
+    printf("variant,kyber_k,clock_khz,compiler,cflags,op,iter,us\n");
+    for (size_t k = 0; k < nops; k++)
+        for (size_t i = 0; i < ops[k].n; i++)
+            printf(BENCH_META_FMT ",%s,%u,%" PRIu64 "\n",
+                   BENCH_META_ARGS, ops[k].op, (unsigned int)i, ops[k].samples[i]);
+    printf("=== BENCH SAMPLES END ===\n");
+}
+
+static void print_bench_csv(const op_stats_t *ops, size_t nops, uint32_t clock_khz)
+{
+    printf("\n=== BENCH CSV BEGIN ===\n");
+    printf("variant,kyber_k,clock_khz,compiler,cflags,op,n,mean_us,stddev_us,"
+           "min_us,p50_us,p90_us,p99_us,max_us,ci95_lo_us,ci95_hi_us\n");
+    for (size_t k = 0; k < nops; k++)
+    {
+        const op_stats_t *s = &ops[k];
+        double ci = 1.96 * s->sd / sqrt((double)s->n);
+        printf(BENCH_META_FMT ",%s,%u,%.2f,%.2f,%" PRIu64 ",%" PRIu64 ",%" PRIu64
+               ",%" PRIu64 ",%" PRIu64 ",%.2f,%.2f\n",
+               BENCH_META_ARGS, s->op, (unsigned int)s->n, s->mean, s->sd,
+               s->min, s->p50, s->p90, s->p99, s->max, s->mean - ci, s->mean + ci);
+    }
+    printf("=== BENCH CSV END ===\n");
+
+    printf("\n=== BENCH HIST BEGIN ===\n");
+    printf("variant,kyber_k,clock_khz,compiler,cflags,op,bucket_lo_us,bucket_hi_us,count\n");
+    for (size_t k = 0; k < nops; k++)
+    {
+        const op_stats_t *s = &ops[k];
+        size_t i = 0;
+        while (i < s->n)
+        {
+            unsigned int b = hist_bucket(s->samples[i]);
+            unsigned int count = 0;
+            while (i < s->n && hist_bucket(s->samples[i]) == b)
+            {
+                count++;
+                i++;
+            }
+            printf(BENCH_META_FMT ",%s,%" PRIu64 ",%" PRIu64 ",%u\n",
+                   BENCH_META_ARGS, s->op, hist_bucket_lo(b), hist_bucket_lo(b + 1) - 1, count);
+        }
+    }
+    printf("=== BENCH HIST END ===\n");
+}
+
 static int test_keys_timed(uint64_t *d_keygen, uint64_t *d_enc, uint64_t *d_dec)
 {
     uint8_t pk[CRYPTO_PUBLICKEYBYTES];
@@ -233,5 +366,27 @@ int main(void)
     printf("  CV: %.4f\n", cv_dc);
     printf("  95%% CI: [%.2f, %.2f] us\n", mean_dc - ci_dc, mean_dc + ci_dc);
 
+    uint32_t clock_khz = clock_get_hz(clk_sys) / 1000;
+    op_stats_t ops[] = {
+        {.op = "keygen", .samples = keygen_times, .n = NTESTS},
+        {.op = "encaps", .samples = enc_times, .n = NTESTS},
+        {.op = "decaps", .samples = dec_times, .n = NTESTS},
+    };
+    const size_t nops = sizeof(ops) / sizeof(ops[0]);
+
+    // Raw samples go out in run order, before sorting for percentiles
+    print_raw_samples(ops, nops, clock_khz);
+
+    for (i = 0; i < nops; i++)
+        op_stats_compute(&ops[i]);
+
+    printf("\n--- Tail latency (us) ---\n");
+    printf("%-8s %10s %10s %10s %10s %10s\n", "", "min", "p50", "p90", "p99", "max");
+    for (i = 0; i < nops; i++)
+        printf("%-8s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+               ops[i].op, ops[i].min, ops[i].p50, ops[i].p90, ops[i].p99, ops[i].max);
+
+    print_bench_csv(ops, nops, clock_khz);
+
     return 0;
 }
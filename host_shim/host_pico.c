@@ -0,0 +1,466 @@
+/*
+ * Host implementation of the Pico SDK calls used by the Kyber variants.
+ *
+ * Core0 is the thread that runs main(); core1 is a pthread created by the
+ * first multicore_launch_core1() and reused by later launches. Each direction of the inter-core FIFO is a
+ * bounded queue guarded by a mutex, mirroring the blocking semantics of
+ * the SIO FIFOs closely enough for the job hand-off used in indcpa.c.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/rand.h"
+#include "pico/stdio_usb.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/clocks.h"
+#include "hardware/vreg.h"
+
+/* ================= TIME ================= */
+
+static uint64_t host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t host_boot_us;
+
+__attribute__((constructor)) static void host_boot(void)
+{
+    host_boot_us = host_now_us();
+}
+
+uint64_t time_us_64(void)
+{
+    return host_now_us() - host_boot_us;
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void)
+{
+    return time_us_64();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t)
+{
+    return (uint32_t)(t / 1000u);
+}
+
+void sleep_us(uint64_t us)
+{
+    struct timespec ts;
+    ts.tv_sec = us / 1000000u;
+    ts.tv_nsec = (us % 1000000u) * 1000u;
+    while (nanosleep(&ts, &ts) && errno == EINTR)
+        ;
+}
+
+void sleep_ms(uint32_t ms)
+{
+    /* The board harnesses sleep several seconds waiting for USB; the host
+       has nothing to wait for, so only short sleeps are honoured. */
+    if (ms > 100 && getenv("KYBER_HOST_REAL_SLEEP") == NULL)
+        return;
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void busy_wait_us(uint64_t us)
+{
+    uint64_t end = time_us_64() + us;
+    while (time_us_64() < end)
+        ;
+}
+
+/* ================= STDIO / GPIO ================= */
+
+bool stdio_init_all(void)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+bool stdio_usb_init(void)
+{
+    return true;
+}
+
+bool stdio_usb_connected(void)
+{
+    return true;
+}
+
+static bool host_gpio_state[64];
+
+void gpio_init(unsigned int gpio)
+{
+    host_gpio_state[gpio & 63] = false;
+}
+
+void gpio_set_dir(unsigned int gpio, bool out)
+{
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(unsigned int gpio, bool value)
+{
+    host_gpio_state[gpio & 63] = value;
+}
+
+bool gpio_get(unsigned int gpio)
+{
+    return host_gpio_state[gpio & 63];
+}
+
+int cyw43_arch_init(void)
+{
+    return PICO_OK;
+}
+
+void cyw43_arch_gpio_put(unsigned int wl_gpio, bool value)
+{
+    (void)wl_gpio;
+    (void)value;
+}
+
+/* ================= PANIC ================= */
+
+void panic(const char *fmt, ...)
+{
+    va_list ap;
+
+    fflush(stdout);
+    fputs("*** PANIC ***\n", stderr);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    abort();
+}
+
+/* ================= CLOCKS ================= */
+
+/*
+ * The host cannot change its clock; the requested frequency is remembered
+ * so reports and the power-policy layer see a consistent value.
+ */
+static uint32_t host_sys_khz;
+
+static uint32_t host_clock_khz(void)
+{
+    const char *env;
+
+    if (host_sys_khz == 0)
+    {
+        env = getenv("KYBER_HOST_CLOCK_KHZ");
+        host_sys_khz = env ? (uint32_t)strtoul(env, NULL, 10) : 0;
+        if (host_sys_khz == 0)
+            host_sys_khz = 150000;
+    }
+    return host_sys_khz;
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required)
+{
+    (void)required;
+    host_sys_khz = freq_khz;
+    return true;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    return clk_index == clk_sys ? host_clock_khz() * 1000u : 12000000u;
+}
+
+/* ================= VREG ================= */
+
+static enum vreg_voltage host_vsel = VREG_VOLTAGE_DEFAULT;
+
+void vreg_set_voltage(enum vreg_voltage voltage)
+{
+    host_vsel = voltage;
+}
+
+enum vreg_voltage vreg_get_voltage(void)
+{
+    return host_vsel;
+}
+
+/* ================= RNG ================= */
+
+uint64_t get_rand_64(void)
+{
+    uint64_t r;
+    while (getrandom(&r, sizeof(r), 0) != (ssize_t)sizeof(r))
+        ;
+    return r;
+}
+
+uint32_t get_rand_32(void)
+{
+    return (uint32_t)get_rand_64();
+}
+
+/* ================= MULTICORE ================= */
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uintptr_t buf[HOST_FIFO_DEPTH];
+    unsigned int head;
+    unsigned int count;
+} host_fifo_t;
+
+/* fifo[n] carries words written by core n to the other core */
+static host_fifo_t fifo[2] = {
+    {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, {0}, 0, 0},
+    {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, {0}, 0, 0},
+};
+
+static __thread unsigned int host_core_num;
+static pthread_t core1_thread;
+static int core1_running;
+
+unsigned int get_core_num(void)
+{
+    return host_core_num;
+}
+
+static void fifo_unlock(void *arg)
+{
+    pthread_mutex_unlock(&((host_fifo_t *)arg)->lock);
+}
+
+static void fifo_put(host_fifo_t *f, uintptr_t data)
+{
+    pthread_mutex_lock(&f->lock);
+    pthread_cleanup_push(fifo_unlock, f);
+    while (f->count == HOST_FIFO_DEPTH)
+        pthread_cond_wait(&f->cond, &f->lock);
+    f->buf[(f->head + f->count) % HOST_FIFO_DEPTH] = data;
+    f->count++;
+    pthread_cond_broadcast(&f->cond);
+    pthread_cleanup_pop(1);
+}
+
+static uintptr_t fifo_get(host_fifo_t *f)
+{
+    uintptr_t data;
+
+    pthread_mutex_lock(&f->lock);
+    pthread_cleanup_push(fifo_unlock, f);
+    while (f->count == 0)
+        pthread_cond_wait(&f->cond, &f->lock);
+    data = f->buf[f->head];
+    f->head = (f->head + 1) % HOST_FIFO_DEPTH;
+    f->count--;
+    pthread_cond_broadcast(&f->cond);
+    pthread_cleanup_pop(1);
+    return data;
+}
+
+static void fifo_clear(host_fifo_t *f)
+{
+    pthread_mutex_lock(&f->lock);
+    f->head = 0;
+    f->count = 0;
+    pthread_cond_broadcast(&f->cond);
+    pthread_mutex_unlock(&f->lock);
+}
+
+void multicore_fifo_push_blocking(uintptr_t data)
+{
+    fifo_put(&fifo[host_core_num], data);
+}
+
+uintptr_t multicore_fifo_pop_blocking(void)
+{
+    return fifo_get(&fifo[host_core_num ^ 1]);
+}
+
+bool multicore_fifo_rvalid(void)
+{
+    host_fifo_t *f = &fifo[host_core_num ^ 1];
+    bool valid;
+
+    pthread_mutex_lock(&f->lock);
+    valid = f->count != 0;
+    pthread_mutex_unlock(&f->lock);
+    return valid;
+}
+
+bool multicore_fifo_wready(void)
+{
+    host_fifo_t *f = &fifo[host_core_num];
+    bool ready;
+
+    pthread_mutex_lock(&f->lock);
+    ready = f->count != HOST_FIFO_DEPTH;
+    pthread_mutex_unlock(&f->lock);
+    return ready;
+}
+
+void multicore_fifo_drain(void)
+{
+    fifo_clear(&fifo[host_core_num ^ 1]);
+}
+
+/*
+ * core1 is one long-lived thread that runs each launched entry in turn.
+ * Creating a thread per multicore_launch_core1() costs far more on a host
+ * than the SIO handshake does on the chip and would swamp the phases being
+ * measured.
+ */
+static pthread_mutex_t core1_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t core1_cond = PTHREAD_COND_INITIALIZER;
+static void (*core1_entry)(void);
+static int core1_busy;
+
+/* How long a reset waits for a running entry before cancelling the thread */
+#define HOST_CORE1_RESET_WAIT_MS 100
+
+static uintptr_t core1_stack_lo, core1_stack_hi;
+static volatile uint32_t core1_paint_pattern;
+static volatile int core1_paint_pending;
+
+void host_core1_paint_stack(uint32_t pattern)
+{
+    core1_paint_pattern = pattern;
+    core1_paint_pending = 1;
+}
+
+void host_core1_stack_bounds(uintptr_t *lo, uintptr_t *hi)
+{
+    *lo = core1_stack_lo;
+    *hi = core1_stack_hi;
+}
+
+/* Runs on core1: fill its unused stack, leaving this frame and the x86-64
+   red zone below it alone */
+static __attribute__((noinline)) void core1_paint_self(void)
+{
+    uint32_t *p = (uint32_t *)core1_stack_lo;
+    uint32_t *end = (uint32_t *)((uintptr_t)__builtin_frame_address(0) - 256);
+
+    while (p < end)
+        *(volatile uint32_t *)p++ = core1_paint_pattern;
+    core1_paint_pending = 0;
+}
+
+static void *core1_main(void *arg)
+{
+    void (*entry)(void);
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+
+    (void)arg;
+    host_core_num = 1;
+
+    pthread_getattr_np(pthread_self(), &attr);
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    core1_stack_lo = (uintptr_t)addr;
+    core1_stack_hi = (uintptr_t)addr + size;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&core1_lock);
+        while (core1_entry == NULL)
+            pthread_cond_wait(&core1_cond, &core1_lock);
+        entry = core1_entry;
+        pthread_mutex_unlock(&core1_lock);
+
+        if (core1_paint_pending)
+            core1_paint_self();
+        entry();
+
+        pthread_mutex_lock(&core1_lock);
+        core1_entry = NULL;
+        core1_busy = 0;
+        pthread_cond_broadcast(&core1_cond);
+        pthread_mutex_unlock(&core1_lock);
+    }
+    return NULL;
+}
+
+void multicore_reset_core1(void)
+{
+    struct timespec deadline;
+    int busy;
+
+    if (!core1_running)
+        return;
+
+    /* An entry that has returned leaves the thread idle, which is all the
+       reset has to achieve. One still blocked (e.g. on the FIFO) is
+       cancelled, the closest host analogue of the hardware reset. */
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += HOST_CORE1_RESET_WAIT_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&core1_lock);
+    while (core1_busy)
+        if (pthread_cond_timedwait(&core1_cond, &core1_lock, &deadline) == ETIMEDOUT)
+            break;
+    busy = core1_busy;
+    pthread_mutex_unlock(&core1_lock);
+
+    if (busy)
+    {
+        pthread_cancel(core1_thread);
+        pthread_join(core1_thread, NULL);
+        core1_running = 0;
+        core1_stack_lo = core1_stack_hi = 0;
+        core1_entry = NULL;
+        core1_busy = 0;
+    }
+    fifo_clear(&fifo[0]);
+    fifo_clear(&fifo[1]);
+}
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    multicore_reset_core1();
+
+    if (!core1_running)
+    {
+        pthread_attr_t attr;
+        int err;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, HOST_CORE1_STACK_SIZE);
+        err = pthread_create(&core1_thread, &attr, core1_main, NULL);
+        pthread_attr_destroy(&attr);
+        if (err != 0)
+        {
+            errno = err;
+            perror("multicore_launch_core1");
+            abort();
+        }
+        core1_running = 1;
+    }
+
+    pthread_mutex_lock(&core1_lock);
+    core1_entry = entry;
+    core1_busy = 1;
+    pthread_cond_broadcast(&core1_cond);
+    pthread_mutex_unlock(&core1_lock);
+}
@@ -0,0 +1,51 @@
+# Native (host) build of a Kyber variant without the Pico SDK.
+#
+# Included by a variant's CMakeLists.txt instead of pico_sdk_import.cmake when
+# KYBER_HOST is ON. It provides no-op versions of the SDK CMake functions and
+# interface targets named after the SDK libraries, all resolving to the
+# pthread-based shim in host_pico.c, so the rest of the variant's
+# CMakeLists.txt is unchanged between board and host builds.
+
+set(KYBER_HOST_SHIM_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+# The SDK builds Release by default; keep host numbers comparable
+if (NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release CACHE STRING "Build type" FORCE)
+endif()
+
+function(pico_sdk_init)
+    if (NOT TARGET kyber_host_shim)
+        find_package(Threads REQUIRED)
+        add_library(kyber_host_shim STATIC ${KYBER_HOST_SHIM_DIR}/host_pico.c)
+        target_include_directories(kyber_host_shim PUBLIC ${KYBER_HOST_SHIM_DIR}/include)
+        target_compile_definitions(kyber_host_shim PUBLIC KYBER_HOST=1)
+        target_link_libraries(kyber_host_shim PUBLIC Threads::Threads m)
+
+        foreach(lib pico_stdlib pico_stdio_usb pico_rand pico_cyw43_arch_none
+                    pico_multicore pico_time hardware_vreg)
+            add_library(${lib} INTERFACE)
+            target_link_libraries(${lib} INTERFACE kyber_host_shim)
+        endforeach()
+    endif()
+endfunction()
+
+# Like the SDK, leave a link map next to the executable
+# (tools/mem_map_report.py reads it for per-module .data/.bss)
+function(pico_add_extra_outputs target)
+    target_link_options(${target} PRIVATE "LINKER:-Map=$<TARGET_FILE:${target}>.map")
+endfunction()
+
+function(pico_enable_stdio_usb target enable)
+endfunction()
+
+function(pico_enable_stdio_uart target enable)
+endfunction()
+
+function(pico_set_program_name target name)
+endfunction()
+
+function(pico_set_program_version target version)
+endfunction()
+
+function(pico_set_binary_type target type)
+endfunction()
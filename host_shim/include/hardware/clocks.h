@@ -0,0 +1,18 @@
+#ifndef _HOST_HARDWARE_CLOCKS_H
+#define _HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+/* Only clk_sys is meaningful on the host; it reports KYBER_HOST_CLOCK_KHZ. */
+enum clock_index {
+    clk_ref = 0,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    CLK_COUNT
+};
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
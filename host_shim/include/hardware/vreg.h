@@ -0,0 +1,27 @@
+#ifndef _HOST_HARDWARE_VREG_H
+#define _HOST_HARDWARE_VREG_H
+
+/*
+ * Core regulator stand-in. The host has no core voltage; the selection is
+ * remembered so the power-policy layer reads back what it set.
+ */
+
+enum vreg_voltage {
+    VREG_VOLTAGE_0_85,
+    VREG_VOLTAGE_0_90,
+    VREG_VOLTAGE_0_95,
+    VREG_VOLTAGE_1_00,
+    VREG_VOLTAGE_1_05,
+    VREG_VOLTAGE_1_10,
+    VREG_VOLTAGE_1_15,
+    VREG_VOLTAGE_1_20,
+    VREG_VOLTAGE_1_25,
+    VREG_VOLTAGE_1_30,
+    VREG_VOLTAGE_DEFAULT = VREG_VOLTAGE_1_10,
+    VREG_VOLTAGE_MAX = VREG_VOLTAGE_1_30
+};
+
+void vreg_set_voltage(enum vreg_voltage voltage);
+enum vreg_voltage vreg_get_voltage(void);
+
+#endif
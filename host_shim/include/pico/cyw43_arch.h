@@ -0,0 +1,11 @@
+#ifndef _HOST_PICO_CYW43_ARCH_H
+#define _HOST_PICO_CYW43_ARCH_H
+
+#include <stdbool.h>
+
+#define CYW43_WL_GPIO_LED_PIN 0
+
+int cyw43_arch_init(void);
+void cyw43_arch_gpio_put(unsigned int wl_gpio, bool value);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _HOST_PICO_MULTICORE_H
+#define _HOST_PICO_MULTICORE_H
+
+/*
+ * Host stand-in for pico/multicore.h: core1 is a pthread and the two
+ * inter-core FIFOs are bounded queues. FIFO words are uintptr_t rather
+ * than uint32_t so that the job-descriptor pointers the KEM code pushes
+ * survive on 64-bit hosts.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/platform.h"
+
+#define HOST_FIFO_DEPTH 8
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1(void);
+
+void multicore_fifo_push_blocking(uintptr_t data);
+uintptr_t multicore_fifo_pop_blocking(void);
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_drain(void);
+
+/*
+ * Host only, for stack painting (mem_profile.c). core1 cannot be painted
+ * from core0 while its thread sleeps on the stack being painted, so the
+ * thread paints itself, below its own frame, before the next launched
+ * entry runs. host_core1_stack_bounds() reports [0, 0) until the thread
+ * has started.
+ */
+#define HOST_CORE1_STACK_SIZE (1024 * 1024)
+
+void host_core1_paint_stack(uint32_t pattern);
+void host_core1_stack_bounds(uintptr_t *lo, uintptr_t *hi);
+
+#endif
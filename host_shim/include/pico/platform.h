@@ -0,0 +1,22 @@
+#ifndef _HOST_PICO_PLATFORM_H
+#define _HOST_PICO_PLATFORM_H
+
+/*
+ * Host stand-in for pico/platform.h. Section placement attributes have no
+ * meaning on the host, so they expand to the plain declaration.
+ */
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __no_inline_not_in_flash_func(func_name) __attribute__((noinline)) func_name
+#define __scratch_x(name)
+#define __scratch_y(name)
+#define __uninitialized_ram(name) name
+
+unsigned int get_core_num(void);
+
+/* Prints the message to stderr and aborts */
+void __attribute__((noreturn)) panic(const char *fmt, ...);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _HOST_PICO_RAND_H
+#define _HOST_PICO_RAND_H
+
+#include <stdint.h>
+
+uint32_t get_rand_32(void);
+uint64_t get_rand_64(void);
+
+#endif
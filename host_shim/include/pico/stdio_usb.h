@@ -0,0 +1,9 @@
+#ifndef _HOST_PICO_STDIO_USB_H
+#define _HOST_PICO_STDIO_USB_H
+
+#include <stdbool.h>
+
+bool stdio_usb_init(void);
+bool stdio_usb_connected(void);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _HOST_PICO_STDLIB_H
+#define _HOST_PICO_STDLIB_H
+
+/*
+ * Host stand-in for the subset of pico/stdlib.h used by the Kyber harnesses.
+ * GPIO calls are accepted and ignored; timing and sleeps map to the host clock.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include "pico/time.h"
+#include "pico/platform.h"
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+
+#define PICO_DEFAULT_LED_PIN 25
+
+#define GPIO_IN  false
+#define GPIO_OUT true
+
+#define hard_assert(x) assert(x)
+
+bool stdio_init_all(void);
+
+void gpio_init(unsigned int gpio);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+
+static inline void tight_loop_contents(void) {}
+
+#endif
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Energy model for Kyber_multicore_fgpt: calibration and re-estimation.
+
+test_kyber_fgpt prints a "# ENERGY" block after the phase profile (see
+energy.h). For every KEM operation and parallel phase it lists the wall
+time and how long each core was active, plus an estimate in uJ from
+
+    P = base_mw + core0_mw * [core0 active] + core1_mw * [core1 active]
+
+The last row, "window,total", covers the timed loop, which the harness
+brackets with GP2 high, so it lines up with one INA219 measurement from
+Arduino_test_file.ino ("Measurement stopped. Total energy (mWh): X").
+
+calibrate fits the coefficients by least squares over pairs of Pico and
+Arduino logs captured from the same run. The pairs need different activity
+mixes: K=2/3/4 builds, other clocks, and an idle capture (a GP2 pulse with
+the board doing nothing, passed as --idle ARDUINO_LOG:SECONDS) to pin down
+base_mw. The core increments are shared unless --per-core is given.
+
+    python3 tools/energy_model.py calibrate k2.log:k2.ino.log k4.log:k4.ino.log \\
+        --idle idle.ino.log:30
+
+It prints the KYBER_ENERGY_COEFFS value for CMake and the residual of every
+pair. estimate re-applies coefficients (the ones in the log by default) to
+the activity rows of a log, e.g. to compare runs made before calibrating:
+
+    python3 tools/energy_model.py estimate k3.log --base 91.5 --core 14.2
+"""
+
+import argparse
+import re
+import sys
+
+ENERGY_HEADER = "# ENERGY"
+COEFF_FIELDS = ("base_mw", "core0_mw", "core1_mw", "fit_clock_khz", "clock_khz", "calibrated")
+ROW_FIELDS = ("op", "part", "wall_us", "core0_active_us", "core1_active_us", "est_uj", "percent")
+RIG_TOTAL = re.compile(r"Total energy \(mWh\):\s*([-+0-9.eE]+)")
+
+
+def parse_energy(text):
+    """Return (coefficients, rows) of every ENERGY block in a Pico serial log."""
+    blocks = []
+    lines = [l.strip("\r").strip() for l in text.splitlines()]
+    i = 0
+    while i < len(lines):
+        if lines[i] != ENERGY_HEADER:
+            i += 1
+            continue
+        coeffs, rows = None, []
+        i += 1
+        while i < len(lines) and lines[i] and not lines[i].startswith("#"):
+            cells = lines[i].split(",")
+            if cells[0] in (COEFF_FIELDS[0], ROW_FIELDS[0]):
+                pass
+            elif len(cells) == len(COEFF_FIELDS) and coeffs is None:
+                coeffs = dict(zip(COEFF_FIELDS, (float(c) for c in cells)))
+            elif len(cells) == len(ROW_FIELDS):
+                row = dict(zip(ROW_FIELDS, cells))
+                for k in ROW_FIELDS[2:]:
+                    row[k] = float(row[k])
+                rows.append(row)
+            i += 1
+        if coeffs is not None:
+            blocks.append((coeffs, rows))
+    return blocks
+
+
+def parse_rig(text):
+    """Energies in mJ of every INA219 measurement in an Arduino log."""
+    return [float(m.group(1)) * 3600.0 for m in RIG_TOTAL.finditer(text)]
+
+
+def read(path):
+    with open(path, errors="replace") as f:
+        return f.read()
+
+
+def window(rows):
+    for row in rows:
+        if row["op"] == "window" and row["part"] == "total":
+            return row
+    return None
+
+
+def estimate_uj(row, base, core0, core1):
+    return (base * row["wall_us"] + core0 * row["core0_active_us"] +
+            core1 * row["core1_active_us"]) / 1000.0
+
+
+def solve(a, b):
+    """Least squares a x = b through the normal equations (tiny systems only)."""
+    n = len(a[0])
+    m = [[sum(r[i] * r[j] for r in a) for j in range(n)] +
+         [sum(r[i] * y for r, y in zip(a, b))] for i in range(n)]
+    for col in range(n):
+        piv = max(range(col, n), key=lambda r: abs(m[r][col]))
+        if abs(m[piv][col]) < 1e-12:
+            sys.exit("calibration is singular: the captures need different activity mixes "
+                     "(add an --idle capture or another K/clock)")
+        m[col], m[piv] = m[piv], m[col]
+        for r in range(n):
+            if r != col:
+                f = m[r][col] / m[col][col]
+                m[r] = [x - f * y for x, y in zip(m[r], m[col])]
+    return [m[i][n] / m[i][i] for i in range(n)]
+
+
+def cmd_calibrate(args):
+    samples = []   # (label, wall_s, core0_s, core1_s, measured_mj, clock_khz)
+    clocks = set()
+    for pair in args.pairs:
+        pico, sep, rig = pair.rpartition(":")
+        if not sep:
+            sys.exit("%s: expected PICO_LOG:ARDUINO_LOG" % pair)
+        blocks = parse_energy(read(pico))
+        measured = parse_rig(read(rig))
+        if len(blocks) != len(measured):
+            sys.exit("%s has %d ENERGY blocks but %s has %d measurements" %
+                     (pico, len(blocks), rig, len(measured)))
+        for n, ((coeffs, rows), mj) in enumerate(zip(blocks, measured)):
+            w = window(rows)
+            if w is None:
+                sys.exit("%s: ENERGY block %d has no window row" % (pico, n))
+            clocks.add(int(coeffs["clock_khz"]))
+            samples.append(("%s#%d" % (pico, n), w["wall_us"] / 1e6, w["core0_active_us"] / 1e6,
+                            w["core1_active_us"] / 1e6, mj))
+
+    for idle in args.idle:
+        rig, sep, secs = idle.rpartition(":")
+        if not sep:
+            sys.exit("%s: expected ARDUINO_LOG:SECONDS" % idle)
+        for n, mj in enumerate(parse_rig(read(rig))):
+            samples.append(("%s#%d (idle)" % (rig, n), float(secs), 0.0, 0.0, mj))
+
+    if len(clocks) > 1:
+        sys.exit("captures at different clocks (%s kHz); calibrate one clock at a time" %
+                 ", ".join(str(c) for c in sorted(clocks)))
+    nparams = 3 if args.per_core else 2
+    if len(samples) < nparams:
+        sys.exit("need at least %d captures, got %d" % (nparams, len(samples)))
+
+    # mW * s = mJ
+    if args.per_core:
+        a = [[w, c0, c1] for _, w, c0, c1, _ in samples]
+    else:
+        a = [[w, c0 + c1] for _, w, c0, c1, _ in samples]
+    x = solve(a, [s[4] for s in samples])
+    base, core0, core1 = (x[0], x[1], x[2]) if args.per_core else (x[0], x[1], x[1])
+    clock = clocks.pop() if clocks else 150000
+
+    print("%-40s %12s %12s %8s" % ("capture", "measured_mj", "model_mj", "err%"))
+    for label, w, c0, c1, mj in samples:
+        model = base * w + core0 * c0 + core1 * c1
+        print("%-40s %12.3f %12.3f %8.2f" % (label, mj, model, 100.0 * (model - mj) / mj if mj else 0.0))
+
+    print("\nbase_mw=%.3f core0_mw=%.3f core1_mw=%.3f at %d kHz" % (base, core0, core1, clock))
+    print('-DKYBER_ENERGY_COEFFS="ENERGY_BASE_MW=%.3f;ENERGY_CORE0_MW=%.3f;ENERGY_CORE1_MW=%.3f;'
+          'ENERGY_FIT_CLOCK_KHZ=%d;ENERGY_CALIBRATED=1"' % (base, core0, core1, clock))
+
+
+def cmd_estimate(args):
+    blocks = parse_energy(read(args.log))
+    if not blocks:
+        sys.exit("%s: no ENERGY block" % args.log)
+    measured = parse_rig(read(args.rig)) if args.rig else []
+
+    for n, (coeffs, rows) in enumerate(blocks):
+        # the log prints the increments already rescaled to its clock
+        base = coeffs["base_mw"] if args.base is None else args.base
+        core0 = coeffs["core0_mw"] if args.core0 is None else args.core0
+        core1 = coeffs["core1_mw"] if args.core1 is None else args.core1
+        if args.core is not None:
+            core0 = core1 = args.core
+
+        print("# block %d: base_mw=%.3f core0_mw=%.3f core1_mw=%.3f clock_khz=%d" %
+              (n, base, core0, core1, coeffs["clock_khz"]))
+        print("%-7s %-10s %12s %12s %12s %12s" % ("op", "part", "wall_us", "core0_us", "core1_us", "est_uj"))
+        for row in rows:
+            print("%-7s %-10s %12.2f %12.2f %12.2f %12.2f" %
+                  (row["op"], row["part"], row["wall_us"], row["core0_active_us"],
+                   row["core1_active_us"], estimate_uj(row, base, core0, core1)))
+
+        w = window(rows)
+        if w is not None and n < len(measured):
+            est_mj = estimate_uj(w, base, core0, core1) / 1000.0
+            print("window: model %.3f mJ, rig %.3f mJ, error %.2f%%" %
+                  (est_mj, measured[n], 100.0 * (est_mj - measured[n]) / measured[n]))
+        print()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    cal = sub.add_parser("calibrate", help="fit the coefficients against INA219 measurements")
+    cal.add_argument("pairs", nargs="+", help="PICO_LOG:ARDUINO_LOG of one run each")
+    cal.add_argument("--idle", action="append", default=[],
+                     help="ARDUINO_LOG:SECONDS of a GP2 pulse with the board idle")
+    cal.add_argument("--per-core", action="store_true",
+                     help="fit core0 and core1 separately instead of one shared increment")
+    cal.set_defaults(func=cmd_calibrate)
+
+    est = sub.add_parser("estimate", help="re-apply coefficients to the activity rows of a log")
+    est.add_argument("log", help="serial log of test_kyber_fgpt")
+    est.add_argument("--rig", help="Arduino log of the same run, to compare the window")
+    est.add_argument("--base", type=float, help="base_mw (default: the log's)")
+    est.add_argument("--core", type=float, help="shared core increment in mW")
+    est.add_argument("--core0", type=float, help="core0 increment in mW")
+    est.add_argument("--core1", type=float, help="core1 increment in mW")
+    est.set_defaults(func=cmd_estimate)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""Load generator for the KEM co-processor service (Kyber_multicore_fgpt/kemsvc.h).
+
+Talks the kemsvc frame protocol to the board's USB-CDC port, or to the pty
+of a host build (kemsvc prints its path):
+
+    python3 tools/kem_loadgen.py /dev/ttyACM0
+    python3 tools/kem_loadgen.py --alg 3 --handshakes 2000 --window 4 /dev/pts/7
+    python3 tools/kem_loadgen.py --ephemeral --csv load.csv /dev/ttyACM0
+
+A handshake is an ENC to the public key in a board slot followed by a DEC of
+the returned ciphertext with that slot's key, and the two shared secrets
+must agree; with --ephemeral every handshake first makes a fresh KEYPAIR
+in its own slot. Up to --window handshakes are in flight; above 1 the next
+request is already on the wire while core1 computes, which is the overlap
+the service is built for.
+
+Against a host build started as `kemsvc -r BYTES_PER_S` the responses
+come at the pace of a slow wire; with and without -b (buffered ENC
+responses) the enc latency shows what streaming the ciphertext saves.
+
+The report gives handshakes/s and the latency percentiles per op (request
+written -> response read) and per handshake, next to the board's own mean
+queue and run times per job from INFO, so the link's share of the latency
+is the difference. The rows are printed between "=== KEMSVC LOAD BEGIN ==="
+and "=== KEMSVC LOAD END ===" and, with --csv, written to a file.
+"""
+
+import argparse
+import binascii
+import csv
+import math
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+MAGIC = 0xA5
+OP_INFO, OP_KEYPAIR, OP_ENC, OP_DEC = 1, 2, 3, 4
+OP_RESPONSE = 0x80
+OP_NAMES = {OP_KEYPAIR: "keypair", OP_ENC: "enc", OP_DEC: "dec"}
+STATUS = ("ok", "crc", "op", "alg", "len", "slot", "kem")
+HEADER = struct.Struct("<BBBBHH")
+MAX_PAYLOAD = 1568 + 32
+
+# alg -> (publickeybytes, ciphertextbytes, shared secret bytes)
+SIZES = {2: (800, 768, 32), 3: (1184, 1088, 32), 4: (1568, 1568, 32)}
+
+FIELDS = ("variant", "kyber_k", "clock_khz", "kernels", "window", "ephemeral", "op", "n",
+          "per_s", "mean_us", "p50_us", "p90_us", "p99_us", "max_us", "board_queue_us",
+          "board_run_us")
+
+
+def crc16(data):
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def encode(op, alg, slot, seq, payload=b""):
+    frame = HEADER.pack(MAGIC, op, alg, slot, seq & 0xFFFF, len(payload)) + payload
+    return frame + struct.pack("<H", crc16(frame))
+
+
+class Link:
+    """The serial port or pty, raw and non-blocking, with a frame parser."""
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        if os.isatty(self.fd):
+            tty.setraw(self.fd)
+            termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.rx = bytearray()
+        self.tx = bytearray()
+
+    def send(self, frame):
+        self.tx += frame
+
+    def frames(self):
+        """Complete frames received so far: (op, alg, status, seq, payload)."""
+        while True:
+            start = self.rx.find(MAGIC)
+            if start < 0:
+                self.rx.clear()
+                return
+            del self.rx[:start]
+            if len(self.rx) < HEADER.size:
+                return
+            _, op, alg, status, seq, n = HEADER.unpack_from(self.rx)
+            if n > MAX_PAYLOAD:
+                del self.rx[:1]
+                continue
+            end = HEADER.size + n
+            if len(self.rx) < end + 2:
+                return
+            if crc16(bytes(self.rx[:end])) != struct.unpack_from("<H", self.rx, end)[0]:
+                del self.rx[:1]
+                continue
+            payload = bytes(self.rx[HEADER.size:end])
+            del self.rx[:end + 2]
+            yield op, alg, status, seq, payload
+
+    def pump(self, timeout):
+        """Write what is pending and read what has arrived, waiting at most timeout."""
+        r, w, _ = select.select([self.fd], [self.fd] if self.tx else [], [], timeout)
+        if w:
+            n = os.write(self.fd, self.tx)
+            del self.tx[:n]
+        if r:
+            data = os.read(self.fd, 65536)
+            if not data:
+                sys.exit("link closed")
+            self.rx += data
+
+    def call(self, op, alg=0, slot=0, payload=b"", seq=0xFFFF, timeout=10.0):
+        """One request answered before anything else is sent."""
+        self.send(encode(op, alg, slot, seq, payload))
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            self.pump(0.05)
+            for rop, _, status, rseq, body in self.frames():
+                if rseq == seq and rop == op | OP_RESPONSE:
+                    return status, body
+        sys.exit("no response to op %d within %.0f s" % (op, timeout))
+
+
+def info(link):
+    status, body = link.call(OP_INFO)
+    if status:
+        sys.exit("INFO failed: %s" % STATUS[status])
+    return dict(line.split("=", 1) for line in body.decode().splitlines() if "=" in line)
+
+
+def percentile(sorted_vals, p):
+    k = (len(sorted_vals) - 1) * p / 100.0
+    lo = math.floor(k)
+    hi = min(lo + 1, len(sorted_vals) - 1)
+    return sorted_vals[lo] + (sorted_vals[hi] - sorted_vals[lo]) * (k - lo)
+
+
+def run(link, args):
+    """Runs warm-up plus measured handshakes; returns per-op and handshake latencies in us."""
+    _, ct_bytes, ss_bytes = SIZES[args.alg]
+    total = args.warmup + args.handshakes
+    lat = {"keypair": [], "enc": [], "dec": [], "handshake": []}
+    inflight = {}       # seq -> (handshake, op, t_sent)
+    hs = {}             # handshake -> {"slot", "t0", "ss"}
+    free_slots = list(range(args.window))
+    started = done = failed = 0
+    seq = 0
+    static_pk = None
+
+    if not args.ephemeral:
+        status, static_pk = link.call(OP_KEYPAIR, args.alg, 0)
+        if status:
+            sys.exit("KEYPAIR failed: %s" % STATUS[status])
+
+    def request(h, op, slot, payload=b""):
+        nonlocal seq
+        link.send(encode(op, args.alg, slot, seq, payload))
+        inflight[seq] = (h, op, time.perf_counter())
+        seq = (seq + 1) & 0x7FFF
+
+    t_start = None
+    while done < total:
+        while started < total and len(hs) < args.window:
+            h = started
+            started += 1
+            if h == args.warmup:
+                t_start = time.perf_counter()
+            slot = free_slots.pop() if args.ephemeral else 0
+            hs[h] = {"slot": slot, "t0": time.perf_counter()}
+            if args.ephemeral:
+                request(h, OP_KEYPAIR, slot)
+            else:
+                request(h, OP_ENC, 0, static_pk)
+
+        link.pump(1.0)
+        for op, _, status, rseq, body in link.frames():
+            if rseq not in inflight:
+                continue
+            h, rop, t_sent = inflight.pop(rseq)
+            now = time.perf_counter()
+            state = hs[h]
+            if h >= args.warmup:
+                lat[OP_NAMES[rop]].append((now - t_sent) * 1e6)
+            if status or op != rop | OP_RESPONSE:
+                failed += 1
+                print("handshake %d: %s -> %s"
+                      % (h, OP_NAMES[rop], STATUS[status] if status < len(STATUS) else status))
+                rop = OP_DEC  # give up on this handshake
+                body = None
+            if rop == OP_KEYPAIR:
+                request(h, OP_ENC, 0, body)
+            elif rop == OP_ENC:
+                state["ss"] = body[ct_bytes:]
+                request(h, OP_DEC, state["slot"], body[:ct_bytes])
+            else:
+                if body is not None:
+                    if body != state["ss"] or len(body) != ss_bytes:
+                        failed += 1
+                        print("handshake %d: shared secrets differ" % h)
+                    elif h >= args.warmup:
+                        lat["handshake"].append((now - state["t0"]) * 1e6)
+                if args.ephemeral:
+                    free_slots.append(state["slot"])
+                del hs[h]
+                done += 1
+
+    elapsed = time.perf_counter() - (t_start or time.perf_counter())
+    return lat, elapsed, failed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="board USB-CDC device or host kemsvc pty")
+    ap.add_argument("--alg", type=int, default=None, choices=sorted(SIZES),
+                    help="parameter set (default: the first one the service has)")
+    ap.add_argument("--handshakes", type=int, default=500, help="measured handshakes (default 500)")
+    ap.add_argument("--warmup", type=int, default=20, help="unmeasured handshakes first (default 20)")
+    ap.add_argument("--window", type=int, default=2, help="handshakes in flight (default 2)")
+    ap.add_argument("--ephemeral", action="store_true", help="fresh KEYPAIR per handshake")
+    ap.add_argument("--csv", help="write the result rows as CSV")
+    args = ap.parse_args()
+
+    link = Link(args.port)
+    before = info(link)
+    algs = [int(a) for a in before.get("algs", "").split(",") if a]
+    if args.alg is None:
+        args.alg = algs[0]
+    if args.alg not in algs:
+        sys.exit("the service has no alg %d (has %s)" % (args.alg, before.get("algs")))
+    if args.ephemeral and args.window > int(before["slots"]):
+        sys.exit("--ephemeral needs a slot per handshake in flight (%s slots)" % before["slots"])
+
+    print("kemsvc %s, algs %s, kernels %s (%s), clk_sys %s kHz, queue %s, streaming %s"
+          % (before["variant"], before["algs"], before["kernels"], before["cpu"],
+             before["clock_khz"], before["queue_depth"], before.get("streaming", "0")))
+    lat, elapsed, failed = run(link, args)
+    after = info(link)
+
+    meta = {"variant": before["variant"], "kyber_k": args.alg, "clock_khz": before["clock_khz"],
+            "kernels": before["kernels"], "window": args.window, "ephemeral": int(args.ephemeral)}
+    rows = []
+    for op in ("keypair", "enc", "dec", "handshake"):
+        vals = sorted(lat[op])
+        if not vals:
+            continue
+        row = dict(meta, op=op, n=len(vals), per_s="%.1f" % (len(vals) / elapsed if elapsed else 0),
+                   mean_us="%.1f" % (sum(vals) / len(vals)),
+                   p50_us="%.1f" % percentile(vals, 50), p90_us="%.1f" % percentile(vals, 90),
+                   p99_us="%.1f" % percentile(vals, 99), max_us="%.1f" % vals[-1],
+                   board_queue_us="", board_run_us="")
+        if op != "handshake":
+            jobs = int(after[op + "_jobs"]) - int(before[op + "_jobs"])
+            if jobs:
+                for k in ("queue", "run"):
+                    d = int(after["%s_%s_us" % (op, k)]) - int(before["%s_%s_us" % (op, k)])
+                    row["board_%s_us" % k] = "%.1f" % (d / jobs)
+        rows.append(row)
+
+    print("%d handshakes in %.2f s: %.1f handshakes/s, %d failed"
+          % (len(lat["handshake"]), elapsed, len(lat["handshake"]) / elapsed if elapsed else 0, failed))
+    print("=== KEMSVC LOAD BEGIN ===")
+    print(",".join(FIELDS))
+    for row in rows:
+        print(",".join(str(row[f]) for f in FIELDS))
+    print("=== KEMSVC LOAD END ===")
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=FIELDS)
+            w.writeheader()
+            w.writerows(rows)
+        print("wrote %s" % args.csv)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Per-kernel XIP flash vs SRAM comparison from bench_primitives logs.
+
+Kyber_multicore_fgpt builds the primitive benchmark twice: bench_primitives
+runs every kernel from XIP flash, and bench_primitives_ram runs the hot set
+from SRAM (KYBER_RAM_KERNELS, see ramfunc.h). Each program times every
+kernel with core1 idle and with core1 busy on its own work. Pass the serial
+logs of both programs (or one log containing both CSV blocks):
+
+    python3 tools/kernel_placement.py xip.log ram.log
+    python3 tools/kernel_placement.py --csv placement.csv xip.log ram.log
+
+For every kernel and core1 state the report lists the median time per call
+in each placement, the speed-up (xip / ram), and the spread
+(max - min) / median of both. Spread is the number to watch for XIP cache
+thrashing, which shows up as outliers more than as a shifted median.
+
+Host builds time every kernel backend (ref, avx2, avx512; see kernels.h)
+and the rows are compared per backend; logs from before the backend column
+count as ref.
+"""
+
+import argparse
+import csv
+import sys
+
+BEGIN = "=== BENCH PRIMITIVES BEGIN ==="
+END = "=== BENCH PRIMITIVES END ==="
+PLACEMENTS = ("xip", "ram")
+
+
+def parse_log(text):
+    """Yield the CSV rows of every BENCH PRIMITIVES block in a serial log."""
+    block = None
+    for line in text.splitlines():
+        line = line.strip("\r")
+        if line.strip() == BEGIN:
+            block = []
+        elif line.strip() == END and block is not None:
+            yield from csv.DictReader(block)
+            block = None
+        elif block is not None and line:
+            block.append(line)
+
+
+def spread(row):
+    p50 = float(row["p50_ns"])
+    return 100.0 * (float(row["max_ns"]) - float(row["min_ns"])) / p50 if p50 else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("logs", nargs="+", help="serial logs of bench_primitives and bench_primitives_ram")
+    ap.add_argument("--csv", help="write the comparison table as CSV")
+    args = ap.parse_args()
+
+    # (kyber_k, backend, core1, primitive) -> placement -> row; later logs win
+    table = {}
+    order = []
+    for path in args.logs:
+        with open(path, errors="replace") as f:
+            for row in parse_log(f.read()):
+                if "placement" not in row:
+                    sys.exit("%s: no placement column (bench_primitives predates the RAM build)" % path)
+                key = (row["kyber_k"], row.get("backend") or "ref", row["core1"], row["primitive"])
+                if key not in table:
+                    table[key] = {}
+                    order.append(key)
+                table[key][row["placement"]] = row
+
+    missing = [p for p in PLACEMENTS if not any(p in v for v in table.values())]
+    if missing:
+        sys.exit("no %s results in the given logs" % " or ".join(missing))
+
+    out = []
+    for key in order:
+        v = table[key]
+        if not all(p in v for p in PLACEMENTS):
+            continue
+        xip, ram = v["xip"], v["ram"]
+        ram_p50 = float(ram["p50_ns"])
+        out.append(key + (int(xip["p50_ns"]), int(ram["p50_ns"]),
+                          float(xip["p50_ns"]) / ram_p50 if ram_p50 else float("nan"),
+                          spread(xip), spread(ram)))
+
+    print("%-2s %-7s %-5s %-32s %10s %10s %8s %10s %10s" %
+          ("k", "backend", "core1", "primitive", "xip_p50", "ram_p50", "speedup", "xip_spr%", "ram_spr%"))
+    for k, backend, core1, prim, xp, rp, sp, xs, rs in out:
+        print("%-2s %-7s %-5s %-32s %10d %10d %7.2fx %10.1f %10.1f" %
+              (k, backend, core1, prim, xp, rp, sp, xs, rs))
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(("kyber_k", "backend", "core1", "primitive", "xip_p50_ns", "ram_p50_ns",
+                        "speedup", "xip_spread_pct", "ram_spread_pct"))
+            for row in out:
+                w.writerow(row[:6] + tuple("%.3f" % x for x in row[6:]))
+        print("\nwrote %s" % args.csv)
+
+
+if __name__ == "__main__":
+    main()
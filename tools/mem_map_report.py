@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Static RAM (.data/.bss) per module from a GNU ld link map.
+
+The Pico build leaves <target>.elf.map next to the ELF (pico_add_extra_outputs)
+and the host build (-DKYBER_HOST=ON) leaves <target>.map. This script sums the
+input sections placed in the RAM output sections per object file, and lists
+the largest individual objects. Variants compiled with -fdata-sections (the
+_rut ones) get one input section per variable, so the per-object list names
+the actual static buffers.
+
+Code and tables placed in SRAM with __not_in_flash_func/__not_in_flash
+(.time_critical.* input sections, e.g. Kyber_multicore_fgpt built with
+-DKYBER_RAM_KERNELS=ON) are copied into .data at boot. They are counted in a
+separate "ramcode" column, which is the SRAM cost of running them from RAM.
+
+    python3 tools/mem_map_report.py build/Kyber_multicore_rut.elf.map
+    python3 tools/mem_map_report.py --csv ram.csv --top 20 build/Kyber_multicore_rut.elf.map
+"""
+
+import argparse
+import csv
+import os
+import re
+import sys
+from collections import defaultdict
+
+# Output sections that occupy RAM, grouped into the report columns. The
+# scratch and uninitialized sections only exist in the Pico linker scripts.
+RAM_SECTIONS = {
+    ".data": "data", ".tdata": "data", ".sdata": "data",
+    ".scratch_x": "scratch", ".scratch_y": "scratch",
+    ".bss": "bss", ".tbss": "bss", ".sbss": "bss",
+    ".uninitialized_data": "bss",
+}
+COLUMNS = ("data", "bss", "scratch", "ramcode")
+RAMCODE_PREFIX = ".time_critical"
+
+OUTPUT_RE = re.compile(r"^(\.\S+)(?:\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+.*)?$")
+INPUT_RE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+NAME_ONLY_RE = re.compile(r"^ (\S+)\s*$")
+ADDR_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def module_name(path):
+    """CMakeFiles/x.dir/indcpa.c.obj -> indcpa.c, libfoo.a(bar.c.obj) -> libfoo.a(bar.c)"""
+    path = path.strip()
+    m = re.match(r"(.*\.a)\((.*)\)$", path)
+    if m:
+        return "%s(%s)" % (os.path.basename(m.group(1)), re.sub(r"\.(obj|o)$", "", m.group(2)))
+    return re.sub(r"\.(obj|o)$", "", os.path.basename(path))
+
+
+def object_name(section):
+    """.bss.a.19 -> a, .data.zetas -> zetas, .bss -> ''"""
+    m = re.match(r"\.[a-z_]+\.(.+?)(\.\d+)?$", section)
+    return m.group(1) if m else ""
+
+
+def section_column(column, section):
+    """SRAM-resident code/tables get their own column whatever section holds them"""
+    return "ramcode" if section.startswith(RAMCODE_PREFIX) else column
+
+
+def parse_map(lines):
+    """Yield (column, module, input_section, size) for RAM input sections."""
+    in_map = False
+    column = None
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+
+        m = OUTPUT_RE.match(line)
+        if m:
+            column = RAM_SECTIONS.get(m.group(1))
+            pending = None
+            continue
+        if column is None:
+            continue
+
+        if pending:
+            m = ADDR_RE.match(line)
+            if m:
+                yield section_column(column, pending), module_name(m.group(3)), pending, \
+                    int(m.group(2), 16)
+            pending = None
+            continue
+
+        m = INPUT_RE.match(line)
+        if m:
+            if m.group(1) != "*fill*" and int(m.group(3), 16):
+                yield section_column(column, m.group(1)), module_name(m.group(4)), m.group(1), \
+                    int(m.group(3), 16)
+            continue
+        m = NAME_ONLY_RE.match(line)
+        if m and not m.group(1).startswith("*"):
+            pending = m.group(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("map", help="GNU ld map file")
+    ap.add_argument("--top", type=int, default=10,
+                    help="also list the N largest objects (default: %(default)s, 0 to skip)")
+    ap.add_argument("--csv", help="write the per-module table as CSV")
+    args = ap.parse_args()
+
+    with open(args.map, errors="replace") as f:
+        entries = list(parse_map(f))
+    if not entries:
+        sys.exit("no RAM sections found in %s (not a GNU ld map?)" % args.map)
+
+    modules = defaultdict(lambda: dict.fromkeys(COLUMNS, 0))
+    for column, module, _, size in entries:
+        modules[module][column] += size
+    rows = sorted(modules.items(), key=lambda kv: -sum(kv[1].values()))
+    totals = {c: sum(v[c] for v in modules.values()) for c in COLUMNS}
+
+    print("%-40s %8s %8s %8s %8s %8s" % (("module",) + COLUMNS + ("total",)))
+    for module, v in rows:
+        print("%-40s %8d %8d %8d %8d %8d" % ((module,) + tuple(v[c] for c in COLUMNS) +
+                                             (sum(v.values()),)))
+    print("%-40s %8d %8d %8d %8d %8d" % (("TOTAL",) + tuple(totals[c] for c in COLUMNS) +
+                                         (sum(totals.values()),)))
+
+    if args.top:
+        print("\nlargest objects:")
+        for column, module, section, size in sorted(entries, key=lambda e: -e[3])[:args.top]:
+            print("  %7d  %-7s %-28s %s" % (size, column, module, object_name(section) or section))
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(("module",) + COLUMNS + ("total",))
+            for module, v in rows:
+                w.writerow((module,) + tuple(v[c] for c in COLUMNS) + (sum(v.values()),))
+        print("\nwrote %s" % args.csv)
+
+
+if __name__ == "__main__":
+    main()
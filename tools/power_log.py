@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+"""Energy per operation from paired Pico and INA219 (Arduino) serial logs.
+
+The power harnesses (test_kyber_poe_*.c, test_kyber_fgpt.c) print a batch
+marker, raise SIGNAL_PIN, run NTESTS operations and drop the pin:
+
+    NTESTS = 1000
+    --- ENCAP batch start ---
+    --- ENCAP batch end ---
+
+Arduino_test_file.ino starts integrating on the rising edge and prints
+"Measurement started", Voltage/Current/Power rows every ~100 ms and
+"Measurement stopped. Total energy (mWh): X" on the falling edge. This tool
+matches every Pico batch with its measurement and reports energy per
+operation, per batch and per variant:
+
+    python3 tools/power_log.py single_k3.log:single_k3.ino.log:Kyber_singlecore_poe:3 \\
+        multi_k3.log:multi_k3.ino.log:Kyber_multicore_poe:3 --csv energy.csv
+
+Each run is PICO_LOG:ARDUINO_LOG, optionally followed by :VARIANT:K when
+the Pico log does not say (the poe harnesses print neither; test_kyber_fgpt
+prints "variant = ..." and "kyber_k = ..."). Runs of the same variant, K
+and operation are pooled.
+
+Alignment: when both logs carry host timestamps (captured with e.g.
+"ts", grabserial or the Arduino IDE's "Show timestamp"; the forms
+"[12.345] ", "12:34:56.789 -> " and "2026-01-02 12:34:56.789 " are
+understood) each batch goes to the measurement whose rising edge is
+closest to its start marker, within --tolerance seconds after shifting the
+Pico clock by --offset. Batches and measurements whose durations disagree
+are reported. Without timestamps they are paired in order.
+
+Energy per batch is the sketch's own total by default, which is printed
+with 0.001 mWh (3.6 mJ) resolution; --energy samples uses the mean of the
+power rows times the timestamped pulse length instead. A KEM batch (keygen,
+encaps and decaps per iteration, test_kyber_fgpt) is split over the three
+operations in proportion to the log's "# ENERGY" estimate when it has one.
+
+The 95% interval is over batches when a variant has two or more, otherwise
+over the power rows of its single batch. The CSV uses the column layout of
+the timing harness's BENCH CSV block, in uJ instead of us. Synthetic
+fixture logs in tools/fixtures/power/ exercise every path offline:
+
+    python3 tools/power_log.py $(cat tools/fixtures/power/runs.txt)
+"""
+
+import argparse
+import csv
+import datetime
+import math
+import re
+import statistics
+import sys
+from collections import defaultdict
+
+from energy_model import parse_energy
+from variant_bench import t_quantile
+
+META_FIELDS = ("variant", "kyber_k", "clock_khz", "compiler", "cflags")
+CSV_FIELDS = META_FIELDS + ("op", "n", "mean_uj", "stddev_uj", "min_uj", "p50_uj", "p90_uj",
+                            "p99_uj", "max_uj", "ci95_lo_uj", "ci95_hi_uj")
+BATCH_OPS = {"KEYGEN": "keygen", "ENCAP": "encaps", "DECAP": "decaps", "KEM": "kem"}
+OP_ORDER = ("keygen", "encaps", "decaps", "kem")
+# ENERGY block op names -> timing harness op names
+MODEL_OPS = {"keygen": "keygen", "enc": "encaps", "dec": "decaps"}
+DEFAULT_CLOCK_KHZ = 150000
+
+TS_SECONDS = re.compile(r"^\[\s*(\d+(?:\.\d+)?)[^\]]*\]\s?(.*)$")
+TS_DATETIME = re.compile(r"^(\d{4}-\d\d-\d\d)[T ](\d\d:\d\d:\d\d(?:\.\d+)?)\s*(?:->\s?)?(.*)$")
+TS_CLOCK = re.compile(r"^(\d\d):(\d\d):(\d\d(?:\.\d+)?)\s*(?:->\s?)?(.*)$")
+
+BATCH = re.compile(r"^---\s*(\w+)\s+batch\s+(start|end)\s*---$", re.I)
+NTESTS = re.compile(r"^NTESTS\s*=\s*(\d+)")
+META = re.compile(r"^(variant|kyber_k|clock_khz)\s*=\s*(\S+)")
+RIG_START = "Measurement started"
+RIG_STOP = re.compile(r"Measurement stopped\. Total energy \(mWh\):\s*([-+0-9.eE]+)")
+RIG_ROW = re.compile(r"^([-+0-9.]+)\s+([-+0-9.]+)\s+([-+0-9.]+)$")
+
+
+def split_timestamp(line):
+    """(seconds or None, text) for one serial log line."""
+    m = TS_SECONDS.match(line)
+    if m:
+        return float(m.group(1)), m.group(2)
+    m = TS_DATETIME.match(line)
+    if m:
+        t = datetime.datetime.fromisoformat("%s %s" % (m.group(1), m.group(2)))
+        return t.timestamp(), m.group(3)
+    m = TS_CLOCK.match(line)
+    if m:
+        return int(m.group(1)) * 3600 + int(m.group(2)) * 60 + float(m.group(3)), m.group(4)
+    return None, line
+
+
+def lines_of(path):
+    with open(path, errors="replace") as f:
+        for raw in f:
+            t, text = split_timestamp(raw.strip("\r\n").strip())
+            yield t, text.strip()
+
+
+def parse_pico(path):
+    """Batches and build metadata of a Pico serial log."""
+    meta = {"clock_khz": "", "compiler": "", "cflags": ""}
+    batches, cur, n = [], None, None
+    text = []
+    for t, line in lines_of(path):
+        text.append(line)
+        m = NTESTS.match(line)
+        if m:
+            n = int(m.group(1))
+            continue
+        m = META.match(line)
+        if m:
+            meta[m.group(1)] = m.group(2)
+            continue
+        m = BATCH.match(line)
+        if not m:
+            continue
+        name, edge = m.group(1).upper(), m.group(2).lower()
+        if edge == "start":
+            cur = {"op": BATCH_OPS.get(name, name.lower()), "n": n, "start": t, "end": None}
+        elif cur is not None and BATCH_OPS.get(name, name.lower()) == cur["op"]:
+            cur["end"] = t
+            if cur["n"] is None:
+                sys.exit("%s: %s batch without an NTESTS line" % (path, cur["op"]))
+            batches.append(cur)
+            cur = None
+
+    # the timing harness block carries the full build metadata
+    joined = "\n".join(text)
+    m = re.search(r"^variant,kyber_k,clock_khz,compiler,cflags,.*\n(.*)$", joined, re.M)
+    if m:
+        row = next(csv.reader([m.group(1)]))
+        meta.update(zip(META_FIELDS, row))
+
+    shares = None
+    energy = parse_energy(joined)
+    if energy:
+        coeffs, rows = energy[-1]
+        if not meta["clock_khz"]:
+            meta["clock_khz"] = str(int(coeffs["clock_khz"]))
+        totals = {MODEL_OPS[r["op"]]: r["est_uj"] for r in rows
+                  if r["part"] == "total" and r["op"] in MODEL_OPS}
+        if totals and sum(totals.values()) > 0:
+            shares = {op: uj / sum(totals.values()) for op, uj in totals.items()}
+    return batches, meta, shares
+
+
+def parse_rig(path):
+    """Measurements of an Arduino log: edges, total and the power rows."""
+    out, cur = [], None
+    for t, line in lines_of(path):
+        if line.startswith(RIG_START):
+            cur = {"start": t, "stop": None, "mj": None, "mw": []}
+            continue
+        if cur is None:
+            continue
+        m = RIG_STOP.search(line)
+        if m:
+            cur["stop"] = t
+            cur["mj"] = float(m.group(1)) * 3600.0
+            out.append(cur)
+            cur = None
+            continue
+        m = RIG_ROW.match(line)
+        if m:
+            cur["mw"].append(float(m.group(3)))
+    return out
+
+
+def align(batches, meas, offset, tolerance, label):
+    """[(batch, measurement)] matched on the rising edge, or in order."""
+    timed = all(b["start"] is not None for b in batches) and all(m["start"] is not None for m in meas)
+    if not timed:
+        if len(batches) != len(meas):
+            sys.exit("%s: %d batches but %d measurements and no timestamps to align them"
+                     % (label, len(batches), len(meas)))
+        return list(zip(batches, meas))
+
+    pairs, used = [], set()
+    for b in batches:
+        t = b["start"] + offset
+        best = min((i for i in range(len(meas)) if i not in used),
+                   key=lambda i: abs(meas[i]["start"] - t), default=None)
+        if best is None or abs(meas[best]["start"] - t) > tolerance:
+            print("%s: no measurement within %.1f s of the %s batch at %.3f; skipped"
+                  % (label, tolerance, b["op"], b["start"]), file=sys.stderr)
+            continue
+        used.add(best)
+        m = meas[best]
+        if b["end"] is not None and m["stop"] is not None:
+            db, dm = b["end"] - b["start"], m["stop"] - m["start"]
+            if abs(db - dm) > max(0.5, 0.2 * dm):
+                print("%s: %s batch lasted %.2f s on the Pico but %.2f s on the rig"
+                      % (label, b["op"], db, dm), file=sys.stderr)
+        pairs.append((b, m))
+    for i in range(len(meas)):
+        if i not in used:
+            print("%s: measurement %d matches no batch" % (label, i), file=sys.stderr)
+    return pairs
+
+
+def batch_energy(m, source):
+    """(mJ, relative half-width of the 95% interval from the power rows)."""
+    rel = None
+    if len(m["mw"]) >= 2:
+        mean = statistics.fmean(m["mw"])
+        if mean > 0:
+            rel = t_quantile(0.975, len(m["mw"]) - 1) * statistics.stdev(m["mw"]) / (
+                math.sqrt(len(m["mw"])) * mean)
+    if source == "samples":
+        if m["start"] is None or m["stop"] is None or not m["mw"]:
+            sys.exit("--energy samples needs timestamped Arduino logs with power rows")
+        return statistics.fmean(m["mw"]) * (m["stop"] - m["start"]), rel
+    return m["mj"], rel
+
+
+def percentile(sorted_vals, p):
+    k = (len(sorted_vals) - 1) * p / 100.0
+    lo = math.floor(k)
+    hi = min(lo + 1, len(sorted_vals) - 1)
+    return sorted_vals[lo] + (sorted_vals[hi] - sorted_vals[lo]) * (k - lo)
+
+
+def summarize(key, recs):
+    """One BENCH CSV style row from the batches of one variant/K/op."""
+    vals = sorted(r["uj"] for r in recs)
+    n = sum(r["n"] for r in recs)
+    mean = sum(r["uj"] * r["n"] for r in recs) / n
+    sd = statistics.stdev(vals) if len(vals) >= 2 else 0.0
+    if len(vals) >= 2:
+        half = t_quantile(0.975, len(vals) - 1) * sd / math.sqrt(len(vals))
+    elif recs[0]["rel"] is not None:
+        half = mean * recs[0]["rel"]
+    else:
+        half = float("nan")
+    row = dict(zip(META_FIELDS, key[:5]))
+    row.update({"op": key[5], "n": n, "mean_uj": mean, "stddev_uj": sd,
+                "min_uj": vals[0], "p50_uj": percentile(vals, 50), "p90_uj": percentile(vals, 90),
+                "p99_uj": percentile(vals, 99), "max_uj": vals[-1],
+                "ci95_lo_uj": mean - half, "ci95_hi_uj": mean + half})
+    return row
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("runs", nargs="+", help="PICO_LOG:ARDUINO_LOG[:VARIANT:K]")
+    ap.add_argument("--offset", type=float, default=0.0,
+                    help="seconds added to the Pico timestamps (default: %(default)s)")
+    ap.add_argument("--tolerance", type=float, default=5.0,
+                    help="max start-edge distance in seconds (default: %(default)s)")
+    ap.add_argument("--energy", choices=("total", "samples"), default="total",
+                    help="sketch total or mean power rows x pulse length (default: %(default)s)")
+    ap.add_argument("--clock-khz", type=int, default=DEFAULT_CLOCK_KHZ,
+                    help="clk_sys for logs that do not print it (default: %(default)s)")
+    ap.add_argument("--csv", help="write the per-operation table as CSV")
+    args = ap.parse_args()
+
+    batch_rows = []
+    groups = defaultdict(list)
+    for spec in args.runs:
+        parts = spec.split(":")
+        if len(parts) not in (2, 4):
+            sys.exit("%s: expected PICO_LOG:ARDUINO_LOG[:VARIANT:K]" % spec)
+        batches, meta, shares = parse_pico(parts[0])
+        if len(parts) == 4:
+            meta["variant"], meta["kyber_k"] = parts[2], parts[3]
+        if "variant" not in meta or "kyber_k" not in meta:
+            sys.exit("%s: the log has no variant/kyber_k; append :VARIANT:K" % spec)
+        meta["clock_khz"] = meta["clock_khz"] or str(args.clock_khz)
+        key = tuple(meta[f] for f in META_FIELDS)
+
+        for b, m in align(batches, parse_rig(parts[1]), args.offset, args.tolerance, parts[0]):
+            mj, rel = batch_energy(m, args.energy)
+            dur = m["stop"] - m["start"] if m["start"] is not None and m["stop"] is not None else None
+            batch_rows.append((meta["variant"], meta["kyber_k"], b["op"], b["n"], mj, dur,
+                               statistics.fmean(m["mw"]) if m["mw"] else float("nan")))
+            split = {b["op"]: 1.0}
+            if b["op"] == "kem" and shares:
+                split.update(shares)
+            for op, share in split.items():
+                groups[key + (op,)].append({"n": b["n"], "uj": 1000.0 * mj * share / b["n"],
+                                            "rel": rel})
+
+    if not groups:
+        sys.exit("no batches matched a measurement")
+
+    print("%-24s %-2s %-7s %7s %12s %9s %9s" % ("variant", "K", "batch", "n", "energy_mJ",
+                                                 "dur_s", "mean_mW"))
+    for variant, k, op, n, mj, dur, mw in batch_rows:
+        print("%-24s %-2s %-7s %7d %12.3f %9s %9.2f" % (variant, k, op, n, mj,
+                                                         "%.3f" % dur if dur is not None else "-", mw))
+
+    order = sorted(groups, key=lambda g: (int(g[1]), OP_ORDER.index(g[5]) if g[5] in OP_ORDER else 99,
+                                          g[5], g[0]))
+    rows = [summarize(g, groups[g]) for g in order]
+
+    print("\n%-24s %-2s %-7s %7s %12s  %-25s %s" % ("variant", "K", "op", "n", "uJ/op",
+                                                     "95% CI", "batches"))
+    for g, r in zip(order, rows):
+        print("%-24s %-2s %-7s %7d %12.2f  [%10.2f, %10.2f]  %d" % (
+            r["variant"], r["kyber_k"], r["op"], r["n"], r["mean_uj"],
+            r["ci95_lo_uj"], r["ci95_hi_uj"], len(groups[g])))
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+            w.writeheader()
+            for r in rows:
+                w.writerow({k: ("%.2f" % v if isinstance(v, float) else v) for k, v in r.items()})
+        print("\nwrote %s" % args.csv)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Predict the power-policy operating points from a profiled run.
+
+Host side of Kyber_multicore_fgpt/powerpolicy.h. It reads the "# ENERGY"
+and "# SCHED" blocks of a test_kyber_fgpt serial log (a run at the default
+clock with core1 in use). For every KEM operation and every candidate
+(clock, core voltage, core1 on/off) it predicts time and energy with the
+same model as the device:
+
+    time   = profiled cycles / f; without core1 the work of both cores back
+             to back, minus the launch/reset hand-off
+    energy = base_mw * time + core increments * active time, the increments
+             scaled by f / f_log and (V / V_fit)^2
+
+Then it picks the point of each preset:
+
+    python3 tools/power_policy.py k2.log
+    python3 tools/power_policy.py k2.log --deadline-ms 20 --all
+    python3 tools/power_policy.py k2.log --base 60 --core 18 \\
+        --points 48000:950 96000:1000 150000:1100 200000:1150
+
+The coefficients default to the ones the log was run with. When the log
+also has the device's own "# POWER POLICY" block and no input is
+overridden, each choice is checked against it. The log prints its inputs
+rounded to 0.01 us, so a near-tie can go the other way; those rows say
+"differs" and show the device's point.
+"""
+
+import argparse
+import sys
+
+from energy_model import parse_energy
+
+DEFAULT_POINTS = ("48000:950", "64000:950", "96000:1000", "120000:1050", "150000:1100")
+PRESETS = ("min-latency", "min-energy", "deadline")
+OPS = ("keygen", "enc", "dec")
+SCHED_HEADER = "# SCHED"
+POLICY_HEADER = "# POWER POLICY"
+
+
+def csv_block(text, header):
+    """Rows (as dicts) of the first CSV table after a '# NAME' line."""
+    lines = [l.strip("\r").strip() for l in text.splitlines()]
+    if header not in lines:
+        return []
+    i = lines.index(header) + 1
+    fields, rows = None, []
+    while i < len(lines) and lines[i] and not lines[i].startswith("#"):
+        cells = lines[i].split(",")
+        if fields is None:
+            fields = cells
+        elif len(cells) == len(fields):
+            rows.append(dict(zip(fields, cells)))
+        else:
+            break
+        i += 1
+    return rows
+
+
+def workloads(text):
+    """The log's coefficients, and per op (wall_us, core0_us, core1_us, serial_us)."""
+    blocks = parse_energy(text)
+    if not blocks:
+        sys.exit("no ENERGY block in the log")
+    coeffs, rows = blocks[0]
+
+    handoff = {op: 0.0 for op in OPS}
+    for r in csv_block(text, SCHED_HEADER):
+        if r["op"] in handoff and r["phase"] != "total":
+            handoff[r["op"]] += float(r["launch_us"]) + float(r["reset_us"])
+
+    out = {}
+    for r in rows:
+        if r["op"] in OPS and r["part"] == "total":
+            a0, a1 = r["core0_active_us"], r["core1_active_us"]
+            out[r["op"]] = (r["wall_us"], a0, a1, a0 + a1 - handoff[r["op"]])
+    return coeffs, out
+
+
+def predict(work, clock_khz, khz, mv, core1, base, core0, core1_mw, fit_mv):
+    wall, a0, a1, serial = work
+    ratio = clock_khz / khz
+    scale = khz / clock_khz * (mv / fit_mv) ** 2
+    if core1:
+        t, a0, a1 = wall * ratio, a0 * ratio, a1 * ratio
+    else:
+        t = serial * ratio
+        a0, a1 = t, 0.0
+    return t, (base * t + scale * (core0 * a0 + core1_mw * a1)) / 1000.0
+
+
+def choose(cands, preset, deadline_us):
+    fastest = min(cands, key=lambda c: c["us"])
+    if preset == "min-latency":
+        return fastest, True
+    ok = [c for c in cands if preset != "deadline" or c["us"] <= deadline_us]
+    if not ok:
+        return fastest, False
+    return min(ok, key=lambda c: c["uj"]), True
+
+
+def fmt(c):
+    return "%d kHz %d mV core1=%s" % (c["khz"], c["mv"], "on" if c["core1"] else "off")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", help="serial log of test_kyber_fgpt")
+    ap.add_argument("--deadline-ms", type=float,
+                    help="per-operation deadline (default: the log's, or 50 ms)")
+    ap.add_argument("--points", nargs="+", default=DEFAULT_POINTS,
+                    help="candidate KHZ:MV points (default: POWER_POINTS)")
+    ap.add_argument("--base", type=float, help="base_mw (default: the log's)")
+    ap.add_argument("--core", type=float, help="shared core increment in mW at the log's clock")
+    ap.add_argument("--fit-mv", type=float, default=1100.0,
+                    help="core voltage of the coefficients (default: %(default)s)")
+    ap.add_argument("--all", action="store_true", help="print every candidate")
+    args = ap.parse_args()
+
+    with open(args.log, errors="replace") as f:
+        text = f.read()
+    coeffs, work = workloads(text)
+    clock_khz = coeffs["clock_khz"]
+    base = coeffs["base_mw"] if args.base is None else args.base
+    core0 = coeffs["core0_mw"] if args.core is None else args.core
+    core1 = coeffs["core1_mw"] if args.core is None else args.core
+
+    device = {(r["preset"], r["op"]): r for r in csv_block(text, POLICY_HEADER)}
+    if args.deadline_ms is not None:
+        deadline_us = args.deadline_ms * 1000.0
+    elif device:
+        deadline_us = float(next(iter(device.values()))["deadline_us"])
+    else:
+        deadline_us = 50000.0
+
+    # the device's choices only compare under the same inputs
+    same_inputs = (args.base is None and args.core is None and args.fit_mv == 1100.0 and
+                   tuple(args.points) == DEFAULT_POINTS and
+                   (args.deadline_ms is None or not device or
+                    float(next(iter(device.values()))["deadline_us"]) == deadline_us))
+
+    points = []
+    for p in args.points:
+        khz, _, mv = p.partition(":")
+        points.append((int(khz), int(mv)))
+
+    print("profile at %d kHz: base_mw=%.3f core0_mw=%.3f core1_mw=%.3f, deadline %.0f us" %
+          (clock_khz, base, core0, core1, deadline_us))
+
+    for op in OPS:
+        if op not in work:
+            continue
+        cands = []
+        for khz, mv in points:
+            for c1 in (1, 0):
+                us, uj = predict(work[op], clock_khz, khz, mv, c1, base, core0, core1, args.fit_mv)
+                cands.append({"khz": khz, "mv": mv, "core1": c1, "us": us, "uj": uj})
+
+        print("\n%s" % op)
+        if args.all:
+            print("  %8s %6s %5s %12s %12s" % ("khz", "mv", "core1", "pred_us", "pred_uj"))
+            for c in cands:
+                print("  %8d %6d %5d %12.2f %12.2f" % (c["khz"], c["mv"], c["core1"], c["us"], c["uj"]))
+
+        for preset in PRESETS:
+            best, met = choose(cands, preset, deadline_us)
+            line = "  %-12s %-32s %12.2f us %12.2f uJ%s" % (
+                preset, fmt(best), best["us"], best["uj"], "" if met else "  (misses deadline)")
+            dev = device.get((preset, op)) if same_inputs else None
+            if dev:
+                same = (int(dev["clock_khz"]), int(dev["mv"]), int(dev["core1"])) == \
+                       (best["khz"], best["mv"], best["core1"])
+                line += "  device: %s" % ("agrees" if same else "differs (%s kHz %s mV core1=%s)" % (
+                    dev["clock_khz"], dev["mv"], dev["core1"]))
+            print(line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Extract a per-core Chrome trace from a Kyber_multicore_fgpt serial log.
+
+The firmware, built with -DKYBER_TRACE=ON, prints the trace between the lines
+"=== TRACE JSON BEGIN ===" and "=== TRACE JSON END ===". This script pulls
+that block out of a captured log (file or stdin), writes it as a standalone
+trace file, prints a per-core busy/wait summary and can open it in the
+Perfetto UI.
+
+    python3 tools/trace_to_perfetto.py minicom.log -o kyber_trace.json --open
+"""
+
+import argparse
+import http.server
+import json
+import os
+import sys
+import threading
+import urllib.parse
+import webbrowser
+from collections import defaultdict
+
+BEGIN = "=== TRACE JSON BEGIN ==="
+END = "=== TRACE JSON END ==="
+PERFETTO_UI = "https://ui.perfetto.dev"
+# Perfetto's UI is allowed to fetch traces from this origin
+SERVE_PORT = 9001
+
+
+def extract_traces(text):
+    """Return every trace JSON block found in the log, in order."""
+    traces = []
+    block = None
+    for line in text.splitlines():
+        line = line.strip("\r")
+        if line.strip() == BEGIN:
+            block = []
+        elif line.strip() == END and block is not None:
+            traces.append(json.loads("\n".join(block)))
+            block = None
+        elif block is not None:
+            block.append(line)
+    return traces
+
+
+def summarize(trace, out=sys.stdout):
+    """Print total time per core and category, and the largest idle gaps."""
+    events = [e for e in trace["traceEvents"] if e.get("ph") == "X"]
+    if not events:
+        print("no events in trace", file=out)
+        return
+
+    per_core = defaultdict(lambda: defaultdict(int))
+    per_name = defaultdict(lambda: [0, 0])
+    for e in events:
+        per_core[e["tid"]][e.get("cat", "")] += e["dur"]
+        per_name[(e["tid"], e["name"])][0] += e["dur"]
+        per_name[(e["tid"], e["name"])][1] += 1
+
+    start = min(e["ts"] for e in events)
+    end = max(e["ts"] + e["dur"] for e in events)
+    print("window: %d us" % (end - start), file=out)
+
+    for tid in sorted(per_core):
+        cats = per_core[tid]
+        print("core%d: job %d us, wait %d us, sync %d us" % (
+            tid, cats.get("job", 0), cats.get("wait", 0), cats.get("sync", 0)), file=out)
+
+    print("\ncore,event,count,total_us,avg_us", file=out)
+    for (tid, name), (total, count) in sorted(per_name.items()):
+        print("%d,%s,%d,%d,%.1f" % (tid, name, count, total, total / count), file=out)
+
+    other = trace.get("otherData", {})
+    dropped = [other.get("dropped_core0", 0), other.get("dropped_core1", 0)]
+    if any(dropped):
+        print("\nring overflow: oldest %d (core0) / %d (core1) events were overwritten"
+              % tuple(dropped), file=out)
+
+
+class _CorsHandler(http.server.SimpleHTTPRequestHandler):
+    def end_headers(self):
+        self.send_header("Access-Control-Allow-Origin", PERFETTO_UI)
+        self.send_header("Cache-Control", "no-cache")
+        super().end_headers()
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def open_in_perfetto(path):
+    """Serve the trace once on localhost and point the Perfetto UI at it."""
+    directory, name = os.path.split(os.path.abspath(path))
+
+    def handler(*args, **kwargs):
+        return _CorsHandler(*args, directory=directory, **kwargs)
+
+    httpd = http.server.ThreadingHTTPServer(("127.0.0.1", SERVE_PORT), handler)
+    url = "http://127.0.0.1:%d/%s" % (SERVE_PORT, urllib.parse.quote(name))
+    threading.Thread(target=httpd.serve_forever, daemon=True).start()
+    webbrowser.open("%s/#!/?url=%s" % (PERFETTO_UI, url))
+    print("serving %s for Perfetto; press Ctrl-C when the trace has loaded" % url)
+    try:
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        httpd.shutdown()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", help="serial log captured from the board, or - for stdin")
+    ap.add_argument("-o", "--output", default="kyber_trace.json",
+                    help="trace file to write (default: %(default)s)")
+    ap.add_argument("--index", type=int, default=-1,
+                    help="which dump to use when the log holds several (default: last)")
+    ap.add_argument("--open", action="store_true",
+                    help="open the trace in the Perfetto UI")
+    ap.add_argument("-q", "--quiet", action="store_true", help="skip the summary")
+    args = ap.parse_args()
+
+    if args.log == "-":
+        text = sys.stdin.read()
+    else:
+        with open(args.log, errors="replace") as f:
+            text = f.read()
+
+    traces = extract_traces(text)
+    if not traces:
+        sys.exit("no trace found (was the firmware built with -DKYBER_TRACE=ON?)")
+
+    trace = traces[args.index]
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    print("wrote %s (%d events)" % (args.output, len(trace["traceEvents"])))
+
+    if not args.quiet:
+        summarize(trace)
+    if args.open:
+        open_in_perfetto(args.output)
+
+
+if __name__ == "__main__":
+    main()
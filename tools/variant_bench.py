@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+"""A/B benchmark of the Kyber variant directories.
+
+Builds every variant (Kyber_singlecore, Kyber_multicore, the _fgpt, _rut and
+_poe copies) for K=2/3/4 with test_kyber_separate_deviations.c as the
+harness, runs them, and compares each variant against a baseline variant
+(default Kyber_singlecore). The comparison uses per-operation
+keygen/encaps/decaps samples and reports the speed-up (baseline mean /
+variant mean) with a 95% confidence interval. Variants that are
+significantly slower than the baseline by more than --threshold percent
+are flagged as regressions.
+
+The default execution target is the native pthread build (host_shim/,
+-DKYBER_HOST=ON), where core1 is a second thread:
+
+    python3 tools/variant_bench.py run -o samples.csv
+
+Board numbers go through the same analysis. Build each variant with
+-DKYBER_HARNESS=test_kyber_separate_deviations.c -DKYBER_K=<k>, capture
+the serial logs, and pass them in:
+
+    python3 tools/variant_bench.py analyze singlecore_k3.log multicore_k3.log
+
+"analyze" accepts serial logs (the BENCH SAMPLES blocks are pulled out) and
+sample CSVs written by "run -o", in any mix. --against OLD compares a run
+with an earlier one, variant by variant, to catch regressions over time.
+The exit status is 2 when any regression is flagged.
+"""
+
+import argparse
+import csv
+import glob
+import math
+import os
+import random
+import re
+import statistics
+import subprocess
+import sys
+from collections import defaultdict
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HARNESS = "test_kyber_separate_deviations.c"
+SAMPLES_BEGIN = "=== BENCH SAMPLES BEGIN ==="
+SAMPLES_END = "=== BENCH SAMPLES END ==="
+SAMPLE_FIELDS = ["variant", "kyber_k", "clock_khz", "compiler", "cflags", "op", "iter", "us"]
+OPS = ("keygen", "encaps", "decaps")
+
+
+# ---------------------------------------------------------------- samples
+
+def parse_samples(text, run=0):
+    """Yield sample rows from every BENCH SAMPLES block in a serial log."""
+    block = None
+    for line in text.splitlines():
+        line = line.strip("\r")
+        if line.strip() == SAMPLES_BEGIN:
+            block = []
+        elif line.strip() == SAMPLES_END and block is not None:
+            for row in csv.DictReader(block):
+                row["run"] = run
+                yield row
+            block = None
+        elif block is not None:
+            block.append(line)
+
+
+def load_samples(paths):
+    """Load samples from logs and/or CSVs into {(variant, k, op): [us, ...]}."""
+    samples = defaultdict(list)
+    for run, path in enumerate(paths):
+        with open(path, errors="replace") as f:
+            text = f.read()
+        if text.startswith(",".join(SAMPLE_FIELDS)):
+            rows = csv.DictReader(text.splitlines())
+        else:
+            rows = parse_samples(text, run)
+        for row in rows:
+            key = (row["variant"], int(row["kyber_k"]), row["op"])
+            samples[key].append(float(row["us"]))
+    return samples
+
+
+# ---------------------------------------------------------------- statistics
+
+def t_quantile(p, df):
+    """Student t quantile; Cornish-Fisher expansion around the normal one."""
+    z = statistics.NormalDist().inv_cdf(p)
+    if math.isinf(df):
+        return z
+    g1 = (z ** 3 + z) / 4
+    g2 = (5 * z ** 5 + 16 * z ** 3 + 3 * z) / 96
+    g3 = (3 * z ** 7 + 19 * z ** 5 + 17 * z ** 3 - 15 * z) / 384
+    return z + g1 / df + g2 / df ** 2 + g3 / df ** 3
+
+
+def speedup_welch(a, b, level=0.95):
+    """Speed-up mean(a)/mean(b) with a Welch CI on the log scale (delta method)."""
+    ma, mb = statistics.fmean(a), statistics.fmean(b)
+    va = statistics.variance(a) / (len(a) * ma * ma)
+    vb = statistics.variance(b) / (len(b) * mb * mb)
+    se = math.sqrt(va + vb)
+    if se == 0:
+        return ma / mb, ma / mb, ma / mb
+    df = (va + vb) ** 2 / (va * va / (len(a) - 1) + vb * vb / (len(b) - 1))
+    t = t_quantile(0.5 + level / 2, df)
+    r = math.log(ma / mb)
+    return ma / mb, math.exp(r - t * se), math.exp(r + t * se)
+
+
+def speedup_bootstrap(a, b, level=0.95, reps=2000, seed=1):
+    """Speed-up mean(a)/mean(b) with a percentile bootstrap CI."""
+    rng = random.Random(seed)
+    na, nb = len(a), len(b)
+    ratios = sorted(
+        statistics.fmean(rng.choices(a, k=na)) / statistics.fmean(rng.choices(b, k=nb))
+        for _ in range(reps))
+    lo = ratios[int((1 - level) / 2 * reps)]
+    hi = ratios[min(reps - 1, int((1 + level) / 2 * reps))]
+    return statistics.fmean(a) / statistics.fmean(b), lo, hi
+
+
+def verdict(speedup, lo, hi, threshold):
+    """REGRESSION: significantly slower than the reference by more than threshold."""
+    if hi < 1.0 and 1.0 / speedup - 1.0 > threshold:
+        return "REGRESSION"
+    if hi < 1.0:
+        return "slower"
+    if lo > 1.0:
+        return "faster"
+    return "same"
+
+
+def compare(pairs, method, threshold, reps):
+    """pairs: [(k, op, ref_name, ref_samples, name, samples)] -> result rows."""
+    results = []
+    for k, op, ref_name, ref, name, cur in pairs:
+        if len(ref) < 2 or len(cur) < 2:
+            continue
+        if method == "bootstrap":
+            s, lo, hi = speedup_bootstrap(ref, cur, reps=reps)
+        else:
+            s, lo, hi = speedup_welch(ref, cur)
+        results.append({
+            "kyber_k": k, "op": op, "reference": ref_name, "variant": name,
+            "n_ref": len(ref), "n_var": len(cur),
+            "mean_ref_us": statistics.fmean(ref), "mean_var_us": statistics.fmean(cur),
+            "speedup": s, "ci95_lo": lo, "ci95_hi": hi, "method": method,
+            "verdict": verdict(s, lo, hi, threshold),
+        })
+    return results
+
+
+def print_results(results, title, out=sys.stdout):
+    print("\n%s" % title, file=out)
+    print("%-3s %-7s %-24s %10s %10s %8s  %-17s %s" % (
+        "K", "op", "variant", "ref_us", "var_us", "speedup", "95% CI", "verdict"), file=out)
+    for r in results:
+        print("%-3d %-7s %-24s %10.1f %10.1f %8.3f  [%6.3f, %6.3f]  %s" % (
+            r["kyber_k"], r["op"], r["variant"], r["mean_ref_us"], r["mean_var_us"],
+            r["speedup"], r["ci95_lo"], r["ci95_hi"], r["verdict"]), file=out)
+
+
+def write_results(results, path):
+    with open(path, "w", newline="") as f:
+        w = csv.DictWriter(f, fieldnames=list(results[0].keys()) if results else ["verdict"])
+        w.writeheader()
+        for r in results:
+            w.writerow(r)
+
+
+def analyze(samples, args, against=None):
+    key_order = lambda key: (key[1], OPS.index(key[2]) if key[2] in OPS else 99, key[0])
+    keys = sorted(samples, key=key_order)
+    results = []
+
+    pairs = []
+    for variant, k, op in keys:
+        ref_key = (args.baseline, k, op)
+        if variant != args.baseline and ref_key in samples:
+            pairs.append((k, op, args.baseline, samples[ref_key], variant, samples[(variant, k, op)]))
+    if pairs:
+        ab = compare(pairs, args.method, args.threshold / 100.0, args.reps)
+        print_results(ab, "A/B against %s (speed-up > 1 means faster than the baseline)"
+                      % args.baseline)
+        results += ab
+    else:
+        print("no %s samples to compare against" % args.baseline)
+
+    if against:
+        pairs = []
+        for variant, k, op in keys:
+            if (variant, k, op) in against:
+                pairs.append((k, op, "previous", against[(variant, k, op)],
+                              variant, samples[(variant, k, op)]))
+        hist = compare(pairs, args.method, args.threshold / 100.0, args.reps)
+        print_results(hist, "Against previous run (speed-up > 1 means faster than before)")
+        results += hist
+
+    if args.results:
+        write_results(results, args.results)
+        print("\nwrote %s" % args.results)
+
+    flagged = [r for r in results if r["verdict"] == "REGRESSION"]
+    if flagged:
+        print("\n%d regression(s) beyond %.1f%%:" % (len(flagged), args.threshold))
+        for r in flagged:
+            print("  K=%d %s %s vs %s: %.1f%% slower" % (
+                r["kyber_k"], r["op"], r["variant"], r["reference"],
+                (1.0 / r["speedup"] - 1.0) * 100))
+        return 2
+    return 0
+
+
+# ---------------------------------------------------------------- host runs
+
+def find_variants():
+    variants = {}
+    for cml in sorted(glob.glob(os.path.join(ROOT, "Kyber_*", "CMakeLists.txt"))):
+        with open(cml) as f:
+            m = re.search(r"^project\((\S+)", f.read(), re.M)
+        if m and os.path.exists(os.path.join(os.path.dirname(cml), HARNESS)):
+            variants[m.group(1)] = os.path.dirname(cml)
+    return variants
+
+
+def build(src, build_dir, target, k, jobs):
+    subprocess.run(["cmake", "-S", src, "-B", build_dir, "-DKYBER_HOST=ON",
+                    "-DKYBER_K=%d" % k, "-DKYBER_HARNESS=" + HARNESS],
+                   check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(["cmake", "--build", build_dir, "--target", target, "-j%d" % jobs],
+                   check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(build_dir, target)
+
+
+def run_host(args):
+    variants = find_variants()
+    names = args.variants or sorted(variants)
+    for name in names:
+        if name not in variants:
+            sys.exit("unknown variant %s (have: %s)" % (name, ", ".join(sorted(variants))))
+    if args.baseline not in names:
+        names.insert(0, args.baseline)
+
+    if (os.cpu_count() or 1) < 2:
+        print("warning: this host has one CPU, so core0 and core1 cannot overlap; "
+              "multicore numbers only show the hand-off overhead", file=sys.stderr)
+
+    exes = {}
+    for k in args.k:
+        for name in names:
+            print("building %s K=%d" % (name, k), file=sys.stderr)
+            exes[(name, k)] = build(variants[name], os.path.join(args.build_dir, "%s-k%d" % (name, k)),
+                                    name, k, args.jobs)
+
+    # Interleave variants round by round so slow drift on the host (thermal,
+    # other load) hits all of them alike instead of biasing one
+    rows = []
+    for rnd in range(args.rounds):
+        for k in args.k:
+            for name in names:
+                print("round %d/%d: %s K=%d" % (rnd + 1, args.rounds, name, k), file=sys.stderr)
+                p = subprocess.run([exes[(name, k)]], capture_output=True, text=True,
+                                   timeout=args.timeout)
+                if p.returncode != 0:
+                    sys.exit("%s K=%d failed (exit %d):\n%s" % (name, k, p.returncode,
+                                                               p.stdout[-2000:]))
+                got = list(parse_samples(p.stdout, rnd))
+                if not got:
+                    sys.exit("%s K=%d printed no BENCH SAMPLES block" % (name, k))
+                rows += got
+
+    if args.output:
+        with open(args.output, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=SAMPLE_FIELDS, extrasaction="ignore")
+            w.writeheader()
+            w.writerows(rows)
+        print("wrote %s (%d samples)" % (args.output, len(rows)), file=sys.stderr)
+
+    samples = defaultdict(list)
+    for row in rows:
+        samples[(row["variant"], int(row["kyber_k"]), row["op"])].append(float(row["us"]))
+    return samples
+
+
+# ---------------------------------------------------------------- main
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument("--baseline", default="Kyber_singlecore",
+                        help="variant the others are compared with (default: %(default)s)")
+    common.add_argument("--method", choices=("welch", "bootstrap"), default="welch",
+                        help="confidence interval for the speed-up (default: %(default)s)")
+    common.add_argument("--reps", type=int, default=2000,
+                        help="bootstrap resamples (default: %(default)s)")
+    common.add_argument("--threshold", type=float, default=5.0,
+                        help="flag significant slow-downs above this many percent "
+                             "(default: %(default)s)")
+    common.add_argument("--against", metavar="OLD",
+                        help="samples or logs of an earlier run to check for regressions")
+    common.add_argument("--results", metavar="CSV", help="write the comparison table as CSV")
+
+    r = sub.add_parser("run", parents=[common], help="build and run every variant on the host")
+    r.add_argument("--variants", nargs="+", help="project names to run (default: all)")
+    r.add_argument("--k", nargs="+", type=int, default=[2, 3, 4], choices=(2, 3, 4))
+    r.add_argument("--rounds", type=int, default=3,
+                   help="interleaved runs per variant; samples are pooled (default: %(default)s)")
+    r.add_argument("--build-dir", default=os.path.join(ROOT, "_variant_build"))
+    r.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1)
+    r.add_argument("--timeout", type=int, default=600, help="per run, in seconds")
+    r.add_argument("-o", "--output", help="write the raw samples as CSV")
+
+    a = sub.add_parser("analyze", parents=[common], help="analyze serial logs or sample CSVs")
+    a.add_argument("inputs", nargs="+")
+
+    args = ap.parse_args()
+
+    if args.cmd == "run":
+        samples = run_host(args)
+    else:
+        samples = load_samples(args.inputs)
+    if not samples:
+        sys.exit("no samples found")
+
+    against = load_samples([args.against]) if args.against else None
+    sys.exit(analyze(samples, args, against))
+
+
+if __name__ == "__main__":
+    main()